@@ -22,18 +22,18 @@
 #include <cassert>
 #include <limits>
 
-#include <boost/endian/conversion.hpp>
+#include "net_ip/component/msg_layout.hpp"
 
 namespace chops {
 namespace example {
 
+// two byte big endian length header
+using var_len_msg_size = chops::net::layout_field<std::uint16_t, 0>;
+using var_len_msg_hdr = chops::net::msg_layout<var_len_msg_size>;
+
 inline std::size_t decode_variable_len_msg_hdr(const std::byte* buf_ptr, std::size_t sz) {
-  assert (sz == 2);
-  std::uint16_t hdr;
-  std::byte* hdr_ptr = static_cast<std::byte*>(static_cast<void*>(&hdr));
-  *(hdr_ptr+0) = *(buf_ptr+0);
-  *(hdr_ptr+1) = *(buf_ptr+1);
-  return boost::endian::big_to_native(hdr);
+  assert (sz == var_len_msg_hdr::size);
+  return chops::net::layout_hdr_decoder<var_len_msg_size>(buf_ptr, sz);
 }
 
 template <typename IOT>
@@ -21,15 +21,29 @@
 #include <system_error>
 #include <cstddef> // std::size_t, std::byte
 #include <utility> // std::forward, std::move
+#include <functional> // std::function
+#include <vector>
+
+#include <experimental/buffer>
 
 #include "utility/shared_buffer.hpp"
 
 #include "net_ip/net_ip_error.hpp"
 #include "net_ip/queue_stats.hpp"
+#include "net_ip/spsc_msg_ring.hpp"
+#include "net_ip/socket_filter.hpp"
+#include "net_ip/packet_ring.hpp"
+#include "net_ip/detail/send_types.hpp"
 
 namespace chops {
 namespace net {
 
+/**
+ *  @brief Largest buffer which can be sent inline, when inline sends are enabled on a 
+ *  TCP IO handler.
+ */
+constexpr std::size_t max_inline_send_size = 64u;
+
 /**
  *  @brief The @c basic_io_interface class template provides access to an underlying 
  *  network IO handler (TCP or UDP IO handler).
@@ -160,19 +174,209 @@ public:
     throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
   }
 
+/**
+ *  @brief Return a sample of kernel TCP connection state, including round trip time,
+ *  congestion window, retransmits, delivery rate, and kernel socket queue sizes.
+ *
+ *  This method is not implemented for UDP IO handlers (only for TCP IO handlers).
+ *
+ *  The sample is taken at the time of the call and is inexpensive (a few system calls), 
+ *  so it can be called periodically, for example to prefer connections with lower round
+ *  trip times or to detect data backing up in the kernel. If the sample cannot be 
+ *  taken all values are zero.
+ *
+ *  @return @c tcp_kernel_stats if network IO handler is available.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  tcp_kernel_stats get_tcp_kernel_stats() const {
+    if (auto p = m_ioh_wptr.lock()) {
+      return p->get_tcp_kernel_stats();
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
+
+/**
+ *  @brief Return kernel receive buffer statistics, implemented only for UDP IO handlers.
+ *
+ *  The statistics include the count of datagrams dropped by the kernel, typically because
+ *  the socket receive buffer was full (see @c udp_rx_stats). If the sample cannot be 
+ *  taken the kernel values are zero.
+ *
+ *  @return @c udp_rx_stats if network IO handler is available.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  udp_rx_stats get_udp_rx_stats() const {
+    if (auto p = m_ioh_wptr.lock()) {
+      return p->get_udp_rx_stats();
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
+
+/**
+ *  @brief Grow the socket receive buffer when the kernel drops datagrams, implemented 
+ *  only for UDP IO handlers.
+ *
+ *  The kernel drop counter is sampled periodically while datagrams are read, whether 
+ *  delivered to a message handler or read into an SPSC message ring (it has no effect 
+ *  when reading from a packet ring). Each time new drops are seen, the receive buffer 
+ *  size is doubled, up to @c max_size. Growing beyond the system @c rmem_max limit 
+ *  requires the @c CAP_NET_ADMIN capability.
+ *
+ *  @param max_size Maximum receive buffer size in bytes (as reported by the kernel), 
+ *  0 turns autotuning off.
+ *
+ *  @return @c true.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  bool enable_rcvbuf_autotune(std::size_t max_size) const {
+    if (auto p = m_ioh_wptr.lock()) {
+      return p->enable_rcvbuf_autotune(max_size);
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
+
+/**
+ *  @brief Enable kernel transmit timestamps, allowing output latency to be measured from
+ *  the time a buffer is handed to the socket until the kernel transmits it.
+ *
+ *  Software transmit timestamps are read from the socket error queue (Linux only). 
+ *  The resulting statistics are available through @c get_output_latency_stats.
+ *
+ *  Timestamps are enabled from within the IO handler executor, so this is a non-blocking 
+ *  call. If they are not supported by the platform or socket, the error is reported 
+ *  through the net entity error callback.
+ *
+ *  @return @c true.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  bool enable_tx_timestamps() const {
+    if (auto p = m_ioh_wptr.lock()) {
+      return p->enable_tx_timestamps();
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
+
+/**
+ *  @brief Enable fragmentation of large buffers, implemented only for TCP IO handlers.
+ *
+ *  Without fragmentation a large buffer is written in its entirety before any buffer 
+ *  queued after it. With fragmentation enabled, buffers larger than the fragment size 
+ *  are written in fragment size slices, each passed through the encoder, and a queued 
+ *  buffer is written between consecutive slices. Slices of multiple large buffers are
+ *  written in round-robin order. This keeps small messages responsive on a connection 
+ *  shared with bulk transfers, for protocols which support multiplexed frames.
+ *
+ *  This method must be called before @c start_io.
+ *
+ *  @param frag_size Maximum number of buffer bytes in one fragment.
+ *
+ *  @param enc A @c fragment_encoder function object.
+ *
+ *  @return @c false if IO processing has already started or the fragment size is zero,
+ *  otherwise @c true.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  bool enable_fragmentation(std::size_t frag_size, fragment_encoder enc) const {
+    if (auto p = m_ioh_wptr.lock()) {
+      return p->enable_fragmentation(frag_size, std::move(enc));
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
+
+/**
+ *  @brief Enable inline sends of small buffers, implemented only for TCP IO handlers.
+ *
+ *  Small messages (heartbeats, acks, ticks) are dominated by the cost of allocating a
+ *  reference counted buffer and queueing it. With inline sends enabled, a @c send of a 
+ *  pointer and size no larger than @c max_size carries the bytes inline in the posted 
+ *  function object, and the IO handler appends them to a per connection staging 
+ *  buffer. The staging buffer is written as one buffer when no other write is in 
+ *  progress, so small messages sent while a write is in progress are coalesced. Buffers
+ *  keep their send order. Staged bytes are not included in the output queue stats.
+ *
+ *  This method must be called before @c start_io.
+ *
+ *  @param max_size Largest buffer size sent inline, at most @c max_inline_send_size.
+ *
+ *  @return @c false if IO processing has already started or the size is zero or too 
+ *  large, otherwise @c true.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  bool enable_inline_sends(std::size_t max_size = max_inline_send_size) const {
+    if (auto p = m_ioh_wptr.lock()) {
+      return p->enable_inline_sends(max_size);
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
+
+/**
+ *  @brief Attach a classic BPF socket filter, implemented only for UDP IO handlers.
+ *
+ *  Datagrams rejected by the filter are dropped in the kernel and never reach the
+ *  message handler. The filter is kept by the IO handler and re-attached if the UDP 
+ *  entity is stopped and started again. An empty filter removes a previously attached 
+ *  filter. Functions to build filters are in @c socket_filter.hpp.
+ *
+ *  @param filt The @c socket_filter.
+ *
+ *  The filter is attached from within the socket executor, and if it cannot be 
+ *  attached the error callback is invoked. A filter is refused while IO is started with
+ *  @c start_io_packet_ring.
+ *
+ *  @return @c false if reading from a packet ring, otherwise @c true.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  bool set_socket_filter(socket_filter filt) const {
+    if (auto p = m_ioh_wptr.lock()) {
+      return p->set_socket_filter(std::move(filt));
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
+
+/**
+ *  @brief Return output latency statistics accumulated from kernel transmit timestamps.
+ *
+ *  @return @c output_latency_stats if network IO handler is available.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  output_latency_stats get_output_latency_stats() const {
+    if (auto p = m_ioh_wptr.lock()) {
+      return p->get_output_latency_stats();
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
+
 /**
  *  @brief Send a buffer of data through the associated network IO handler.
  *
  *  The data is copied once into an internal reference counted buffer and then
  *  managed within the IO handler. This is a non-blocking call.
  *
+ *  If inline sends are enabled on a TCP IO handler and the buffer is small enough, the 
+ *  data is instead carried inline to the IO handler and copied into its staging buffer, 
+ *  with no reference counted buffer allocated (see @c enable_inline_sends).
+ *
  *  @param buf Pointer to buffer.
  *
  *  @param sz Size of buffer.
  *
  *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
  */
-  void send(const void* buf, std::size_t sz) const { send(chops::const_shared_buffer(buf, sz)); }
+  void send(const void* buf, std::size_t sz) const {
+    if (auto p = m_ioh_wptr.lock()) {
+      p->send(buf, sz);
+      return;
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
 
 /**
  *  @brief Send a reference counted buffer through the associated network IO handler.
@@ -256,6 +460,51 @@ public:
     throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
   }
 
+/**
+ *  @brief Send a reference counted buffer to many destination endpoints, implemented only 
+ *  for UDP IO handlers.
+ *
+ *  One function object is posted for all of the destinations, and the datagrams are 
+ *  handed to the kernel in batches with @c sendmmsg (Linux only) without copying the 
+ *  buffer or queueing an element per destination. If a write is already in progress, 
+ *  the buffer and destinations are queued as one element and sent in batches when it 
+ *  reaches the head of the queue. If the socket buffer fills, the next destination is 
+ *  sent asynchronously and batching resumes when that send completes. 
+ *  This is a non-blocking call.
+ *
+ *  @param buf @c chops::const_shared_buffer containing data.
+ *
+ *  @param endps Destination @c std::experimental::net::ip::udp::endpoint objects.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  void send_to_many(chops::const_shared_buffer buf, std::vector<endpoint_type> endps) const {
+    if (auto p = m_ioh_wptr.lock()) {
+      p->send_to_many(buf, std::move(endps));
+      return;
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
+
+/**
+ *  @brief Send a reference counted buffer to a sequence of destination endpoints, 
+ *  implemented only for UDP IO handlers.
+ *
+ *  See @c send_to_many with a @c std::vector of endpoints.
+ *
+ *  @param buf @c chops::const_shared_buffer containing data.
+ *
+ *  @param beg Beginning iterator of a sequence of endpoints.
+ *
+ *  @param end Ending iterator of a sequence of endpoints.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  template <typename Iter>
+  void send_to_many(chops::const_shared_buffer buf, Iter beg, Iter end) const {
+    send_to_many(buf, std::vector<endpoint_type>(beg, end));
+  }
+
 /**
  *  @brief Move a reference counted buffer and send it through the associated network
  *  IO handler, implemented only for UDP IO handlers.
@@ -273,6 +522,142 @@ public:
     send(chops::const_shared_buffer(std::move(buf)), endp);
   }
 
+/**
+ *  @brief Send a reference counted buffer through the associated network IO handler, 
+ *  invoking a function object when the buffer has been written to the socket or discarded.
+ *
+ *  This allows an application to limit the amount of data in flight (for example a 
+ *  windowed producer) without polling the output queue stats. The function object is 
+ *  stored with the buffer in the output queue, so no allocation beyond the 
+ *  @c std::function is needed.
+ *
+ *  This is a non-blocking call.
+ *
+ *  @param buf @c chops::const_shared_buffer containing data.
+ *
+ *  @param cb A @c send_completion_cb function object.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  void send(chops::const_shared_buffer buf, send_completion_cb cb) const {
+    if (auto p = m_ioh_wptr.lock()) {
+      p->send(buf, std::move(cb));
+      return;
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
+
+/**
+ *  @brief Move a reference counted buffer and send it through the associated network
+ *  IO handler, invoking a function object when the buffer has been written or discarded.
+ *
+ *  @param buf @c chops::mutable_shared_buffer containing data.
+ *
+ *  @param cb A @c send_completion_cb function object.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  void send(chops::mutable_shared_buffer&& buf, send_completion_cb cb) const {
+    send(chops::const_shared_buffer(std::move(buf)), std::move(cb));
+  }
+
+/**
+ *  @brief Send a reference counted buffer to a specific destination endpoint, invoking 
+ *  a function object when the buffer has been written or discarded, implemented only 
+ *  for UDP IO handlers.
+ *
+ *  @param buf @c chops::const_shared_buffer containing data.
+ *
+ *  @param endp Destination @c std::experimental::net::ip::udp::endpoint for the buffer.
+ *
+ *  @param cb A @c send_completion_cb function object.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  void send(chops::const_shared_buffer buf, const endpoint_type& endp, 
+            send_completion_cb cb) const {
+    if (auto p = m_ioh_wptr.lock()) {
+      p->send(buf, endp, std::move(cb));
+      return;
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
+
+/**
+ *  @brief Send a composite message, the parts written in order as one message with a
+ *  scatter-gather write.
+ *
+ *  The parts are queued as one element and are not copied, so a large body buffer can
+ *  be shared between many recipients, each message having its own header. For UDP IO
+ *  handlers the parts are sent as one datagram to the default destination endpoint.
+ *  Empty parts are ignored.
+ *
+ *  This is a non-blocking call.
+ *
+ *  @param parts @c shared_buffer_parts containing the message data, in order.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  void send(shared_buffer_parts parts) const {
+    if (auto p = m_ioh_wptr.lock()) {
+      p->send(std::move(parts));
+      return;
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
+
+/**
+ *  @brief Send a header and a body as one message, without concatenating them.
+ *
+ *  See @c send with @c shared_buffer_parts.
+ *
+ *  @param hdr @c chops::const_shared_buffer containing the header.
+ *
+ *  @param body @c chops::const_shared_buffer containing the body.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  void send(chops::const_shared_buffer hdr, chops::const_shared_buffer body) const {
+    send(shared_buffer_parts { std::move(hdr), std::move(body) });
+  }
+
+/**
+ *  @brief Send a composite message as one datagram to a specific destination endpoint,
+ *  implemented only for UDP IO handlers.
+ *
+ *  See @c send with @c shared_buffer_parts.
+ *
+ *  @param parts @c shared_buffer_parts containing the datagram data, in order.
+ *
+ *  @param endp Destination @c std::experimental::net::ip::udp::endpoint for the datagram.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  void send(shared_buffer_parts parts, const endpoint_type& endp) const {
+    if (auto p = m_ioh_wptr.lock()) {
+      p->send(std::move(parts), endp);
+      return;
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
+
+/**
+ *  @brief Send a header and a body as one datagram to a specific destination endpoint,
+ *  implemented only for UDP IO handlers.
+ *
+ *  @param hdr @c chops::const_shared_buffer containing the header.
+ *
+ *  @param body @c chops::const_shared_buffer containing the body.
+ *
+ *  @param endp Destination @c std::experimental::net::ip::udp::endpoint for the datagram.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  void send(chops::const_shared_buffer hdr, chops::const_shared_buffer body,
+            const endpoint_type& endp) const {
+    send(shared_buffer_parts { std::move(hdr), std::move(body) }, endp);
+  }
+
 
 /**
  *  @brief Enable IO processing for the associated network IO handler with message 
@@ -307,6 +692,12 @@ public:
  *  @c basic_io_interface can be used for sending a reply. The endpoint is the remote 
  *  endpoint that sent the data (not used in the @c send method call, but may be
  *  useful for other purposes). 
+ *
+ *  The message handler may instead take a fourth parameter of type 
+ *  @c std::chrono::system_clock::time_point, in which case kernel receive timestamps 
+ *  are enabled on the socket and the timestamp of the (last segment of the) message is 
+ *  passed to the handler. If kernel timestamps are not available the time the read 
+ *  completed is passed instead. This is not supported for delimiter based reads.
 
  *  Returning @c false from the message handler callback causes the connection to be 
  *  closed.
@@ -427,6 +818,9 @@ public:
  *          std::experimental::net::ip::udp::endpoint);
  *  @endcode
  *
+ *  As with the message frame @c start_io, the message handler may take a fourth, kernel
+ *  receive timestamp, parameter.
+ *
  *  Returning @c false from the message handler callback causes the TCP connection or UDP socket to 
  *  be closed.
  *
@@ -494,6 +888,89 @@ public:
     throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
   }
 
+/**
+ *  @brief Enable IO processing for the associated network IO handler with fixed size 
+ *  records, the fastest read path.
+ *
+ *  This method is not implemented for UDP IO handlers (only for TCP IO handlers).
+ *
+ *  Each read takes as many bytes as are available (up to @c max_records records), and 
+ *  every complete record is delivered to the message handler. A partial record is kept
+ *  for the next read. The read buffer is allocated once and never resized.
+ *
+ *  @param record_size Size in bytes of each record.
+ *
+ *  @param max_records Maximum number of records read at one time.
+ *
+ *  @param msg_handler A message handler function object callback. If the signature is 
+ *  the usual message handler signature, it is invoked once per record. If the signature
+ *  has an additional parameter:
+ *
+ *  @code
+ *    bool (std::experimental::net::const_buffer,
+ *          chops::net::tcp_io_interface, // basic_io_interface<tcp_io>
+ *          std::experimental::net::ip::tcp::endpoint,
+ *          std::size_t); // number of records
+ *  @endcode
+ *
+ *  it is invoked once per read, with the buffer spanning all of the complete records.
+ *
+ *  Returning @c false from the message handler callback causes the connection to be 
+ *  closed.
+ *
+ *  @return @c false if already started, otherwise @c true.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  template <typename MH>
+  bool start_io_fixed(std::size_t record_size, std::size_t max_records, MH&& msg_handler) {
+    if (auto p = m_ioh_wptr.lock()) {
+      return p->start_io_fixed(record_size, max_records, std::forward<MH>(msg_handler));
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
+
+/**
+ *  @brief Enable IO processing for the associated network IO handler, receiving 
+ *  datagrams through a memory mapped packet ring instead of the UDP socket.
+ *
+ *  This method is not implemented for TCP IO handlers (only for UDP IO handlers).
+ *
+ *  For high rate (typically multicast) ingest, a Linux @c AF_PACKET @c TPACKET_V3 ring 
+ *  bound to the given interface receives the IPv4 UDP datagrams addressed to the local 
+ *  port of the UDP entity (and optionally only to a set of destination addresses). The 
+ *  datagrams are delivered to the message handler in batches, one batch per ready ring 
+ *  block, without a system call per datagram. The UDP socket remains open, so multicast
+ *  group membership is unaffected, but its own copies of the datagrams are dropped by a 
+ *  socket filter (replacing any filter set by @c set_socket_filter, which is refused
+ *  until IO is stopped). The ring filters on the port the UDP socket is bound to, so an 
+ *  ephemeral local port works as well.
+ *
+ *  The @c CAP_NET_RAW capability is needed. If the ring cannot be opened, or the socket 
+ *  filter cannot be attached, the error callback is invoked with the system error and 
+ *  the UDP entity is stopped.
+ *
+ *  Sends (writes) are enabled after this call.
+ *
+ *  @param params Interface name and ring sizing, as a @c packet_ring_params object.
+ *
+ *  @param msg_handler A message handler function object callback, with the same 
+ *  signature as the maximum size @c start_io method. If the message handler takes a 
+ *  fourth parameter, the kernel receive timestamp from the ring is passed.
+ *
+ *  @return @c false if already started or the ring could not be opened, otherwise 
+ *  @c true.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  template <typename MH>
+  bool start_io_packet_ring(const packet_ring_params& params, MH&& msg_handler) {
+    if (auto p = m_ioh_wptr.lock()) {
+      return p->start_io_packet_ring(params, std::forward<MH>(msg_handler));
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
+
 /**
  *  @brief Enable IO processing for the associated network IO handler with no incoming
  *  message handling.
@@ -543,6 +1020,81 @@ public:
     }
     throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
   }
+
+/**
+ *  @brief Enable IO processing for the associated network IO handler, reading and 
+ *  framing incoming messages directly into the slots of an application ring.
+ *
+ *  This method is not implemented for UDP IO handlers (only for TCP IO handlers).
+ *
+ *  The header size and message frame are the same as the corresponding message handler
+ *  @c start_io method, except that each message is read into the next free slot of the 
+ *  ring and published to the consuming thread instead of invoking a message handler. 
+ *  When the ring is full, reads are paused until the consumer frees a slot. A message 
+ *  larger than the slot size is an error, closing the connection.
+ *
+ *  The message frame function object must be copyable.
+ *
+ *  @param ring @c spsc_msg_ring that outlives the IO handler.
+ *
+ *  @param header_size The initial read size (in bytes) of each incoming message.
+ *
+ *  @param msg_frame A message frame function object callback.
+ *
+ *  @return @c false if already started, otherwise @c true.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  template <typename MF>
+  bool start_io(spsc_msg_ring<endpoint_type>& ring, std::size_t header_size, MF&& msg_frame) {
+    if (auto p = m_ioh_wptr.lock()) {
+      return p->start_io(ring, header_size, std::forward<MF>(msg_frame));
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
+
+/**
+ *  @brief Enable IO processing for the associated network IO handler, reading fixed 
+ *  size messages directly into the slots of an application ring.
+ *
+ *  This method is not implemented for UDP IO handlers (only for TCP IO handlers).
+ *
+ *  @param ring @c spsc_msg_ring that outlives the IO handler.
+ *
+ *  @param read_size Size of each message, which must not be larger than the slot size.
+ *
+ *  @return @c false if already started, otherwise @c true.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  bool start_io(spsc_msg_ring<endpoint_type>& ring, std::size_t read_size) {
+    if (auto p = m_ioh_wptr.lock()) {
+      return p->start_io(ring, read_size);
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
+
+/**
+ *  @brief Enable IO processing for the associated network IO handler, receiving 
+ *  datagrams directly into the slots of an application ring.
+ *
+ *  This method is not implemented for TCP IO handlers (only for UDP IO handlers).
+ *
+ *  The slot size is the maximum datagram size, larger datagrams are truncated. When 
+ *  the ring is full, reads are paused until the consumer frees a slot.
+ *
+ *  @param ring @c spsc_msg_ring that outlives the IO handler.
+ *
+ *  @return @c false if already started, otherwise @c true.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  bool start_io(spsc_msg_ring<endpoint_type>& ring) {
+    if (auto p = m_ioh_wptr.lock()) {
+      return p->start_io(ring);
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
  
 /**
  *  @brief Stop IO processing and close the associated network IO handler.
@@ -22,9 +22,13 @@
 #include <utility> // std::move, std::forward
 #include <system_error> // std::make_error, std::error_code
 
+#include <experimental/executor>
+
 #include "net_ip/net_ip_error.hpp"
 
 #include "net_ip/basic_io_interface.hpp"
+#include "net_ip/socket_filter.hpp"
+#include "net_ip/connect_scheduler.hpp"
 
 namespace chops {
 namespace net {
@@ -139,6 +143,51 @@ public:
     throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
   }
 
+/**
+ *  @brief Attach a classic BPF socket filter to a UDP entity, implemented only for
+ *  UDP entities.
+ *
+ *  If called before @c start the filter is attached when the socket is opened, so no
+ *  unwanted datagram is ever queued, and a failure to attach it fails the @c start.
+ *  Once started, the filter is attached from within the socket executor and a failure
+ *  is reported through the error callback. See @c basic_io_interface @c set_socket_filter.
+ *
+ *  @param filt The @c socket_filter, an empty filter removes a previous filter.
+ *
+ *  @return @c false if reading from a packet ring, otherwise @c true.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated net entity.
+ */
+  bool set_socket_filter(socket_filter filt) const {
+    if (auto p = m_eh_wptr.lock()) {
+      return p->set_socket_filter(std::move(filt));
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
+
+/**
+ *  @brief Attach a @c connect_scheduler to a TCP connector, implemented only for TCP
+ *  connectors.
+ *
+ *  Each connect attempt of the connector, including reconnects, waits for a permit from
+ *  the scheduler. One scheduler is typically shared by all of the connectors of an
+ *  application, spreading their connects over time (see @c connect_scheduler).
+ *
+ *  This method must be called before @c start.
+ *
+ *  @param sched The @c connect_scheduler, an empty pointer detaches a previous scheduler.
+ *
+ *  @return @c false if the connector has already been started, otherwise @c true.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated net entity.
+ */
+  bool set_connect_scheduler(connect_scheduler_ptr sched) const {
+    if (auto p = m_eh_wptr.lock()) {
+      return p->set_connect_scheduler(std::move(sched));
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
+
 /**
  *  @brief Start network processing on the associated net entity with the application
  *  providing IO state change and error function objects.
@@ -237,6 +286,42 @@ public:
     throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
   }
 
+/**
+ *  @brief Start network processing, delivering the IO state change and error callbacks
+ *  through an application supplied executor.
+ *
+ *  By default the callbacks are invoked directly from within the thread running the
+ *  network IO, which means application processing in a callback delays network
+ *  processing. With this overload each callback is instead queued and a function object
+ *  is posted to the executor (for example an application @c io_context executor, or a
+ *  strand executor). Callbacks queued while a posted function object is pending are
+ *  delivered together as a batch, in the order they occurred, so there is at most one
+ *  outstanding post at any time.
+ *
+ *  The @c basic_io_interface object passed to a deferred IO state change callback may
+ *  no longer be usable when the callback runs, since the IO handler may have since been
+ *  closed.
+ *
+ *  @param io_state_chg_func As documented in the two parameter @c start method.
+ *
+ *  @param err_func As documented in the two parameter @c start method.
+ *
+ *  @param cb_exec Executor the callbacks are posted to.
+ *
+ *  @return @c false if already started, otherwise @c true.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated net entity.
+ */
+  template <typename F1, typename F2>
+  bool start(F1&& io_state_chg_func, F2&& err_func, 
+             std::experimental::net::executor cb_exec) {
+    if (auto p = m_eh_wptr.lock()) {
+      return p->start(std::forward<F1>(io_state_chg_func), std::forward<F2>(err_func), 
+                      cb_exec);
+    }
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
+
 /**
  *  @brief Stop network processing on the associated net entity after calling @c stop_io on
  *  each associated IO handler.
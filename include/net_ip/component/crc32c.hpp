@@ -0,0 +1,253 @@
+/** @file
+ *
+ *  @ingroup net_ip_component_module
+ *
+ *  @brief CRC32C message integrity functionality, appending a CRC32C trailer on send and
+ *  validating it on receive.
+ *
+ *  The CRC32C (Castagnoli) checksum is computed with the SSE 4.2 @c crc32 instruction
+ *  on x86-64 (selected at runtime) or the ARMv8 CRC instructions (when enabled at compile
+ *  time), otherwise a portable slicing-by-8 table implementation is used.
+ *
+ *  The trailer is four bytes in little-endian order, covering all of the preceding
+ *  bytes of the message. It works the same for UDP datagrams and for TCP messages
+ *  framed with a length field (the length must account for the trailer).
+ *
+ *  @note These functions are not a necessary dependency of the @c net_ip library,
+ *  but are useful components in many use cases.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2018 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef CRC32C_HPP_INCLUDED
+#define CRC32C_HPP_INCLUDED
+
+#include <cstddef> // std::size_t, std::byte
+#include <cstdint> // std::uint32_t, std::uint64_t
+#include <cstring> // std::memcpy
+#include <array>
+#include <atomic>
+#include <utility> // std::forward
+
+#include <experimental/buffer>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define CHOPS_CRC32C_SSE42
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define CHOPS_CRC32C_ARMV8
+#endif
+
+#include "utility/shared_buffer.hpp"
+
+namespace chops {
+namespace net {
+
+/**
+ *  @brief Size in bytes of the CRC32C trailer.
+ */
+constexpr std::size_t crc32c_size = 4;
+
+namespace detail {
+
+using crc32c_tables_type = std::array<std::array<std::uint32_t, 256>, 8>;
+
+constexpr crc32c_tables_type make_crc32c_tables() noexcept {
+  crc32c_tables_type tbl { };
+  for (std::uint32_t i = 0; i < 256; ++i) {
+    std::uint32_t crc = i;
+    for (int j = 0; j < 8; ++j) {
+      crc = (crc >> 1) ^ ((crc & 1u) ? 0x82F63B78u : 0u); // reflected Castagnoli polynomial
+    }
+    tbl[0][i] = crc;
+  }
+  for (std::size_t k = 1; k < 8; ++k) {
+    for (std::size_t i = 0; i < 256; ++i) {
+      tbl[k][i] = (tbl[k-1][i] >> 8) ^ tbl[0][tbl[k-1][i] & 0xFFu];
+    }
+  }
+  return tbl;
+}
+
+inline constexpr crc32c_tables_type crc32c_tables = make_crc32c_tables();
+
+inline std::uint32_t load_le32(const std::byte* p) noexcept {
+  return  std::to_integer<std::uint32_t>(p[0])        |
+         (std::to_integer<std::uint32_t>(p[1]) << 8)  |
+         (std::to_integer<std::uint32_t>(p[2]) << 16) |
+         (std::to_integer<std::uint32_t>(p[3]) << 24);
+}
+
+// crc is the running (pre-inverted) value, slicing-by-8 processes eight bytes per step
+inline std::uint32_t crc32c_sw(std::uint32_t crc, const std::byte* p, std::size_t sz) noexcept {
+  const auto& t = crc32c_tables;
+  for (; sz >= 8; p += 8, sz -= 8) {
+    std::uint32_t lo = load_le32(p) ^ crc;
+    std::uint32_t hi = load_le32(p+4);
+    crc = t[7][lo & 0xFFu] ^ t[6][(lo >> 8) & 0xFFu] ^ t[5][(lo >> 16) & 0xFFu] ^ t[4][lo >> 24] ^
+          t[3][hi & 0xFFu] ^ t[2][(hi >> 8) & 0xFFu] ^ t[1][(hi >> 16) & 0xFFu] ^ t[0][hi >> 24];
+  }
+  for (; sz > 0; ++p, --sz) {
+    crc = (crc >> 8) ^ t[0][(crc ^ std::to_integer<std::uint32_t>(*p)) & 0xFFu];
+  }
+  return crc;
+}
+
+#if defined(CHOPS_CRC32C_SSE42)
+
+__attribute__((target("sse4.2")))
+inline std::uint32_t crc32c_hw(std::uint32_t crc, const std::byte* p, std::size_t sz) noexcept {
+  std::uint64_t crc64 = crc;
+  for (; sz >= 8; p += 8, sz -= 8) {
+    std::uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    crc64 = _mm_crc32_u64(crc64, v);
+  }
+  crc = static_cast<std::uint32_t>(crc64);
+  for (; sz > 0; ++p, --sz) {
+    crc = _mm_crc32_u8(crc, std::to_integer<unsigned char>(*p));
+  }
+  return crc;
+}
+
+inline bool has_hw_crc32c() noexcept {
+  static const bool hw = __builtin_cpu_supports("sse4.2");
+  return hw;
+}
+
+#elif defined(CHOPS_CRC32C_ARMV8)
+
+inline std::uint32_t crc32c_hw(std::uint32_t crc, const std::byte* p, std::size_t sz) noexcept {
+  for (; sz >= 8; p += 8, sz -= 8) {
+    std::uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    crc = __crc32cd(crc, v);
+  }
+  for (; sz > 0; ++p, --sz) {
+    crc = __crc32cb(crc, std::to_integer<std::uint8_t>(*p));
+  }
+  return crc;
+}
+
+constexpr bool has_hw_crc32c() noexcept { return true; }
+
+#else
+
+inline std::uint32_t crc32c_hw(std::uint32_t crc, const std::byte* p, std::size_t sz) noexcept {
+  return crc32c_sw(crc, p, sz);
+}
+
+constexpr bool has_hw_crc32c() noexcept { return false; }
+
+#endif
+
+} // end detail namespace
+
+/**
+ *  @brief Compute the CRC32C of a buffer of bytes.
+ *
+ *  @param data Pointer to the bytes.
+ *
+ *  @param sz Number of bytes.
+ *
+ *  @param crc Initial value, allowing the CRC of non-contiguous data to be computed by
+ *  passing in the result of a previous call.
+ *
+ *  @return CRC32C value.
+ */
+inline std::uint32_t crc32c(const void* data, std::size_t sz, std::uint32_t crc = 0) noexcept {
+  auto p = static_cast<const std::byte*>(data);
+  return ~(detail::has_hw_crc32c() ? detail::crc32c_hw(~crc, p, sz) :
+                                     detail::crc32c_sw(~crc, p, sz));
+}
+
+/**
+ *  @brief Append a CRC32C trailer, computed over the current contents, to a buffer.
+ *
+ *  @param buf Buffer to be sent, which is modified in place.
+ *
+ *  @return Reference to the buffer, allowing it to be moved into a @c send call.
+ */
+inline chops::mutable_shared_buffer& append_crc32c(chops::mutable_shared_buffer& buf) {
+  auto crc = crc32c(buf.data(), buf.size());
+  std::byte tr[crc32c_size] { static_cast<std::byte>(crc), static_cast<std::byte>(crc >> 8),
+                              static_cast<std::byte>(crc >> 16), static_cast<std::byte>(crc >> 24) };
+  return buf.append(tr, crc32c_size);
+}
+
+/**
+ *  @brief Check the CRC32C trailer of a received message.
+ *
+ *  @param buf Buffer containing the message followed by the trailer.
+ *
+ *  @return @c true if the buffer is large enough to hold a trailer and the trailer
+ *  matches the CRC32C of the preceding bytes.
+ */
+inline bool is_crc32c_valid(std::experimental::net::const_buffer buf) noexcept {
+  if (buf.size() < crc32c_size) {
+    return false;
+  }
+  auto p = static_cast<const std::byte*>(buf.data());
+  auto sz = buf.size() - crc32c_size;
+  return crc32c(p, sz) == detail::load_le32(p + sz);
+}
+
+/**
+ *  @brief Create a message handler that validates and strips a CRC32C trailer before
+ *  invoking the application message handler, closing the connection or UDP socket on
+ *  a mismatch.
+ *
+ *  @param msg_hdlr Application message handler, invoked with the message without
+ *  the trailer. The handler is moved if possible, otherwise copied.
+ *
+ *  @return A message handler function object usable with TCP or UDP @c start_io.
+ */
+template <typename MH>
+auto make_crc32c_msg_hdlr(MH&& msg_hdlr) {
+  return [mh = std::forward<MH>(msg_hdlr)]
+        (std::experimental::net::const_buffer buf, auto io, auto endp) mutable -> bool {
+    if (!is_crc32c_valid(buf)) {
+      return false;
+    }
+    return mh(std::experimental::net::const_buffer(buf.data(), buf.size() - crc32c_size),
+              io, endp);
+  };
+}
+
+/**
+ *  @brief Create a message handler that validates and strips a CRC32C trailer before
+ *  invoking the application message handler, counting and discarding messages with
+ *  a mismatch.
+ *
+ *  @param msg_hdlr Application message handler, invoked with the message without
+ *  the trailer. The handler is moved if possible, otherwise copied.
+ *
+ *  @param err_cnt Counter incremented for each discarded message, which must outlive
+ *  the message handler.
+ *
+ *  @return A message handler function object usable with TCP or UDP @c start_io.
+ */
+template <typename MH>
+auto make_crc32c_msg_hdlr(MH&& msg_hdlr, std::atomic_size_t& err_cnt) {
+  return [mh = std::forward<MH>(msg_hdlr), cnt = &err_cnt]
+        (std::experimental::net::const_buffer buf, auto io, auto endp) mutable -> bool {
+    if (!is_crc32c_valid(buf)) {
+      ++(*cnt);
+      return true;
+    }
+    return mh(std::experimental::net::const_buffer(buf.data(), buf.size() - crc32c_size),
+              io, endp);
+  };
+}
+
+} // end net namespace
+} // end chops namespace
+
+#endif
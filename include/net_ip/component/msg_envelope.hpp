@@ -0,0 +1,275 @@
+/** @file
+ *
+ *  @ingroup net_ip_component_module
+ *
+ *  @brief Envelope batching, packing many small application messages into one framed
+ *  envelope on send and unpacking an envelope into individual message handler calls
+ *  on receive.
+ *
+ *  An envelope is a four byte header containing the body length, followed by a body
+ *  with a sequence of messages, each preceded by a two byte length. All lengths are
+ *  in big-endian (network) byte order. Envelopes are read with the simple variable
+ *  length message frame (TCP) or as a single datagram (UDP).
+ *
+ *  With thousands of tiny messages per second, batching amortizes the per-frame header,
+ *  system call, and message handler dispatch costs over many messages.
+ *
+ *  @note These functions are not a necessary dependency of the @c net_ip library,
+ *  but are useful components in many use cases.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2018 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef MSG_ENVELOPE_HPP_INCLUDED
+#define MSG_ENVELOPE_HPP_INCLUDED
+
+#include <cstddef> // std::size_t, std::byte
+#include <cstdint> // std::uint16_t, std::uint32_t, std::uint64_t
+#include <utility> // std::forward, std::move
+#include <limits>
+#include <memory> // std::shared_ptr, std::enable_shared_from_this
+#include <mutex>
+#include <chrono>
+#include <system_error>
+
+#include <experimental/buffer>
+#include <experimental/io_context>
+#include <experimental/timer>
+
+#include "net_ip/basic_io_interface.hpp"
+#include "net_ip/net_ip_error.hpp"
+#include "net_ip/component/simple_variable_len_msg_frame.hpp"
+
+#include "utility/shared_buffer.hpp"
+
+namespace chops {
+namespace net {
+
+/**
+ *  @brief Size in bytes of the envelope header.
+ */
+constexpr std::size_t envelope_hdr_size = 4;
+
+/**
+ *  @brief Size in bytes of the length preceding each message within an envelope.
+ */
+constexpr std::size_t envelope_msg_hdr_size = 2;
+
+/**
+ *  @brief Maximum size of a single message within an envelope.
+ */
+constexpr std::size_t envelope_max_msg_size = std::numeric_limits<std::uint16_t>::max();
+
+/**
+ *  @brief Decode an envelope header, returning the size of the envelope body.
+ *
+ *  This has the @c hdr_decoder_func signature, for use with
+ *  @c make_simple_variable_len_msg_frame.
+ */
+inline std::size_t decode_envelope_hdr(const std::byte* ptr, std::size_t) noexcept {
+  return (std::to_integer<std::size_t>(ptr[0]) << 24) |
+         (std::to_integer<std::size_t>(ptr[1]) << 16) |
+         (std::to_integer<std::size_t>(ptr[2]) << 8) |
+          std::to_integer<std::size_t>(ptr[3]);
+}
+
+/**
+ *  @brief Create a message frame function object for reading TCP envelopes;
+ *  @c envelope_hdr_size is the header size for the @c start_io call.
+ */
+inline auto make_envelope_msg_frame() {
+  return make_simple_variable_len_msg_frame(decode_envelope_hdr);
+}
+
+/**
+ *  @brief Create a message handler that unpacks an envelope, invoking the application
+ *  message handler once for each message.
+ *
+ *  If the application message handler returns @c false, or the envelope is malformed,
+ *  the remaining messages are discarded and @c false is returned, closing the connection
+ *  or UDP socket.
+ *
+ *  @param msg_hdlr Application message handler, with the usual message handler signature.
+ *  The handler is moved if possible, otherwise copied.
+ *
+ *  @return A message handler function object usable with TCP or UDP @c start_io.
+ */
+template <typename MH>
+auto make_envelope_msg_hdlr(MH&& msg_hdlr) {
+  return [mh = std::forward<MH>(msg_hdlr)]
+        (std::experimental::net::const_buffer buf, auto io, auto endp) mutable -> bool {
+    if (buf.size() < envelope_hdr_size) {
+      return false;
+    }
+    auto p = static_cast<const std::byte*>(buf.data());
+    auto end = p + buf.size();
+    p += envelope_hdr_size;
+    while (p != end) {
+      if (end - p < static_cast<std::ptrdiff_t>(envelope_msg_hdr_size)) {
+        return false;
+      }
+      std::size_t sz = (std::to_integer<std::size_t>(p[0]) << 8) | std::to_integer<std::size_t>(p[1]);
+      p += envelope_msg_hdr_size;
+      if (end - p < static_cast<std::ptrdiff_t>(sz)) {
+        return false;
+      }
+      if (!mh(std::experimental::net::const_buffer(p, sz), io, endp)) {
+        return false;
+      }
+      p += sz;
+    }
+    return true;
+  };
+}
+
+/**
+ *  @brief Pack application messages into envelopes, sending an envelope when it reaches
+ *  a maximum size or when the first message in it has waited a maximum time.
+ *
+ *  Objects of this class are always created through @c make_envelope_sender, since a
+ *  timer callback may outlive the last application reference.
+ *
+ *  This class is thread-safe for concurrent access.
+ */
+template <typename IOT>
+class envelope_sender : public std::enable_shared_from_this<envelope_sender<IOT>> {
+private:
+  using lock_guard = std::lock_guard<std::mutex>;
+
+private:
+  mutable std::mutex                    m_mutex;
+  basic_io_interface<IOT>               m_io;
+  std::size_t                           m_max_size;
+  std::chrono::milliseconds             m_max_delay;
+  std::experimental::net::steady_timer  m_timer;
+  chops::mutable_shared_buffer          m_buf;
+  std::size_t                           m_num_msgs;
+  std::uint64_t                         m_envelope_num; // ignore timers for flushed envelopes
+
+public:
+  envelope_sender(std::experimental::net::io_context& ioc, basic_io_interface<IOT> io,
+                  std::size_t max_size, std::chrono::milliseconds max_delay) :
+    m_mutex(), m_io(io), m_max_size(max_size), m_max_delay(max_delay), m_timer(ioc),
+    m_buf(envelope_hdr_size), m_num_msgs(0), m_envelope_num(0) { }
+
+/**
+ *  @brief Add a message to the current envelope, sending the envelope if it is full.
+ *
+ *  @return @c false if the message is too large for an envelope, otherwise @c true.
+ *
+ *  @throw A @c net_ip_exception is thrown if the envelope is sent and there is not an
+ *  associated IO handler.
+ */
+  bool send(const void* buf, std::size_t sz) {
+    if (sz > envelope_max_msg_size) {
+      return false;
+    }
+    lock_guard gd { m_mutex };
+    if (m_num_msgs > 0 && (m_buf.size() + envelope_msg_hdr_size + sz) > m_max_size) {
+      flush_envelope();
+    }
+    std::byte hdr[envelope_msg_hdr_size] { static_cast<std::byte>(sz >> 8),
+                                           static_cast<std::byte>(sz) };
+    m_buf.append(hdr, envelope_msg_hdr_size).append(buf, sz);
+    if (++m_num_msgs == 1) {
+      start_timer();
+    }
+    if (m_buf.size() >= m_max_size) {
+      flush_envelope();
+    }
+    return true;
+  }
+
+  bool send(const chops::const_shared_buffer& buf) {
+    return send(buf.data(), buf.size());
+  }
+
+/**
+ *  @brief Send the current envelope now, if it contains any messages.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  void flush() {
+    lock_guard gd { m_mutex };
+    flush_envelope();
+  }
+
+/**
+ *  @brief Return the number of messages waiting in the current envelope.
+ */
+  std::size_t num_pending() const noexcept {
+    lock_guard gd { m_mutex };
+    return m_num_msgs;
+  }
+
+private:
+
+  void flush_envelope() {
+    if (m_num_msgs == 0) {
+      return;
+    }
+    auto sz = m_buf.size() - envelope_hdr_size;
+    auto p = m_buf.data();
+    p[0] = static_cast<std::byte>(sz >> 24);
+    p[1] = static_cast<std::byte>(sz >> 16);
+    p[2] = static_cast<std::byte>(sz >> 8);
+    p[3] = static_cast<std::byte>(sz);
+    chops::mutable_shared_buffer env(std::move(m_buf));
+    m_buf = chops::mutable_shared_buffer(envelope_hdr_size);
+    m_num_msgs = 0;
+    ++m_envelope_num;
+    m_io.send(std::move(env));
+  }
+
+  void start_timer() {
+    std::weak_ptr<envelope_sender<IOT>> self = this->weak_from_this();
+    m_timer.expires_after(m_max_delay);
+    m_timer.async_wait( [self, num = m_envelope_num] (const std::error_code& err) {
+        auto p = self.lock();
+        if (err || !p) {
+          return;
+        }
+        lock_guard gd { p->m_mutex };
+        if (num != p->m_envelope_num) {
+          return; // envelope already sent
+        }
+        try {
+          p->flush_envelope();
+        }
+        catch (const net_ip_exception&) { } // IO handler gone, envelope discarded
+      }
+    );
+  }
+
+};
+
+/**
+ *  @brief Create an @c envelope_sender.
+ *
+ *  @param ioc @c io_context used for the maximum delay timer.
+ *
+ *  @param io @c basic_io_interface used to send envelopes.
+ *
+ *  @param max_size Envelope size (in bytes) that triggers a send.
+ *
+ *  @param max_delay Maximum time the first message of an envelope waits before the
+ *  envelope is sent.
+ *
+ *  @return @c std::shared_ptr to the @c envelope_sender.
+ */
+template <typename IOT>
+auto make_envelope_sender(std::experimental::net::io_context& ioc, basic_io_interface<IOT> io,
+                          std::size_t max_size, std::chrono::milliseconds max_delay) {
+  return std::make_shared<envelope_sender<IOT>>(ioc, io, max_size, max_delay);
+}
+
+} // end net namespace
+} // end chops namespace
+
+#endif
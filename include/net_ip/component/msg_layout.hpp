@@ -0,0 +1,280 @@
+/** @file
+ *
+ *  @ingroup net_ip_component_module
+ *
+ *  @brief Compile-time message layout declarations, with encode and decode views over
+ *  buffers.
+ *
+ *  Binary message headers are typically decoded by hand, copying bytes one at a time and
+ *  converting byte order. Instead, each field is declared once with its type, offset, and
+ *  byte order; the layout is checked at compile time (fields within bounds and not
+ *  overlapping), and reads and writes compile down to a single load or store plus a
+ *  byte swap when needed.
+ *
+ *  @code
+ *    using msg_len = chops::net::layout_field<std::uint16_t, 0>;
+ *    using msg_type = chops::net::layout_field<std::uint8_t, 2>;
+ *    using msg_hdr = chops::net::msg_layout<msg_len, msg_type>;
+ *
+ *    // decode, for example within a message handler
+ *    auto len = chops::net::make_layout_view<msg_hdr>(buf).get<msg_len>();
+ *    // message frame for simple variable length messages
+ *    auto mf = chops::net::make_simple_variable_len_msg_frame(
+ *                             chops::net::layout_hdr_decoder<msg_len>);
+ *  @endcode
+ *
+ *  @note These functions are not a necessary dependency of the @c net_ip library,
+ *  but are useful components in many use cases.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2018 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef MSG_LAYOUT_HPP_INCLUDED
+#define MSG_LAYOUT_HPP_INCLUDED
+
+#include <cstddef> // std::size_t, std::byte
+#include <cstdint> // std::uint16_t, std::uint32_t, std::uint64_t
+#include <cstring> // std::memcpy
+#include <type_traits>
+#include <array>
+
+#include <experimental/buffer>
+
+#include "utility/shared_buffer.hpp"
+
+namespace chops {
+namespace net {
+
+/**
+ *  @brief Byte order of a message field.
+ */
+enum class byte_order { big, little };
+
+namespace detail {
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+constexpr byte_order native_byte_order = byte_order::big;
+#else
+constexpr byte_order native_byte_order = byte_order::little;
+#endif
+
+template <typename U>
+constexpr U byte_swap(U v) noexcept {
+  static_assert(std::is_unsigned_v<U>);
+  if constexpr (sizeof(U) == 1) {
+    return v;
+  }
+#if defined(__GNUC__) || defined(__clang__)
+  else if constexpr (sizeof(U) == 2) {
+    return __builtin_bswap16(v);
+  }
+  else if constexpr (sizeof(U) == 4) {
+    return __builtin_bswap32(v);
+  }
+  else if constexpr (sizeof(U) == 8) {
+    return __builtin_bswap64(v);
+  }
+#endif
+  else {
+    U r = 0;
+    for (std::size_t i = 0; i < sizeof(U); ++i) {
+      r = static_cast<U>((r << 8) | (v & 0xFFu));
+      v = static_cast<U>(v >> 8);
+    }
+    return r;
+  }
+}
+
+template <typename T, bool = std::is_enum_v<T>>
+struct field_uint {
+  using type = std::make_unsigned_t<T>;
+};
+
+template <typename T>
+struct field_uint<T, true> {
+  using type = std::make_unsigned_t<std::underlying_type_t<T>>;
+};
+
+template <typename T>
+using field_uint_t = typename field_uint<T>::type;
+
+} // end detail namespace
+
+/**
+ *  @brief Declare a message field with a value type, a byte offset, and a byte order.
+ *
+ *  @tparam T Integral or enum type of the field.
+ *
+ *  @tparam Offset Byte offset of the field within the message.
+ *
+ *  @tparam Order Byte order of the field, defaulting to big-endian (network) order.
+ */
+template <typename T, std::size_t Offset, byte_order Order = byte_order::big>
+struct layout_field {
+  static_assert(std::is_integral_v<T> || std::is_enum_v<T>,
+                "Layout fields must be integral or enum types");
+
+  using value_type = T;
+  static constexpr std::size_t offset = Offset;
+  static constexpr std::size_t size = sizeof(T);
+  static constexpr byte_order order = Order;
+
+/**
+ *  @brief Decode the field from the start of a message.
+ */
+  static T decode(const std::byte* msg) noexcept {
+    using U = detail::field_uint_t<T>;
+    U v;
+    std::memcpy(&v, msg + Offset, sizeof(U));
+    if constexpr (Order != detail::native_byte_order) {
+      v = detail::byte_swap(v);
+    }
+    return static_cast<T>(v);
+  }
+
+/**
+ *  @brief Encode the field into a message.
+ */
+  static void encode(std::byte* msg, T val) noexcept {
+    using U = detail::field_uint_t<T>;
+    U v = static_cast<U>(val);
+    if constexpr (Order != detail::native_byte_order) {
+      v = detail::byte_swap(v);
+    }
+    std::memcpy(msg + Offset, &v, sizeof(U));
+  }
+};
+
+/**
+ *  @brief A message layout, a set of non-overlapping fields.
+ *
+ *  @tparam Fs @c layout_field types.
+ */
+template <typename... Fs>
+struct msg_layout {
+
+/**
+ *  @brief Size of the layout in bytes, the end of the last field.
+ */
+  static constexpr std::size_t size = [] {
+    std::size_t sz = 0;
+    ((sz = (Fs::offset + Fs::size > sz) ? Fs::offset + Fs::size : sz), ...);
+    return sz;
+  } ();
+
+  template <typename F>
+  static constexpr bool contains = (std::is_same_v<F, Fs> || ...);
+
+private:
+  static constexpr bool fields_disjoint() noexcept {
+    constexpr std::array<std::size_t, sizeof...(Fs)> beg { Fs::offset... };
+    constexpr std::array<std::size_t, sizeof...(Fs)> end { (Fs::offset + Fs::size)... };
+    for (std::size_t i = 0; i < beg.size(); ++i) {
+      for (std::size_t j = i + 1; j < beg.size(); ++j) {
+        if (beg[i] < end[j] && beg[j] < end[i]) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  static_assert(sizeof...(Fs) > 0, "A message layout needs at least one field");
+  static_assert(fields_disjoint(), "Message layout fields overlap");
+};
+
+/**
+ *  @brief Read only view of a buffer, decoding the fields of a layout.
+ */
+template <typename L>
+class layout_view {
+private:
+  const std::byte* m_ptr;
+
+public:
+  explicit layout_view(const std::byte* ptr) noexcept : m_ptr(ptr) { }
+
+  template <typename F>
+  typename F::value_type get() const noexcept {
+    static_assert(L::template contains<F>, "Field is not part of the message layout");
+    return F::decode(m_ptr);
+  }
+
+  const std::byte* data() const noexcept { return m_ptr; }
+};
+
+/**
+ *  @brief Writable view of a buffer, encoding and decoding the fields of a layout.
+ */
+template <typename L>
+class mutable_layout_view {
+private:
+  std::byte* m_ptr;
+
+public:
+  explicit mutable_layout_view(std::byte* ptr) noexcept : m_ptr(ptr) { }
+
+  template <typename F>
+  typename F::value_type get() const noexcept {
+    static_assert(L::template contains<F>, "Field is not part of the message layout");
+    return F::decode(m_ptr);
+  }
+
+  template <typename F>
+  mutable_layout_view& set(typename F::value_type val) noexcept {
+    static_assert(L::template contains<F>, "Field is not part of the message layout");
+    F::encode(m_ptr, val);
+    return *this;
+  }
+
+  std::byte* data() const noexcept { return m_ptr; }
+};
+
+/**
+ *  @brief Create a @c layout_view over a buffer, which must be at least the layout size.
+ */
+template <typename L>
+layout_view<L> make_layout_view(std::experimental::net::const_buffer buf) noexcept {
+  return layout_view<L>(static_cast<const std::byte*>(buf.data()));
+}
+
+/**
+ *  @brief Create a @c mutable_layout_view over a buffer, which must be at least the
+ *  layout size.
+ */
+template <typename L>
+mutable_layout_view<L> make_layout_view(std::experimental::net::mutable_buffer buf) noexcept {
+  return mutable_layout_view<L>(static_cast<std::byte*>(buf.data()));
+}
+
+/**
+ *  @brief Create a @c mutable_layout_view over a reference counted buffer, first
+ *  resizing it to the layout size if smaller.
+ */
+template <typename L>
+mutable_layout_view<L> make_layout_view(chops::mutable_shared_buffer& buf) {
+  if (buf.size() < L::size) {
+    buf.resize(L::size);
+  }
+  return mutable_layout_view<L>(buf.data());
+}
+
+/**
+ *  @brief Header decoder with the @c hdr_decoder_func signature, returning the value of
+ *  a length field, for use with @c make_simple_variable_len_msg_frame.
+ */
+template <typename F>
+std::size_t layout_hdr_decoder(const std::byte* ptr, std::size_t) noexcept {
+  return static_cast<std::size_t>(F::decode(ptr));
+}
+
+} // end net namespace
+} // end chops namespace
+
+#endif
@@ -0,0 +1,643 @@
+/** @file
+ *
+ *  @ingroup net_ip_component_module
+ *
+ *  @brief NAK based reliable multicast, with a sequencing sender that keeps a retransmit
+ *  ring and receivers that detect gaps and request retransmission over unicast UDP.
+ *
+ *  Each data datagram sent by an @c rmcast_sender carries a sequence number. An
+ *  @c rmcast_receiver delivers payloads to the application in sequence order, buffering
+ *  out of order datagrams. When a gap is detected the receiver sends a NAK (negative
+ *  acknowledgement) to the unicast address the datagrams were sent from, and the sender
+ *  retransmits the missing datagrams to the (multicast) destination, so all receivers
+ *  missing the same datagrams recover from one retransmission. The sender periodically
+ *  sends a heartbeat containing the next sequence number, so loss at the end of a burst
+ *  is detected.
+ *
+ *  Recovery is bounded: a gap is NAKed a limited number of times, and the number of
+ *  buffered out of order datagrams is limited, after which the missing datagrams are
+ *  reported as lost and delivery continues. The sender only retains a fixed number of
+ *  datagrams for retransmission.
+ *
+ *  Both sides use @c udp_io_interface objects: the sender IO handler is started by the
+ *  @c rmcast_sender (it reads NAKs) and sends to the destination endpoint, while the
+ *  receiver IO handler is bound to the destination port (and joined to the multicast
+ *  group by the application, for example through the @c get_socket method) and is
+ *  started by the @c rmcast_receiver. Nothing in the protocol requires multicast, so
+ *  unicast destinations work as well.
+ *
+ *  All header fields are in network byte order:
+ *
+ *  @code
+ *    data:       type (1 byte, 1), sequence number (8 bytes), payload
+ *    NAK:        type (1 byte, 2), first sequence number (8 bytes), count (4 bytes)
+ *    heartbeat:  type (1 byte, 3), next sequence number (8 bytes)
+ *  @endcode
+ *
+ *  @note These functions are not a necessary dependency of the @c net_ip library,
+ *  but are useful components in many use cases.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2018 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef RELIABLE_MULTICAST_HPP_INCLUDED
+#define RELIABLE_MULTICAST_HPP_INCLUDED
+
+#include <cstddef> // std::size_t, std::byte
+#include <cstdint> // std::uint8_t, std::uint32_t, std::uint64_t
+#include <memory> // std::shared_ptr, std::enable_shared_from_this
+#include <mutex>
+#include <chrono>
+#include <functional> // std::function
+#include <map>
+#include <deque>
+#include <optional>
+#include <vector>
+#include <utility> // std::move
+#include <algorithm> // std::min
+#include <system_error>
+
+#include <experimental/buffer>
+#include <experimental/internet>
+#include <experimental/io_context>
+#include <experimental/timer>
+
+#include "net_ip/io_interface.hpp"
+#include "net_ip/net_ip_error.hpp"
+#include "net_ip/component/msg_layout.hpp"
+
+#include "utility/shared_buffer.hpp"
+
+namespace chops {
+namespace net {
+
+/**
+ *  @brief Reliable multicast datagram types.
+ */
+enum class rmcast_msg_type : std::uint8_t { data = 1, nak = 2, heartbeat = 3 };
+
+using rmcast_type_field = layout_field<rmcast_msg_type, 0>;
+using rmcast_seq_field = layout_field<std::uint64_t, 1>;
+using rmcast_count_field = layout_field<std::uint32_t, 9>;
+
+/**
+ *  @brief Layout of the data and heartbeat header.
+ */
+using rmcast_hdr = msg_layout<rmcast_type_field, rmcast_seq_field>;
+
+/**
+ *  @brief Layout of a NAK.
+ */
+using rmcast_nak = msg_layout<rmcast_type_field, rmcast_seq_field, rmcast_count_field>;
+
+/**
+ *  @brief Statistics for an @c rmcast_sender.
+ */
+struct rmcast_sender_stats {
+  std::uint64_t num_sent = 0;
+  std::uint64_t num_retransmitted = 0;
+  std::uint64_t num_naks_received = 0;
+  std::uint64_t num_unrecoverable = 0; // NAKed datagrams no longer in the retransmit ring
+};
+
+/**
+ *  @brief Statistics for an @c rmcast_receiver.
+ */
+struct rmcast_receiver_stats {
+  std::uint64_t num_delivered = 0;
+  std::uint64_t num_duplicates = 0;
+  std::uint64_t num_naks_sent = 0;
+  std::uint64_t num_lost = 0;
+};
+
+/**
+ *  @brief Sending side of reliable multicast, sequencing datagrams and retransmitting
+ *  them on request.
+ *
+ *  The @c send method may be called concurrently from multiple threads.
+ */
+class rmcast_sender : public std::enable_shared_from_this<rmcast_sender> {
+private:
+  using lock_guard = std::lock_guard<std::mutex>;
+  using endpoint_type = std::experimental::net::ip::udp::endpoint;
+
+private:
+  mutable std::mutex                      m_mutex;
+  udp_io_interface                        m_io;
+  endpoint_type                           m_dest_endp;
+  std::vector<std::optional<chops::const_shared_buffer>> m_ring; // indexed by seq modulo size
+  std::uint64_t                           m_next_seq;
+  std::chrono::milliseconds               m_hb_interval;
+  std::experimental::net::steady_timer    m_timer;
+  bool                                    m_started;
+  rmcast_sender_stats                     m_stats;
+
+public:
+  rmcast_sender(std::experimental::net::io_context& ioc, udp_io_interface io,
+                const endpoint_type& dest_endp, std::size_t num_retained,
+                std::chrono::milliseconds hb_interval) :
+    m_mutex(), m_io(io), m_dest_endp(dest_endp),
+    m_ring(num_retained == 0u ? 1u : num_retained), m_next_seq(0),
+    m_hb_interval(hb_interval), m_timer(ioc), m_started(false), m_stats() { }
+
+/**
+ *  @brief Start the sender, starting IO processing on the IO handler (to read NAKs) and
+ *  the heartbeat timer.
+ *
+ *  @return @c false if already started or IO processing could not be started, otherwise
+ *  @c true.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  bool start() {
+    {
+      lock_guard gd { m_mutex };
+      if (m_started) {
+        return false;
+      }
+      m_started = true;
+    }
+    std::weak_ptr<rmcast_sender> self = weak_from_this();
+    if (!m_io.start_io(rmcast_nak::size,
+          [self] (std::experimental::net::const_buffer buf, udp_io_interface, endpoint_type) {
+            if (auto p = self.lock()) {
+              p->handle_nak(buf);
+            }
+            return true;
+          } )) {
+      return false;
+    }
+    lock_guard gd { m_mutex };
+    start_timer();
+    return true;
+  }
+
+/**
+ *  @brief Stop the heartbeat timer; the IO handler is not stopped.
+ */
+  void stop() {
+    lock_guard gd { m_mutex };
+    m_started = false;
+    m_timer.cancel();
+  }
+
+/**
+ *  @brief Send a payload as the next sequenced datagram.
+ *
+ *  @return The sequence number of the datagram.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  std::uint64_t send(const void* buf, std::size_t sz) {
+    chops::mutable_shared_buffer dg;
+    dg.resize(rmcast_hdr::size);
+    dg.append(buf, sz);
+    lock_guard gd { m_mutex };
+    auto seq = m_next_seq++;
+    make_layout_view<rmcast_hdr>(dg).set<rmcast_type_field>(rmcast_msg_type::data)
+                                    .set<rmcast_seq_field>(seq);
+    chops::const_shared_buffer cbuf(std::move(dg));
+    m_ring[seq % m_ring.size()] = cbuf;
+    ++m_stats.num_sent;
+    m_io.send(cbuf, m_dest_endp);
+    return seq;
+  }
+
+  std::uint64_t send(const chops::const_shared_buffer& buf) {
+    return send(buf.data(), buf.size());
+  }
+
+  rmcast_sender_stats get_stats() const {
+    lock_guard gd { m_mutex };
+    return m_stats;
+  }
+
+private:
+
+  void handle_nak(std::experimental::net::const_buffer buf) {
+    if (buf.size() < rmcast_nak::size) {
+      return;
+    }
+    auto v = make_layout_view<rmcast_nak>(buf);
+    if (v.get<rmcast_type_field>() != rmcast_msg_type::nak) {
+      return;
+    }
+    auto first = v.get<rmcast_seq_field>();
+    std::uint64_t cnt = std::min<std::uint64_t>(v.get<rmcast_count_field>(), m_ring.size());
+    lock_guard gd { m_mutex };
+    ++m_stats.num_naks_received;
+    for (auto seq = first; seq < first + cnt && seq < m_next_seq; ++seq) {
+      if (m_next_seq - seq > m_ring.size()) {
+        ++m_stats.num_unrecoverable;
+        continue;
+      }
+      ++m_stats.num_retransmitted;
+      m_io.send(*m_ring[seq % m_ring.size()], m_dest_endp);
+    }
+  }
+
+  // called with the lock held
+  void start_timer() {
+    std::weak_ptr<rmcast_sender> self = weak_from_this();
+    m_timer.expires_after(m_hb_interval);
+    m_timer.async_wait( [self] (const std::error_code& err) {
+        auto p = self.lock();
+        if (err || !p) {
+          return;
+        }
+        lock_guard gd { p->m_mutex };
+        if (!p->m_started) {
+          return;
+        }
+        if (p->m_next_seq > 0u) {
+          chops::mutable_shared_buffer hb;
+          make_layout_view<rmcast_hdr>(hb).set<rmcast_type_field>(rmcast_msg_type::heartbeat)
+                                          .set<rmcast_seq_field>(p->m_next_seq);
+          try {
+            p->m_io.send(chops::const_shared_buffer(std::move(hb)), p->m_dest_endp);
+          }
+          catch (const net_ip_exception&) {
+            return; // IO handler gone
+          }
+        }
+        p->start_timer();
+      }
+    );
+  }
+
+};
+
+/**
+ *  @brief Create an @c rmcast_sender.
+ *
+ *  @param ioc @c io_context used for the heartbeat timer.
+ *
+ *  @param io @c udp_io_interface used to send datagrams and receive NAKs; IO processing
+ *  must not already be started.
+ *
+ *  @param dest_endp Destination (typically multicast) endpoint.
+ *
+ *  @param num_retained Number of datagrams retained for retransmission.
+ *
+ *  @param hb_interval Heartbeat interval.
+ *
+ *  @return @c std::shared_ptr to the @c rmcast_sender.
+ */
+inline auto make_rmcast_sender(std::experimental::net::io_context& ioc, udp_io_interface io,
+                               const std::experimental::net::ip::udp::endpoint& dest_endp,
+                               std::size_t num_retained, std::chrono::milliseconds hb_interval) {
+  return std::make_shared<rmcast_sender>(ioc, io, dest_endp, num_retained, hb_interval);
+}
+
+/**
+ *  @brief Receiving side of reliable multicast, delivering payloads in sequence order
+ *  and requesting retransmission of missing datagrams.
+ *
+ *  The receiver synchronizes to the first data datagram or heartbeat received; earlier
+ *  datagrams are not requested.
+ *
+ *  Delivery is serialized: the message handler and loss callback are never invoked
+ *  concurrently, even when multiple threads run the @c io_context. A thread which finds
+ *  delivery in progress queues its datagrams for the delivering thread instead.
+ */
+class rmcast_receiver : public std::enable_shared_from_this<rmcast_receiver> {
+public:
+  using endpoint_type = std::experimental::net::ip::udp::endpoint;
+  using msg_hdlr = std::function<bool (std::experimental::net::const_buffer,
+                                       udp_io_interface, endpoint_type)>;
+  using loss_cb = std::function<void (std::uint64_t, std::uint64_t)>;
+
+private:
+  using lock_guard = std::lock_guard<std::mutex>;
+
+  struct pending_dg {
+    chops::const_shared_buffer  dg;
+    endpoint_type               endp;
+  };
+
+  // a datagram ready for delivery, or a loss notification when there is no datagram
+  struct ready_item {
+    std::uint64_t               lost_first;
+    std::uint64_t               lost_cnt;
+    std::optional<pending_dg>   pdg;
+  };
+
+private:
+  mutable std::mutex                      m_mutex;
+  udp_io_interface                        m_io;
+  std::size_t                             m_max_pending;
+  std::chrono::milliseconds               m_nak_interval;
+  int                                     m_max_nak_attempts;
+  std::experimental::net::steady_timer    m_timer;
+  msg_hdlr                                m_msg_hdlr;
+  loss_cb                                 m_loss_cb;
+  bool                                    m_started;
+  bool                                    m_synced;
+  bool                                    m_delivering; // a thread is invoking the handlers
+  std::uint64_t                           m_next_seq; // next sequence number to deliver
+  std::uint64_t                           m_end_seq; // one past highest known sequence number
+  std::map<std::uint64_t, pending_dg>     m_pending; // out of order datagrams
+  std::deque<ready_item>                  m_ready; // in order, waiting for delivery
+  endpoint_type                           m_sender_endp;
+  int                                     m_nak_attempts;
+  rmcast_receiver_stats                   m_stats;
+
+public:
+  rmcast_receiver(std::experimental::net::io_context& ioc, udp_io_interface io,
+                  std::size_t max_pending, std::chrono::milliseconds nak_interval,
+                  int max_nak_attempts) :
+    m_mutex(), m_io(io), m_max_pending(max_pending), m_nak_interval(nak_interval),
+    m_max_nak_attempts(max_nak_attempts), m_timer(ioc), m_msg_hdlr(), m_loss_cb(),
+    m_started(false), m_synced(false), m_delivering(false), m_next_seq(0), m_end_seq(0),
+    m_pending(), m_ready(), m_sender_endp(), m_nak_attempts(0), m_stats() { }
+
+/**
+ *  @brief Start the receiver, starting IO processing on the IO handler.
+ *
+ *  @param mh Message handler invoked with each payload, in sequence order. The
+ *  message handler is not invoked while the receiver lock is held.
+ *
+ *  @param lcb Function object invoked with the first sequence number and the number of
+ *  datagrams that could not be recovered.
+ *
+ *  @param max_size Maximum payload size.
+ *
+ *  @return @c false if already started or IO processing could not be started, otherwise
+ *  @c true.
+ *
+ *  @throw A @c net_ip_exception is thrown if there is not an associated IO handler.
+ */
+  bool start(msg_hdlr mh, loss_cb lcb, std::size_t max_size) {
+    {
+      lock_guard gd { m_mutex };
+      if (m_started) {
+        return false;
+      }
+      m_started = true;
+      m_msg_hdlr = std::move(mh);
+      m_loss_cb = std::move(lcb);
+    }
+    std::weak_ptr<rmcast_receiver> self = weak_from_this();
+    if (!m_io.start_io(max_size + rmcast_hdr::size,
+          [self] (std::experimental::net::const_buffer buf, udp_io_interface,
+                  endpoint_type endp) {
+            auto p = self.lock();
+            return p ? p->handle_dg(buf, endp) : false;
+          } )) {
+      return false;
+    }
+    lock_guard gd { m_mutex };
+    start_timer();
+    return true;
+  }
+
+/**
+ *  @brief Stop the NAK timer; the IO handler is not stopped.
+ */
+  void stop() {
+    lock_guard gd { m_mutex };
+    m_started = false;
+    m_timer.cancel();
+  }
+
+  rmcast_receiver_stats get_stats() const {
+    lock_guard gd { m_mutex };
+    return m_stats;
+  }
+
+private:
+
+  bool handle_dg(std::experimental::net::const_buffer buf, const endpoint_type& endp) {
+    if (buf.size() < rmcast_hdr::size) {
+      return true;
+    }
+    auto v = make_layout_view<rmcast_hdr>(buf);
+    auto seq = v.get<rmcast_seq_field>();
+    bool direct = false;
+    {
+      lock_guard gd { m_mutex };
+      m_sender_endp = endp;
+      if (v.get<rmcast_type_field>() == rmcast_msg_type::heartbeat) {
+        if (!m_synced) {
+          m_synced = true;
+          m_next_seq = m_end_seq = seq;
+        }
+        else if (seq > m_end_seq) {
+          m_end_seq = seq;
+          send_naks();
+        }
+        return true;
+      }
+      if (v.get<rmcast_type_field>() != rmcast_msg_type::data) {
+        return true;
+      }
+      if (!m_synced) {
+        m_synced = true;
+        m_next_seq = m_end_seq = seq;
+      }
+      if (seq < m_next_seq || m_pending.count(seq) != 0u) {
+        ++m_stats.num_duplicates;
+        return true;
+      }
+      bool new_gap = seq > m_end_seq;
+      if (seq >= m_end_seq) {
+        m_end_seq = seq + 1;
+      }
+      if (seq == m_next_seq && m_pending.empty()) {
+        ++m_next_seq;
+        m_nak_attempts = 0;
+        if (!m_delivering && m_ready.empty()) { // in order, delivered without a copy
+          direct = true;
+        }
+        else {
+          m_ready.push_back(ready_item { 0u, 0u, pending_dg {
+                                chops::const_shared_buffer(buf.data(), buf.size()), endp } });
+        }
+      }
+      else {
+        m_pending.emplace(seq, pending_dg { chops::const_shared_buffer(buf.data(), buf.size()),
+                                            endp });
+        collect_ready(); // this datagram may fill the oldest gap
+        if (m_pending.size() > m_max_pending) {
+          skip_gap();
+          collect_ready();
+        }
+      }
+      if (new_gap) {
+        send_naks();
+      }
+      if (m_delivering) {
+        return true; // the delivering thread picks up anything queued
+      }
+      m_delivering = true;
+    }
+    if (direct) {
+      if (!m_msg_hdlr(std::experimental::net::const_buffer(
+                          static_cast<const std::byte*>(buf.data()) + rmcast_hdr::size,
+                          buf.size() - rmcast_hdr::size), m_io, endp)) {
+        lock_guard gd { m_mutex };
+        m_delivering = false;
+        return false;
+      }
+      lock_guard gd { m_mutex };
+      ++m_stats.num_delivered;
+    }
+    return deliver();
+  }
+
+  // called with the lock held, moves in sequence datagrams from the pending map
+  void collect_ready() {
+    auto it = m_pending.begin();
+    while (it != m_pending.end() && it->first == m_next_seq) {
+      m_ready.push_back(ready_item { 0u, 0u, std::move(it->second) });
+      it = m_pending.erase(it);
+      ++m_next_seq;
+      m_nak_attempts = 0;
+    }
+  }
+
+  // called with the lock held, gives up on the oldest gap
+  void skip_gap() {
+    auto gap_end = m_pending.empty() ? m_end_seq : m_pending.begin()->first;
+    if (gap_end == m_next_seq) {
+      return; // no gap
+    }
+    auto lost_cnt = gap_end - m_next_seq;
+    m_ready.push_back(ready_item { m_next_seq, lost_cnt, std::nullopt });
+    m_stats.num_lost += lost_cnt;
+    m_next_seq = gap_end;
+    m_nak_attempts = 0;
+  }
+
+  // called with the lock held, sends one NAK for each gap
+  void send_naks() {
+    auto first = m_next_seq;
+    auto it = m_pending.begin();
+    while (first < m_end_seq) {
+      auto gap_end = (it == m_pending.end()) ? m_end_seq : it->first;
+      if (gap_end > first) {
+        chops::mutable_shared_buffer nak;
+        make_layout_view<rmcast_nak>(nak).set<rmcast_type_field>(rmcast_msg_type::nak)
+                                         .set<rmcast_seq_field>(first)
+                                         .set<rmcast_count_field>(
+                                             static_cast<std::uint32_t>(gap_end - first));
+        ++m_stats.num_naks_sent;
+        m_io.send(chops::const_shared_buffer(std::move(nak)), m_sender_endp);
+      }
+      if (it == m_pending.end()) {
+        break;
+      }
+      first = it->first + 1;
+      ++it;
+    }
+  }
+
+  // called by the thread which set m_delivering, drains the ready queue and then
+  // clears m_delivering
+  bool deliver() {
+    std::uint64_t num_delivered = 0u;
+    while (true) {
+      ready_item item;
+      {
+        lock_guard gd { m_mutex };
+        m_stats.num_delivered += num_delivered;
+        num_delivered = 0u;
+        if (m_ready.empty()) {
+          m_delivering = false;
+          return true;
+        }
+        item = std::move(m_ready.front());
+        m_ready.pop_front();
+      }
+      if (!item.pdg) {
+        if (m_loss_cb) {
+          m_loss_cb(item.lost_first, item.lost_cnt);
+        }
+        continue;
+      }
+      if (!m_msg_hdlr(std::experimental::net::const_buffer(item.pdg->dg.data() + rmcast_hdr::size,
+                                                           item.pdg->dg.size() - rmcast_hdr::size),
+                      m_io, item.pdg->endp)) {
+        lock_guard gd { m_mutex };
+        m_delivering = false;
+        return false;
+      }
+      ++num_delivered;
+    }
+  }
+
+  // called with the lock held
+  void start_timer() {
+    std::weak_ptr<rmcast_receiver> self = weak_from_this();
+    m_timer.expires_after(m_nak_interval);
+    m_timer.async_wait( [self] (const std::error_code& err) {
+        auto p = self.lock();
+        if (err || !p) {
+          return;
+        }
+        {
+          lock_guard gd { p->m_mutex };
+          if (!p->m_started) {
+            return;
+          }
+          if (p->m_next_seq < p->m_end_seq) {
+            if (++p->m_nak_attempts > p->m_max_nak_attempts) {
+              p->skip_gap();
+              p->collect_ready();
+            }
+            try {
+              p->send_naks();
+            }
+            catch (const net_ip_exception&) {
+              return; // IO handler gone
+            }
+          }
+          p->start_timer();
+          if (p->m_delivering || p->m_ready.empty()) {
+            return;
+          }
+          p->m_delivering = true;
+        }
+        p->deliver();
+      }
+    );
+  }
+
+};
+
+/**
+ *  @brief Create an @c rmcast_receiver.
+ *
+ *  @param ioc @c io_context used for the NAK timer.
+ *
+ *  @param io @c udp_io_interface bound to the destination port; IO processing must
+ *  not already be started.
+ *
+ *  @param max_pending Maximum number of out of order datagrams buffered while waiting
+ *  for a retransmission.
+ *
+ *  @param nak_interval Interval between NAKs for an unfilled gap.
+ *
+ *  @param max_nak_attempts Number of NAK intervals a gap is retried before it is
+ *  reported as lost.
+ *
+ *  @return @c std::shared_ptr to the @c rmcast_receiver.
+ */
+inline auto make_rmcast_receiver(std::experimental::net::io_context& ioc, udp_io_interface io,
+                                 std::size_t max_pending, std::chrono::milliseconds nak_interval,
+                                 int max_nak_attempts) {
+  return std::make_shared<rmcast_receiver>(ioc, io, max_pending, nak_interval,
+                                           max_nak_attempts);
+}
+
+} // end net namespace
+} // end chops namespace
+
+#endif
+
@@ -0,0 +1,133 @@
+/** @file
+ *
+ *  @ingroup net_ip_component_module
+ *
+ *  @brief A class template which collects sends to many IO handlers during a processing
+ *  tick and dispatches them with one posted function object per executor.
+ *
+ *  Each @c basic_io_interface @c send posts a function object to the executor of the
+ *  IO handler. When a producer sends updates to thousands of connections in each tick,
+ *  the posts (each with an allocation and a queue operation) dominate. A @c send_batch
+ *  collects the sends and on @c flush groups them by executor, posting one function
+ *  object per executor which queues all of its buffers and starts the writes.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2018 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef SEND_BATCH_HPP_INCLUDED
+#define SEND_BATCH_HPP_INCLUDED
+
+#include <cstddef> // std::size_t
+#include <utility> // std::move, std::pair, std::declval
+#include <memory> // std::shared_ptr
+#include <vector>
+
+#include <experimental/executor>
+
+#include "net_ip/basic_io_interface.hpp"
+
+#include "utility/shared_buffer.hpp"
+
+namespace chops {
+namespace net {
+
+/**
+ *  @brief Collect (IO handler, buffer) pairs and send them with one posted function
+ *  object per executor.
+ *
+ *  A @c send_batch is meant to be owned by a single producer thread (for example as a
+ *  @c thread_local object), and is not safe for concurrent access. Buffers sent to the
+ *  same IO handler are sent in the order added.
+ *
+ *  @tparam IOT Either @c tcp_io or @c udp_io.
+ */
+template <typename IOT>
+class send_batch {
+private:
+  using ioh_ptr = std::shared_ptr<IOT>;
+  using executor_type = decltype(std::declval<typename IOT::socket_type&>().get_executor());
+  using send_vec = std::vector<std::pair<ioh_ptr, chops::const_shared_buffer>>;
+
+  struct exec_group {
+    executor_type  exec;
+    send_vec       sends;
+  };
+
+private:
+  std::vector<exec_group>  m_groups;
+  std::size_t              m_size;
+
+public:
+
+  send_batch() : m_groups(), m_size(0) { }
+
+/**
+ *  @brief Add a buffer to be sent through an IO handler at the next @c flush.
+ *
+ *  @return @c false if there is not an associated IO handler, otherwise @c true.
+ */
+  bool add(const basic_io_interface<IOT>& io, chops::const_shared_buffer buf) {
+    auto p = io.get_shared_ptr();
+    if (!p) {
+      return false;
+    }
+    auto ex = p->get_socket().get_executor();
+    for (auto& g : m_groups) {
+      if (g.exec == ex) {
+        g.sends.emplace_back(std::move(p), std::move(buf));
+        ++m_size;
+        return true;
+      }
+    }
+    m_groups.push_back(exec_group { ex, send_vec { } });
+    m_groups.back().sends.emplace_back(std::move(p), std::move(buf));
+    ++m_size;
+    return true;
+  }
+
+  bool add(const basic_io_interface<IOT>& io, const void* buf, std::size_t sz) {
+    return add(io, chops::const_shared_buffer(buf, sz));
+  }
+
+/**
+ *  @brief Return the number of buffers waiting for the next @c flush.
+ */
+  std::size_t size() const noexcept { return m_size; }
+
+/**
+ *  @brief Post one function object per executor, sending all collected buffers.
+ *
+ *  @return The number of function objects posted.
+ */
+  std::size_t flush() {
+    std::size_t num_posts = 0;
+    for (auto& g : m_groups) {
+      if (g.sends.empty()) {
+        continue;
+      }
+      std::experimental::net::post(g.exec, [sends = std::move(g.sends)] () {
+          for (const auto& s : sends) {
+            s.first->send_direct(s.second);
+          }
+        }
+      );
+      g.sends = send_vec { };
+      ++num_posts;
+    }
+    m_size = 0;
+    return num_posts;
+  }
+
+};
+
+} // end net namespace
+} // end chops namespace
+
+#endif
+
@@ -25,6 +25,7 @@
 
 #include "net_ip/basic_io_interface.hpp"
 #include "net_ip/queue_stats.hpp"
+#include "net_ip/detail/tcp_kernel_stats.hpp"
 
 #include "utility/erase_where.hpp"
 #include "utility/shared_buffer.hpp"
@@ -139,6 +140,25 @@ public:
     }
     return tot;
   }
+
+/**
+ *  @brief Return kernel TCP statistics aggregated over all TCP connections.
+ *
+ *  Kernel queue sizes, retransmits, congestion windows, and delivery rates are summed,
+ *  round trip times are the maximum over all connections.
+ *
+ *  This method is only implemented for TCP IO handlers.
+ *
+ *  @return @c tcp_kernel_stats object containing aggregated values.
+ */
+  auto get_total_tcp_kernel_stats() const {
+    chops::net::tcp_kernel_stats tot { };
+    lock_guard gd { m_mutex };
+    for (const auto& io : m_io_intfs) {
+      tot = detail::accumulate_tcp_kernel_stats(tot, io.get_tcp_kernel_stats());
+    }
+    return tot;
+  }
 };
 
 } // end net namespace
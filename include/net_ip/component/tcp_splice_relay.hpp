@@ -0,0 +1,300 @@
+/** @file
+ *
+ *  @ingroup net_ip_component_module
+ *
+ *  @brief Relay bytes between two TCP connections with @c splice, without copying the
+ *  data into user space.
+ *
+ *  Proxies commonly forward everything received on one connection to another. Instead
+ *  of reading into a buffer, invoking a message handler, and sending, the relay moves
+ *  the data from one socket through a kernel pipe to the other socket. Data is relayed
+ *  in both directions, and a half-close (end of data) in one direction is passed through
+ *  as a shutdown of the sending side on the other connection.
+ *
+ *  This component is only available on Linux.
+ *
+ *  @note These functions are not a necessary dependency of the @c net_ip library,
+ *  but are useful components in many use cases.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2018 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef TCP_SPLICE_RELAY_HPP_INCLUDED
+#define TCP_SPLICE_RELAY_HPP_INCLUDED
+
+#ifdef __linux__
+
+#include <experimental/internet>
+#include <experimental/socket>
+
+#include <cstddef> // std::size_t
+#include <memory> // std::shared_ptr, std::enable_shared_from_this
+#include <atomic>
+#include <mutex>
+#include <functional> // std::function
+#include <system_error>
+
+#include <cerrno>
+#include <fcntl.h> // splice, pipe2
+#include <unistd.h> // close
+
+#include "net_ip/io_interface.hpp"
+#include "net_ip/net_ip_error.hpp"
+
+namespace chops {
+namespace net {
+
+/**
+ *  @brief Relay bytes in both directions between two TCP connections using @c splice.
+ *
+ *  The @c tcp_io_interface objects must not have had @c start_io called, since the relay
+ *  performs all reads and writes on the underlying sockets. Objects of this class are
+ *  created through @c make_tcp_splice_relay.
+ *
+ *  When both directions have completed (end of data or an error in each direction), the
+ *  relay done callback is invoked. The application then typically stops the associated
+ *  net entities.
+ */
+class tcp_splice_relay : public std::enable_shared_from_this<tcp_splice_relay> {
+public:
+  using relay_done_cb = std::function<void (std::error_code, std::size_t, std::size_t)>;
+
+private:
+  using socket_type = tcp_io::socket_type;
+  using lock_guard = std::lock_guard<std::mutex>;
+
+  struct relay_dir {
+    socket_type&        src;
+    socket_type&        dst;
+    int                 pipe_fds[2] = { -1, -1 };
+    std::size_t         in_pipe = 0;
+    bool                eof = false;
+    std::atomic_size_t  num_bytes { 0 };
+
+    relay_dir(socket_type& s, socket_type& d) noexcept : src(s), dst(d) { }
+  };
+
+private:
+  std::shared_ptr<tcp_io>   m_ioh_a;
+  std::shared_ptr<tcp_io>   m_ioh_b;
+  std::size_t               m_chunk_size;
+  relay_dir                 m_a_to_b;
+  relay_dir                 m_b_to_a;
+  std::mutex                m_mutex;
+  relay_done_cb             m_done_cb;
+  std::error_code           m_err;
+  int                       m_num_done;
+
+public:
+  tcp_splice_relay(std::shared_ptr<tcp_io> a, std::shared_ptr<tcp_io> b,
+                   std::size_t chunk_size) noexcept :
+    m_ioh_a(a), m_ioh_b(b), m_chunk_size(chunk_size),
+    m_a_to_b(a->get_socket(), b->get_socket()), m_b_to_a(b->get_socket(), a->get_socket()),
+    m_mutex(), m_done_cb(), m_err(), m_num_done(0) { }
+
+  ~tcp_splice_relay() {
+    close_pipe(m_a_to_b);
+    close_pipe(m_b_to_a);
+  }
+
+private:
+  tcp_splice_relay(const tcp_splice_relay&) = delete;
+  tcp_splice_relay& operator=(const tcp_splice_relay&) = delete;
+
+public:
+
+/**
+ *  @brief Start relaying in both directions.
+ *
+ *  @param done_cb Callback invoked when both directions have completed, with the first
+ *  error (if any), the number of bytes relayed from the first to the second connection,
+ *  and the number of bytes relayed from the second to the first connection.
+ *
+ *  @return @c false if the pipes could not be created or the sockets could not be set
+ *  to non-blocking, otherwise @c true.
+ */
+  bool start(relay_done_cb done_cb) {
+    m_done_cb = done_cb;
+    if (!open_pipe(m_a_to_b) || !open_pipe(m_b_to_a)) {
+      return false;
+    }
+    std::error_code ec;
+    m_a_to_b.src.native_non_blocking(true, ec);
+    if (!ec) {
+      m_b_to_a.src.native_non_blocking(true, ec);
+    }
+    if (ec) {
+      return false;
+    }
+    start_wait_read(m_a_to_b);
+    start_wait_read(m_b_to_a);
+    return true;
+  }
+
+/**
+ *  @brief Stop relaying, shutting down both connections, which eventually invokes the
+ *  relay done callback.
+ */
+  void stop() {
+    std::error_code ec;
+    m_a_to_b.src.shutdown(socket_type::shutdown_both, ec);
+    m_b_to_a.src.shutdown(socket_type::shutdown_both, ec);
+  }
+
+/**
+ *  @brief Return the number of bytes relayed from the first connection to the second.
+ */
+  std::size_t get_bytes_a_to_b() const noexcept { return m_a_to_b.num_bytes; }
+
+/**
+ *  @brief Return the number of bytes relayed from the second connection to the first.
+ */
+  std::size_t get_bytes_b_to_a() const noexcept { return m_b_to_a.num_bytes; }
+
+private:
+
+  bool open_pipe(relay_dir& d) noexcept {
+    if (::pipe2(d.pipe_fds, O_NONBLOCK | O_CLOEXEC) != 0) {
+      return false;
+    }
+    // larger pipes mean fewer splice calls, failure only costs performance
+    ::fcntl(d.pipe_fds[1], F_SETPIPE_SZ, static_cast<int>(m_chunk_size));
+    return true;
+  }
+
+  static void close_pipe(relay_dir& d) noexcept {
+    for (auto& fd : d.pipe_fds) {
+      if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+      }
+    }
+  }
+
+  void start_wait_read(relay_dir& d) {
+    auto self { shared_from_this() };
+    d.src.async_wait(socket_type::wait_read, [this, self, &d] (const std::error_code& err) {
+        if (err) {
+          dir_done(d, err);
+          return;
+        }
+        transfer(d);
+      }
+    );
+  }
+
+  void start_wait_write(relay_dir& d) {
+    auto self { shared_from_this() };
+    d.dst.async_wait(socket_type::wait_write, [this, self, &d] (const std::error_code& err) {
+        if (err) {
+          dir_done(d, err);
+          return;
+        }
+        transfer(d);
+      }
+    );
+  }
+
+  void transfer(relay_dir& d) {
+    constexpr unsigned int flags = SPLICE_F_MOVE | SPLICE_F_NONBLOCK;
+    if (!d.eof && d.in_pipe == 0) {
+      auto n = ::splice(d.src.native_handle(), nullptr, d.pipe_fds[1], nullptr,
+                        m_chunk_size, flags);
+      if (n == 0) {
+        d.eof = true;
+      }
+      else if (n < 0) {
+        if (errno != EAGAIN) {
+          dir_done(d, std::error_code(errno, std::system_category()));
+          return;
+        }
+      }
+      else {
+        d.in_pipe = static_cast<std::size_t>(n);
+      }
+    }
+    while (d.in_pipe > 0) {
+      auto n = ::splice(d.pipe_fds[0], nullptr, d.dst.native_handle(), nullptr,
+                        d.in_pipe, flags);
+      if (n < 0) {
+        if (errno == EAGAIN) {
+          start_wait_write(d); // other side is not keeping up
+          return;
+        }
+        dir_done(d, std::error_code(errno, std::system_category()));
+        return;
+      }
+      d.in_pipe -= static_cast<std::size_t>(n);
+      d.num_bytes += static_cast<std::size_t>(n);
+    }
+    if (d.eof) {
+      std::error_code ec;
+      d.dst.shutdown(socket_type::shutdown_send, ec); // pass the half-close through
+      dir_done(d, std::error_code());
+      return;
+    }
+    start_wait_read(d);
+  }
+
+  void dir_done(relay_dir& d, const std::error_code& err) {
+    if (err) {
+      // a failed direction tears down both connections
+      std::error_code ec;
+      d.src.shutdown(socket_type::shutdown_both, ec);
+      d.dst.shutdown(socket_type::shutdown_both, ec);
+    }
+    relay_done_cb cb;
+    {
+      lock_guard gd { m_mutex };
+      if (err && !m_err) {
+        m_err = err;
+      }
+      if (++m_num_done < 2) {
+        return;
+      }
+      cb = m_done_cb;
+    }
+    if (cb) {
+      cb(m_err, m_a_to_b.num_bytes, m_b_to_a.num_bytes);
+    }
+  }
+
+};
+
+/**
+ *  @brief Create a @c tcp_splice_relay between two TCP connections.
+ *
+ *  @param io_a First @c tcp_io_interface, @c start_io must not have been called.
+ *
+ *  @param io_b Second @c tcp_io_interface, @c start_io must not have been called.
+ *
+ *  @param chunk_size Maximum bytes moved per @c splice call, also used as the
+ *  requested pipe size.
+ *
+ *  @return @c std::shared_ptr to the relay, call @c start to begin relaying.
+ *
+ *  @throw A @c net_ip_exception is thrown if either @c tcp_io_interface does not have an
+ *  associated IO handler.
+ */
+inline auto make_tcp_splice_relay(tcp_io_interface io_a, tcp_io_interface io_b,
+                                  std::size_t chunk_size = 65536) {
+  auto a = io_a.get_shared_ptr();
+  auto b = io_b.get_shared_ptr();
+  if (!a || !b) {
+    throw net_ip_exception(std::make_error_code(net_ip_errc::weak_ptr_expired));
+  }
+  return std::make_shared<tcp_splice_relay>(a, b, chunk_size);
+}
+
+} // end net namespace
+} // end chops namespace
+
+#endif
+
+#endif
@@ -0,0 +1,441 @@
+/** @file
+ *
+ *  @ingroup net_ip_component_module
+ *
+ *  @brief Endpoint keyed "virtual sessions" over a single UDP socket.
+ *
+ *  A UDP server communicating with many peers through one UDP entity typically
+ *  needs per-peer state, looked up from the sender endpoint on every incoming datagram.
+ *  The @c udp_session_demux class template is a message handler that performs the lookup
+ *  with an open addressing (linear probing) table keyed on the sender endpoint, creates
+ *  per-session state on the first datagram from a peer, expires idle sessions, and invokes
+ *  an application supplied session handler with a @c basic_udp_session object. The session
+ *  object provides @c send methods that reuse the parent UDP socket, giving UDP servers
+ *  connection-like ergonomics.
+ *
+ *  @note These classes are not a necessary dependency of the @c net_ip library,
+ *  but are useful components in many use cases.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2018 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef UDP_SESSION_DEMUX_HPP_INCLUDED
+#define UDP_SESSION_DEMUX_HPP_INCLUDED
+
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint64_t
+#include <utility> // std::move, std::forward
+#include <type_traits> // std::decay_t
+#include <vector>
+#include <chrono>
+#include <functional> // std::function, for session expiry callback
+
+#include <experimental/buffer>
+#include <experimental/internet> // ip::udp::endpoint
+
+#include "net_ip/basic_io_interface.hpp"
+#include "net_ip/io_interface.hpp"
+
+#include "utility/shared_buffer.hpp"
+
+namespace chops {
+namespace net {
+
+/**
+ *  @brief A virtual session, corresponding to one remote endpoint communicating through
+ *  a shared UDP socket.
+ *
+ *  A @c basic_udp_session object is provided to the session handler of a
+ *  @c udp_session_demux. It contains the application state for the session, the remote
+ *  endpoint, and the time of the last datagram received from the remote endpoint. The
+ *  @c send methods send to the remote endpoint through the parent UDP socket.
+ *
+ *  @tparam IOT IO handler type, typically @c udp_io.
+ *
+ *  @tparam S Application state type for each session, which must be default
+ *  constructible and movable.
+ */
+template <typename IOT, typename S>
+class basic_udp_session {
+public:
+  using endpoint_type = typename IOT::endpoint_type;
+  using time_point = std::chrono::steady_clock::time_point;
+
+private:
+  basic_io_interface<IOT>  m_io_intf;
+  endpoint_type            m_remote_endp;
+  time_point               m_last_active;
+  S                        m_state;
+
+public:
+
+  basic_udp_session() = default;
+
+  basic_udp_session(basic_io_interface<IOT> io, const endpoint_type& endp, time_point tp) :
+    m_io_intf(std::move(io)), m_remote_endp(endp), m_last_active(tp), m_state() { }
+
+/**
+ *  @brief Return the remote endpoint of this session.
+ */
+  const endpoint_type& get_remote_endpoint() const noexcept { return m_remote_endp; }
+
+/**
+ *  @brief Return a reference to the application state for this session.
+ */
+  S& get_state() noexcept { return m_state; }
+  const S& get_state() const noexcept { return m_state; }
+
+/**
+ *  @brief Return the @c basic_io_interface of the parent UDP socket.
+ */
+  basic_io_interface<IOT> get_io_interface() const noexcept { return m_io_intf; }
+
+/**
+ *  @brief Return the time the last datagram was received from the remote endpoint.
+ */
+  time_point get_last_activity() const noexcept { return m_last_active; }
+
+  void set_last_activity(time_point tp) noexcept { m_last_active = tp; }
+
+  void set_io_interface(basic_io_interface<IOT> io) noexcept { m_io_intf = std::move(io); }
+
+/**
+ *  @brief Send a reference counted buffer to the remote endpoint of this session.
+ *
+ *  @throw A @c net_ip_exception is thrown if the parent UDP IO handler is no longer
+ *  valid.
+ */
+  void send(chops::const_shared_buffer buf) const { m_io_intf.send(buf, m_remote_endp); }
+
+/**
+ *  @brief Copy a buffer and send it to the remote endpoint of this session.
+ */
+  void send(const void* buf, std::size_t sz) const {
+    send(chops::const_shared_buffer(buf, sz));
+  }
+
+/**
+ *  @brief Move a writable reference counted buffer and send it to the remote endpoint of
+ *  this session.
+ */
+  void send(chops::mutable_shared_buffer&& buf) const {
+    send(chops::const_shared_buffer(std::move(buf)));
+  }
+
+};
+
+/**
+ *  @brief @c basic_udp_session for UDP IO handlers.
+ */
+template <typename S>
+using udp_session = basic_udp_session<udp_io, S>;
+
+namespace detail {
+
+// mix address and port into a well distributed hash, the final step is the
+// splitmix64 finalizer so that the low bits used for the table index are usable
+template <typename E>
+std::size_t hash_udp_endpoint(const E& endp) noexcept {
+  std::uint64_t h = endp.port();
+  auto addr = endp.address();
+  if (addr.is_v4()) {
+    h |= static_cast<std::uint64_t>(addr.to_v4().to_uint()) << 16;
+  }
+  else {
+    for (auto b : addr.to_v6().to_bytes()) {
+      h = (h * 0x100000001b3ULL) ^ static_cast<std::uint64_t>(b);
+    }
+  }
+  h ^= h >> 30;
+  h *= 0xbf58476d1ce4e5b9ULL;
+  h ^= h >> 27;
+  h *= 0x94d049bb133111ebULL;
+  h ^= h >> 31;
+  return static_cast<std::size_t>(h);
+}
+
+} // end detail namespace
+
+/**
+ *  @brief Demultiplex incoming datagrams on one UDP socket into endpoint keyed virtual
+ *  sessions.
+ *
+ *  A @c udp_session_demux object is a message handler for the UDP @c start_io methods.
+ *  Since message handlers are moved into the IO handler, a @c std::ref to the
+ *  @c udp_session_demux object is typically passed to @c start_io, which also allows
+ *  the application to query the sessions.
+ *
+ *  The session handler has the following signature:
+ *
+ *  @code
+ *    bool (std::experimental::net::const_buffer, basic_udp_session<IOT, S>&);
+ *  @endcode
+ *
+ *  Returning @c false from the session handler removes the session (but does not close
+ *  the UDP socket, which is shared with all other sessions). The session reference is only
+ *  valid for the duration of the session handler call, and @c erase must not be called from
+ *  within the session handler.
+ *
+ *  Sessions are kept in a contiguous open addressing table (linear probing with backward
+ *  shift deletion), so a lookup is typically one hash and one or two adjacent slot
+ *  comparisons. The table is kept at most half full and doubles in size as needed.
+ *
+ *  If an idle time is specified, sessions without incoming datagrams for longer than the
+ *  idle time are removed. The sweep is performed lazily from the message handler (at most
+ *  once per idle time period), or can be invoked directly through @c expire_idle. An
+ *  optional expiry callback is invoked for each removed session.
+ *
+ *  This class is not thread-safe; all methods are expected to be called from within the
+ *  UDP IO handler thread (the thread invoking the message handler), which is the natural
+ *  usage when the session handler performs all of the processing.
+ *
+ *  @tparam S Application state type for each session, which must be default constructible
+ *  and movable.
+ *
+ *  @tparam SH Session handler function object type.
+ *
+ *  @tparam IOT IO handler type, defaulted to @c udp_io.
+ */
+template <typename S, typename SH, typename IOT = udp_io>
+class udp_session_demux {
+public:
+  using session_type = basic_udp_session<IOT, S>;
+  using endpoint_type = typename IOT::endpoint_type;
+  using clock = std::chrono::steady_clock;
+  using expiry_cb = std::function<void (session_type&)>;
+
+private:
+  struct slot {
+    std::size_t    hash = 0;
+    bool           occupied = false;
+    session_type   sess;
+  };
+
+  using slots = std::vector<slot>;
+
+private:
+  slots             m_slots;
+  std::size_t       m_size;
+  SH                m_session_hdlr;
+  clock::duration   m_idle_time;
+  expiry_cb         m_expiry_cb;
+  clock::time_point m_next_sweep;
+
+public:
+
+/**
+ *  @brief Construct a @c udp_session_demux.
+ *
+ *  @param session_hdlr Session handler function object, as described in the class
+ *  documentation.
+ *
+ *  @param idle_time Sessions idle for longer than this duration are removed; a zero
+ *  duration (default) disables idle expiry.
+ *
+ *  @param exp_cb Function object invoked with each session that is removed due to idle
+ *  expiry, may be empty.
+ *
+ *  @param initial_capacity Initial number of table slots, rounded up to a power of two.
+ */
+  explicit udp_session_demux(SH session_hdlr,
+                             clock::duration idle_time = clock::duration { },
+                             expiry_cb exp_cb = expiry_cb { },
+                             std::size_t initial_capacity = 64) :
+    m_slots(round_up_pow2(initial_capacity)), m_size(0),
+    m_session_hdlr(std::move(session_hdlr)), m_idle_time(idle_time),
+    m_expiry_cb(std::move(exp_cb)), m_next_sweep(clock::now() + idle_time) { }
+
+/**
+ *  @brief Message handler function call operator, invoked by the UDP IO handler for each
+ *  incoming datagram.
+ *
+ *  @return Always @c true, since a session handler error only removes the session.
+ */
+  bool operator()(std::experimental::net::const_buffer buf, basic_io_interface<IOT> io,
+                  endpoint_type endp) {
+    auto now = clock::now();
+    if (m_idle_time != clock::duration { } && now >= m_next_sweep) {
+      expire_idle(now);
+    }
+    auto h = detail::hash_udp_endpoint(endp);
+    auto idx = find_index(endp, h);
+    if (!m_slots[idx].occupied) {
+      if ((m_size + 1) * 2 > m_slots.size()) {
+        rehash(m_slots.size() * 2);
+        idx = find_index(endp, h);
+      }
+      m_slots[idx].hash = h;
+      m_slots[idx].occupied = true;
+      m_slots[idx].sess = session_type(io, endp, now);
+      ++m_size;
+    }
+    else {
+      m_slots[idx].sess.set_last_activity(now);
+    }
+    if (!m_session_hdlr(buf, m_slots[idx].sess)) {
+      erase_at(idx);
+    }
+    return true;
+  }
+
+/**
+ *  @brief Find the session corresponding to a remote endpoint.
+ *
+ *  @return Pointer to the session, or @c nullptr if not found. The pointer is invalidated
+ *  by any subsequent datagram processing or session removal.
+ */
+  session_type* find(const endpoint_type& endp) noexcept {
+    auto idx = find_index(endp, detail::hash_udp_endpoint(endp));
+    return m_slots[idx].occupied ? &(m_slots[idx].sess) : nullptr;
+  }
+
+/**
+ *  @brief Remove the session corresponding to a remote endpoint.
+ *
+ *  @return @c true if a session was removed.
+ */
+  bool erase(const endpoint_type& endp) {
+    auto idx = find_index(endp, detail::hash_udp_endpoint(endp));
+    if (!m_slots[idx].occupied) {
+      return false;
+    }
+    erase_at(idx);
+    return true;
+  }
+
+/**
+ *  @brief Remove all sessions that have been idle longer than the idle time, relative
+ *  to the supplied time point.
+ *
+ *  @param now Time point used for the comparison, typically @c clock::now().
+ *
+ *  @return Number of sessions removed.
+ */
+  std::size_t expire_idle(clock::time_point now) {
+    m_next_sweep = now + m_idle_time;
+    std::size_t cnt = 0;
+    // swept in place with the backward shift erase; after an erase the same index is 
+    // examined again, since a later session may have been shifted into it (a session
+    // shifted back across the end of the table was already examined, and kept)
+    std::size_t idx = 0;
+    while (idx < m_slots.size()) {
+      auto& s = m_slots[idx];
+      if (!s.occupied || now - s.sess.get_last_activity() <= m_idle_time) {
+        ++idx;
+        continue;
+      }
+      ++cnt;
+      if (m_expiry_cb) {
+        m_expiry_cb(s.sess);
+      }
+      erase_at(idx);
+    }
+    return cnt;
+  }
+
+/**
+ *  @brief Return the number of active sessions.
+ */
+  std::size_t size() const noexcept { return m_size; }
+
+/**
+ *  @brief Return the number of table slots.
+ */
+  std::size_t capacity() const noexcept { return m_slots.size(); }
+
+private:
+
+  static std::size_t round_up_pow2(std::size_t n) noexcept {
+    std::size_t p = 8;
+    while (p < n) {
+      p <<= 1;
+    }
+    return p;
+  }
+
+  std::size_t mask() const noexcept { return m_slots.size() - 1; }
+
+  // returns index of matching slot, or of the empty slot ending the probe sequence
+  std::size_t find_index(const endpoint_type& endp, std::size_t h) const noexcept {
+    auto idx = h & mask();
+    while (m_slots[idx].occupied &&
+           (m_slots[idx].hash != h || m_slots[idx].sess.get_remote_endpoint() != endp)) {
+      idx = (idx + 1) & mask();
+    }
+    return idx;
+  }
+
+  void insert_slot(slot&& s) {
+    auto idx = s.hash & mask();
+    while (m_slots[idx].occupied) {
+      idx = (idx + 1) & mask();
+    }
+    m_slots[idx] = std::move(s);
+    ++m_size;
+  }
+
+  void rehash(std::size_t new_cap) {
+    slots old(new_cap);
+    old.swap(m_slots);
+    m_size = 0;
+    for (auto& s : old) {
+      if (s.occupied) {
+        insert_slot(std::move(s));
+      }
+    }
+  }
+
+  // backward shift deletion keeps probe sequences intact without tombstones
+  void erase_at(std::size_t idx) {
+    auto j = idx;
+    while (true) {
+      j = (j + 1) & mask();
+      if (!m_slots[j].occupied) {
+        break;
+      }
+      auto home = m_slots[j].hash & mask();
+      bool stays = (idx <= j) ? (idx < home && home <= j) : (idx < home || home <= j);
+      if (!stays) {
+        m_slots[idx] = std::move(m_slots[j]);
+        idx = j;
+      }
+    }
+    m_slots[idx] = slot { };
+    --m_size;
+  }
+
+};
+
+/**
+ *  @brief Create a @c udp_session_demux object, deducing the session handler type.
+ *
+ *  @tparam S Application state type for each session.
+ *
+ *  @param session_hdlr Session handler function object.
+ *
+ *  @param idle_time Idle expiry duration, zero disables idle expiry.
+ *
+ *  @param exp_cb Function object invoked for each expired session, may be empty.
+ *
+ *  @return A @c udp_session_demux object.
+ */
+template <typename S, typename IOT = udp_io, typename SH>
+auto make_udp_session_demux(SH&& session_hdlr,
+                            std::chrono::steady_clock::duration idle_time =
+                              std::chrono::steady_clock::duration { },
+                            typename udp_session_demux<S, std::decay_t<SH>, IOT>::expiry_cb exp_cb =
+                              typename udp_session_demux<S, std::decay_t<SH>, IOT>::expiry_cb { }) {
+  return udp_session_demux<S, std::decay_t<SH>, IOT>(std::forward<SH>(session_hdlr),
+                                                     idle_time, std::move(exp_cb));
+}
+
+} // end net namespace
+} // end chops namespace
+
+#endif
@@ -0,0 +1,233 @@
+/** @file
+ *
+ *  @ingroup net_ip_module
+ *
+ *  @brief A scheduler shared by many TCP connectors, limiting the number of connects in
+ *  progress and the rate at which connects are started.
+ *
+ *  Starting thousands of TCP connectors at once sends a burst of SYN packets which can
+ *  overflow the listen backlog of the remote acceptors, and every connect failure is
+ *  then retried at the same reconnect interval, so the burst repeats. Connectors
+ *  attached to a @c connect_scheduler ask for a permit before each connect attempt
+ *  (initial connects and reconnects). A permit is granted when fewer than the maximum
+ *  number of connects are in progress and the connect rate allows, and is given back
+ *  when the connect completes (successfully or not).
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2018 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef CONNECT_SCHEDULER_HPP_INCLUDED
+#define CONNECT_SCHEDULER_HPP_INCLUDED
+
+#include <experimental/io_context>
+#include <experimental/timer>
+
+#include <cstddef> // std::size_t
+#include <chrono>
+#include <functional> // std::function
+#include <memory> // std::shared_ptr, std::enable_shared_from_this
+#include <mutex>
+#include <deque>
+#include <vector>
+#include <utility> // std::move
+#include <algorithm> // std::find_if, std::max
+
+namespace chops {
+namespace net {
+
+/**
+ *  @brief Grant connect permits to TCP connectors, bounding connects in progress and
+ *  connects per second.
+ *
+ *  Permits are granted in request order. Grants are spaced evenly at the configured
+ *  rate, so initial connects of a large number of connectors are spread over time
+ *  rather than bunched at the start of each second.
+ *
+ *  A @c connect_scheduler must be created through @c std::make_shared, and is attached
+ *  to a connector with the @c basic_net_entity @c set_connect_scheduler method. All
+ *  methods are safe to call concurrently from multiple threads.
+ */
+class connect_scheduler : public std::enable_shared_from_this<connect_scheduler> {
+public:
+  using grant_func = std::function<void ()>;
+
+private:
+  using clock_type = std::chrono::steady_clock;
+
+  struct waiter {
+    std::size_t  ticket;
+    grant_func   func;
+  };
+
+private:
+  mutable std::mutex                    m_mutex;
+  std::experimental::net::steady_timer  m_timer;
+  std::size_t                           m_max_in_flight;
+  clock_type::duration                  m_interval;
+  std::size_t                           m_in_flight;
+  std::deque<waiter>                    m_waiters;
+  std::size_t                           m_next_ticket;
+  clock_type::time_point                m_next_grant;
+  bool                                  m_timer_armed;
+
+public:
+
+/**
+ *  @brief Construct a @c connect_scheduler.
+ *
+ *  @param ioc @c io_context used for the rate timer.
+ *
+ *  @param max_in_flight Maximum number of connects in progress, 0 for no limit.
+ *
+ *  @param connects_per_sec Maximum number of connects started per second, 0 for no
+ *  limit.
+ */
+  connect_scheduler(std::experimental::net::io_context& ioc, std::size_t max_in_flight,
+                    std::size_t connects_per_sec) :
+      m_mutex(), m_timer(ioc), m_max_in_flight(max_in_flight),
+      m_interval(connects_per_sec == 0 ? clock_type::duration::zero() :
+                   std::chrono::duration_cast<clock_type::duration>(std::chrono::seconds(1)) /
+                     static_cast<clock_type::rep>(connects_per_sec)),
+      m_in_flight(0), m_waiters(), m_next_ticket(0), m_next_grant(clock_type::now()),
+      m_timer_armed(false) { }
+
+private:
+  // no copy or assignment semantics for this class
+  connect_scheduler(const connect_scheduler&) = delete;
+  connect_scheduler(connect_scheduler&&) = delete;
+  connect_scheduler& operator=(const connect_scheduler&) = delete;
+  connect_scheduler& operator=(connect_scheduler&&) = delete;
+
+public:
+
+/**
+ *  @brief Request a connect permit.
+ *
+ *  The function object is invoked when the permit is granted, possibly from within this
+ *  call, from within a @c release call, or from the @c io_context of the scheduler. It
+ *  should not block. Each granted permit must be given back with @c release.
+ *
+ *  @return A ticket which can be passed to @c cancel.
+ */
+  std::size_t acquire(grant_func func) {
+    std::vector<grant_func> granted;
+    std::size_t ticket;
+    {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      ticket = m_next_ticket++;
+      m_waiters.push_back(waiter { ticket, std::move(func) });
+      granted = collect_grants();
+    }
+    invoke(granted);
+    return ticket;
+  }
+
+/**
+ *  @brief Cancel a permit request which has not yet been granted.
+ *
+ *  @return @c true if the request was removed, @c false if it has already been granted.
+ */
+  bool cancel(std::size_t ticket) {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    auto it = std::find_if(m_waiters.begin(), m_waiters.end(),
+                           [ticket] (const waiter& w) { return w.ticket == ticket; } );
+    if (it == m_waiters.end()) {
+      return false;
+    }
+    m_waiters.erase(it);
+    return true;
+  }
+
+/**
+ *  @brief Give back a granted permit, when the connect attempt has completed.
+ */
+  void release() {
+    std::vector<grant_func> granted;
+    {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      if (m_in_flight > 0) {
+        --m_in_flight;
+      }
+      granted = collect_grants();
+    }
+    invoke(granted);
+  }
+
+/**
+ *  @brief Return the number of granted permits not yet released.
+ */
+  std::size_t in_flight() const {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    return m_in_flight;
+  }
+
+/**
+ *  @brief Return the number of permit requests waiting to be granted.
+ */
+  std::size_t waiting() const {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    return m_waiters.size();
+  }
+
+private:
+
+  // called with the mutex locked, grant functions are invoked after unlocking
+  std::vector<grant_func> collect_grants() {
+    std::vector<grant_func> granted;
+    auto now = clock_type::now();
+    while (!m_waiters.empty() && (m_max_in_flight == 0 || m_in_flight < m_max_in_flight)) {
+      if (m_interval != clock_type::duration::zero()) {
+        if (now < m_next_grant) {
+          arm_timer();
+          break;
+        }
+        // an idle period does not accumulate a burst of grants
+        m_next_grant = std::max(now, m_next_grant) + m_interval;
+      }
+      granted.push_back(std::move(m_waiters.front().func));
+      m_waiters.pop_front();
+      ++m_in_flight;
+    }
+    return granted;
+  }
+
+  void arm_timer() {
+    if (m_timer_armed) {
+      return;
+    }
+    m_timer_armed = true;
+    m_timer.expires_at(m_next_grant);
+    auto self = shared_from_this();
+    m_timer.async_wait( [this, self] (const std::error_code&) {
+        std::vector<grant_func> granted;
+        {
+          std::lock_guard<std::mutex> lk(m_mutex);
+          m_timer_armed = false;
+          granted = collect_grants();
+        }
+        invoke(granted);
+      }
+    );
+  }
+
+  static void invoke(std::vector<grant_func>& granted) {
+    for (auto& f : granted) {
+      f();
+    }
+  }
+
+};
+
+using connect_scheduler_ptr = std::shared_ptr<connect_scheduler>;
+
+} // end net namespace
+} // end chops namespace
+
+#endif
+
@@ -22,12 +22,14 @@
 #include <system_error>
 #include <functional> // std::function, used for type erased notifications to net_entity objects
 #include <memory> // std::shared_ptr
+#include <vector>
 
 #include <experimental/internet>
 #include <experimental/buffer>
 
 #include "net_ip/detail/output_queue.hpp"
 #include "net_ip/queue_stats.hpp"
+#include "net_ip/net_ip_error.hpp"
 #include "utility/shared_buffer.hpp"
 
 namespace chops {
@@ -73,13 +75,46 @@ public:
   // rest of these method called only from within run thread
   bool is_write_in_progress() const noexcept { return m_write_in_progress; }
 
+  // for writes of data staged by the IO handler rather than queued, true if a write 
+  // should be started
+  bool start_write_setup();
+
   bool start_write_setup(const chops::const_shared_buffer&);
   bool start_write_setup(const chops::const_shared_buffer&, const endp_type&);
 
-  outq_opt_el get_next_element();
+  // the completion function object is moved into the queue if the buffer is queued, 
+  // invoked with an error if shutting down, and left in place if a write should start
+  bool start_write_setup(const chops::const_shared_buffer&, send_completion_cb&);
+  bool start_write_setup(const chops::const_shared_buffer&, const endp_type&, 
+                         send_completion_cb&);
+
+  // the parts are moved into the queue if the message is queued, and left in place if a
+  // write should start
+  bool start_write_setup(shared_buffer_parts&);
+  bool start_write_setup(shared_buffer_parts&, const endp_type&);
+
+  // the destinations are moved into the queue if the buffer is queued, and left in place
+  // if a write should start
+  bool start_write_setup(const chops::const_shared_buffer&, std::vector<endp_type>&);
+
+  // if more_to_write is true, a write remains in progress even if the queue is empty
+  outq_opt_el get_next_element(bool more_to_write = false);
+
+  // invoke completion function objects of all queued buffers with an error, clearing
+  // the queue
+  void discard_queued(const std::error_code&);
 
 };
 
+template <typename IOT>
+bool io_common<IOT>::start_write_setup() {
+  if (!m_io_started || m_write_in_progress) {
+    return false;
+  }
+  m_write_in_progress = true;
+  return true;
+}
+
 template <typename IOT>
 bool io_common<IOT>::start_write_setup(const chops::const_shared_buffer& buf) {
   if (!m_io_started) {
@@ -108,12 +143,96 @@ bool io_common<IOT>::start_write_setup(const chops::const_shared_buffer& buf,
 }
 
 template <typename IOT>
-typename io_common<IOT>::outq_opt_el io_common<IOT>::get_next_element() {
+bool io_common<IOT>::start_write_setup(const chops::const_shared_buffer& buf, 
+                                       send_completion_cb& cb) {
+  if (!m_io_started) {
+    if (cb) {
+      cb(std::make_error_code(net_ip_errc::send_discarded), 0);
+    }
+    return false;
+  }
+  if (m_write_in_progress) {
+    m_outq.add_element(buf, std::move(cb));
+    return false;
+  }
+  m_write_in_progress = true;
+  return true;
+}
+
+template <typename IOT>
+bool io_common<IOT>::start_write_setup(const chops::const_shared_buffer& buf, 
+                                       const endp_type& endp, send_completion_cb& cb) {
+  if (!m_io_started) {
+    if (cb) {
+      cb(std::make_error_code(net_ip_errc::send_discarded), 0);
+    }
+    return false;
+  }
+  if (m_write_in_progress) {
+    m_outq.add_element(buf, endp, std::move(cb));
+    return false;
+  }
+  m_write_in_progress = true;
+  return true;
+}
+
+template <typename IOT>
+bool io_common<IOT>::start_write_setup(shared_buffer_parts& parts) {
+  if (!m_io_started) {
+    return false; // shutdown happening or not io_started, don't start a write
+  }
+  if (m_write_in_progress) { // queue message
+    m_outq.add_element(std::move(parts));
+    return false;
+  }
+  m_write_in_progress = true;
+  return true;
+}
+
+template <typename IOT>
+bool io_common<IOT>::start_write_setup(shared_buffer_parts& parts, const endp_type& endp) {
+  if (!m_io_started) {
+    return false; // shutdown happening or not io_started, don't start a write
+  }
+  if (m_write_in_progress) { // queue message
+    m_outq.add_element(std::move(parts), endp);
+    return false;
+  }
+  m_write_in_progress = true;
+  return true;
+}
+
+template <typename IOT>
+bool io_common<IOT>::start_write_setup(const chops::const_shared_buffer& buf, 
+                                       std::vector<endp_type>& endps) {
+  if (!m_io_started) {
+    return false; // shutdown happening or not io_started, don't start a write
+  }
+  if (m_write_in_progress) { // queue buffer and destinations
+    m_outq.add_element(buf, std::move(endps));
+    return false;
+  }
+  m_write_in_progress = true;
+  return true;
+}
+
+template <typename IOT>
+void io_common<IOT>::discard_queued(const std::error_code& err) {
+  while (auto elem = m_outq.get_next_element()) {
+    if (auto cb = elem->cb()) {
+      (*cb)(err, 0);
+    }
+  }
+  m_write_in_progress = false;
+}
+
+template <typename IOT>
+typename io_common<IOT>::outq_opt_el io_common<IOT>::get_next_element(bool more_to_write) {
   if (!m_io_started) { // shutting down
     return outq_opt_el { };
   }
   auto elem = m_outq.get_next_element();
-  m_write_in_progress = elem.has_value();
+  m_write_in_progress = elem.has_value() || more_to_write;
   return elem;
 }
 
@@ -23,9 +23,14 @@
 #include <system_error>
 #include <functional> // std::function, for io state change and error callbacks
 #include <utility> // std::move
+#include <iterator> // std::make_move_iterator
 #include <memory>
+#include <mutex>
+#include <vector>
 #include <cstddef> // std::size_t
 
+#include <experimental/executor>
+
 #include "net_ip/basic_io_interface.hpp"
 
 namespace chops {
@@ -41,23 +46,56 @@ public:
     std::function<void (basic_io_interface<IOT>, std::error_code)>;
 
 private:
-  std::atomic_bool     m_started; // may be called from multiple threads concurrently
-  io_state_chg_cb      m_io_state_chg_cb;
-  error_cb             m_error_cb;
+  // a callback invocation waiting to be delivered through an executor
+  struct deferred_cb {
+    std::shared_ptr<IOT>  ioh;
+    std::error_code       err;
+    std::size_t           num;
+    bool                  starting;
+    bool                  is_err;
+  };
+
+  // shared with posted function objects, so the entity may be destructed before
+  // all callbacks have been delivered
+  struct cb_queue {
+    std::experimental::net::executor  exec;
+    io_state_chg_cb                   io_state_chg;
+    error_cb                          err;
+    std::mutex                        mutex;
+    std::vector<deferred_cb>          pending;
+    bool                              drain_posted = false;
+
+    cb_queue(std::experimental::net::executor ex, io_state_chg_cb ioc, error_cb ec) :
+      exec(ex), io_state_chg(ioc), err(ec), mutex(), pending() { }
+  };
+
+private:
+  std::atomic_bool            m_started; // may be called from multiple threads concurrently
+  io_state_chg_cb             m_io_state_chg_cb;
+  error_cb                    m_error_cb;
+  std::shared_ptr<cb_queue>   m_cb_queue; // only used when a callback executor is supplied
 
 public:
 
-  net_entity_common() noexcept : m_started(false), m_io_state_chg_cb(), m_error_cb() { }
+  net_entity_common() noexcept : m_started(false), m_io_state_chg_cb(), m_error_cb(),
+    m_cb_queue() { }
 
   // following three methods can be called concurrently
   bool is_started() const noexcept { return m_started; }
 
+  // if an executor is supplied, callbacks are posted to it in batches instead of being
+  // invoked from within the io handler thread
   template <typename F1, typename F2>
-  bool start(F1&& io_state_chg_func, F2&& err_func) {
+  bool start(F1&& io_state_chg_func, F2&& err_func, 
+             std::experimental::net::executor cb_exec = std::experimental::net::executor()) {
     bool expected = false;
     if (m_started.compare_exchange_strong(expected, true)) {
       m_io_state_chg_cb = io_state_chg_func;
       m_error_cb = err_func;
+      m_cb_queue.reset();
+      if (cb_exec) {
+        m_cb_queue = std::make_shared<cb_queue>(cb_exec, m_io_state_chg_cb, m_error_cb);
+      }
       return true;
     }
     return false;
@@ -69,13 +107,91 @@ public:
   }
 
   void call_io_state_chg_cb(std::shared_ptr<IOT> p, std::size_t sz, bool starting) {
+    if (m_cb_queue) {
+      deliver(m_cb_queue, deferred_cb { p, std::error_code(), sz, starting, false });
+      return;
+    }
     m_io_state_chg_cb(basic_io_interface<IOT>(p), sz, starting);
   }
 
   void call_error_cb(std::shared_ptr<IOT> p, const std::error_code& err) {
+    if (m_cb_queue) {
+      deliver(m_cb_queue, deferred_cb { p, err, 0, false, true });
+      return;
+    }
     m_error_cb(basic_io_interface<IOT>(p), err);
   }
 
+private:
+
+  // only one drain is posted at a time, which keeps callbacks in order and batches
+  // callbacks arriving while a drain is pending
+  static void deliver(std::shared_ptr<cb_queue> q, deferred_cb cb) {
+    {
+      std::lock_guard<std::mutex> gd { q->mutex };
+      q->pending.push_back(std::move(cb));
+      if (q->drain_posted) {
+        return;
+      }
+      q->drain_posted = true;
+    }
+    std::experimental::net::post(q->exec, [q] { drain(q); } );
+  }
+
+  // if a callback throws, the exception propagates, but the rest of the batch is put 
+  // back in front of any newer callbacks and another drain is posted, so callbacks
+  // for the entity are not left queued forever
+  struct drain_guard {
+    const std::shared_ptr<cb_queue>& q;
+    std::vector<deferred_cb>&        batch;
+    std::size_t&                     next;
+    bool                             done;
+
+    ~drain_guard() {
+      if (done) {
+        return;
+      }
+      {
+        std::lock_guard<std::mutex> gd { q->mutex };
+        q->pending.insert(q->pending.begin(), std::make_move_iterator(batch.begin() + next),
+                          std::make_move_iterator(batch.end()));
+        if (q->pending.empty()) {
+          q->drain_posted = false;
+          return;
+        }
+      }
+      std::experimental::net::post(q->exec, [qp = q] { drain(qp); } );
+    }
+  };
+
+  static void drain(const std::shared_ptr<cb_queue>& q) {
+    std::vector<deferred_cb> batch;
+    std::size_t next = 0;
+    drain_guard guard { q, batch, next, false };
+    while (true) {
+      {
+        std::lock_guard<std::mutex> gd { q->mutex };
+        if (q->pending.empty()) {
+          q->drain_posted = false;
+          guard.done = true;
+          return;
+        }
+        batch.swap(q->pending);
+      }
+      next = 0;
+      while (next < batch.size()) {
+        auto& cb = batch[next++];
+        if (cb.is_err) {
+          q->err(basic_io_interface<IOT>(cb.ioh), cb.err);
+        }
+        else {
+          q->io_state_chg(basic_io_interface<IOT>(cb.ioh), cb.num, cb.starting);
+        }
+      }
+      batch.clear();
+      next = 0;
+    }
+  }
 
 };
 
@@ -4,8 +4,14 @@
  *
  *  @brief Utility class to manage output data queueing.
  *
+ *  Queued buffers are kept in a growable ring of compact elements (the buffer and 
+ *  flags), in contiguous storage. Destination endpoints (only used for UDP), send 
+ *  completion function objects, and the parts of composite messages are kept in their 
+ *  own rings, in queue order, so queues which don't use them pay nothing for them.
+ *
  *  The @c std::atomic counters allow the IO handler to update
- *  while the application queries the stats.
+ *  while the application queries the stats. Only the IO handler writes the counters, 
+ *  so they are published with relaxed stores rather than read-modify-write operations.
  *
  *  @note For internal use only.
  *
@@ -21,31 +27,150 @@
 #ifndef OUTPUT_QUEUE_HPP_INCLUDED
 #define OUTPUT_QUEUE_HPP_INCLUDED
 
-#include <queue>
 #include <atomic>
+#include <memory> // std::allocator, std::allocator_traits
 #include <cstddef> // std::size_t
-#include <utility> // std::pair
+#include <cstdint> // std::uint8_t
+#include <utility> // std::move
+#include <new> // placement new
 #include <optional>
+#include <variant>
+#include <vector>
+#include <algorithm> // std::remove_if
 
 #include "net_ip/queue_stats.hpp"
+#include "net_ip/detail/send_types.hpp"
 #include "utility/shared_buffer.hpp"
 
 namespace chops {
 namespace net {
 namespace detail {
 
+// FIFO ring in contiguous storage, the capacity doubles (and elements are moved) when 
+// full; elements are constructed in place, so no default constructor is needed
+template <typename T>
+class growable_ring {
+private:
+  using alloc_traits = std::allocator_traits<std::allocator<T>>;
+
+private:
+  std::allocator<T> m_alloc;
+  T*                m_buf;
+  std::size_t       m_cap; // zero or a power of two
+  std::size_t       m_head;
+  std::size_t       m_tail;
+
+public:
+  growable_ring() noexcept : m_alloc(), m_buf(nullptr), m_cap(0), m_head(0), m_tail(0) { }
+
+  ~growable_ring() {
+    while (!empty()) {
+      pop();
+    }
+    if (m_buf) {
+      alloc_traits::deallocate(m_alloc, m_buf, m_cap);
+    }
+  }
+
+  growable_ring(const growable_ring&) = delete;
+  growable_ring& operator=(const growable_ring&) = delete;
+
+  bool empty() const noexcept { return m_head == m_tail; }
+  std::size_t size() const noexcept { return m_tail - m_head; }
+  std::size_t capacity() const noexcept { return m_cap; }
+
+  T& front() noexcept { return m_buf[m_head & (m_cap - 1)]; }
+
+  // make room for one more element, so that the following push can't throw if the 
+  // element move constructor doesn't
+  void reserve_one() {
+    if (size() == m_cap) {
+      grow();
+    }
+  }
+
+  void push(T&& val) {
+    reserve_one();
+    ::new (static_cast<void*>(m_buf + (m_tail & (m_cap - 1)))) T(std::move(val));
+    ++m_tail;
+  }
+
+  void pop() noexcept {
+    front().~T();
+    ++m_head;
+  }
+
+private:
+  void grow() {
+    std::size_t new_cap = (m_cap == 0) ? 16 : m_cap * 2;
+    T* new_buf = alloc_traits::allocate(m_alloc, new_cap);
+    std::size_t n = 0;
+    for (; !empty(); ++n) {
+      ::new (static_cast<void*>(new_buf + n)) T(std::move(front()));
+      pop();
+    }
+    if (m_buf) {
+      alloc_traits::deallocate(m_alloc, m_buf, m_cap);
+    }
+    m_buf = new_buf;
+    m_cap = new_cap;
+    m_head = 0;
+    m_tail = n;
+  }
+};
+
+// empty parts of a composite message are dropped, returns false if no parts are left
+inline bool remove_empty_parts(shared_buffer_parts& parts) {
+  parts.erase(std::remove_if(parts.begin(), parts.end(), 
+                             [] (const chops::const_shared_buffer& b) { return b.size() == 0u; }),
+              parts.end());
+  return !parts.empty();
+}
+
 template <typename E>
 class output_queue {
 private:
 
   using opt_endpoint = std::optional<E>;
-  using queue_element = std::pair<chops::const_shared_buffer, opt_endpoint>;
+
+  // a queued buffer has at most one of a send completion function object, the parts
+  // of a composite message, or the destinations of a buffer sent to many
+  using extra_type = std::variant<std::monostate, send_completion_cb, shared_buffer_parts,
+                                  std::vector<E>>;
+
+  // same member names as the std::pair previously used; for a composite message 
+  // first is the first part, and all of the parts are in extra
+  struct queue_element {
+    chops::const_shared_buffer  first;
+    opt_endpoint                second;
+    extra_type                  extra;
+
+    // each returns nullptr if the element doesn't have it
+    send_completion_cb* cb() noexcept { return std::get_if<send_completion_cb>(&extra); }
+    shared_buffer_parts* parts() noexcept { return std::get_if<shared_buffer_parts>(&extra); }
+    std::vector<E>* endps() noexcept { return std::get_if<std::vector<E>>(&extra); }
+  };
+
+  // what is actually stored per queued buffer
+  struct compact_element {
+    chops::const_shared_buffer  buf;
+    std::uint8_t                flags;
+  };
+
+  static constexpr std::uint8_t has_endp = 0x01;
+  static constexpr std::uint8_t has_cb = 0x02;
+  static constexpr std::uint8_t has_parts = 0x04;
+  static constexpr std::uint8_t has_endps = 0x08;
 
 private:
 
-  std::queue<queue_element> m_output_queue;
-  std::atomic_size_t        m_queue_size;
-  std::atomic_size_t        m_current_num_bytes;
+  growable_ring<compact_element>    m_output_queue;
+  growable_ring<E>                  m_endps; // in queue order, for elements with has_endp
+  growable_ring<send_completion_cb> m_cbs;   // in queue order, for elements with has_cb
+  growable_ring<shared_buffer_parts> m_parts; // in queue order, for elements with has_parts
+  growable_ring<std::vector<E>>     m_endp_lists; // in queue order, for elements with has_endps
+  std::atomic_size_t                m_queue_size;
+  std::atomic_size_t                m_current_num_bytes;
   // std::size_t               m_total_bufs_sent;
   // std::size_t               m_total_bytes_sent;
 
@@ -54,30 +179,111 @@ public:
 
 public:
 
-  output_queue() noexcept : m_output_queue(), m_queue_size(0), m_current_num_bytes(0) { }
+  output_queue() noexcept : m_output_queue(), m_endps(), m_cbs(), m_parts(), m_endp_lists(),
+    m_queue_size(0), m_current_num_bytes(0) { }
 
   // io handlers call this method to get next buffer of data, can be empty
   opt_queue_element get_next_element() {
     if (m_output_queue.empty()) {
       return opt_queue_element { };
     }
-    queue_element e = m_output_queue.front();
+    compact_element& ce = m_output_queue.front();
+    opt_queue_element e { queue_element { std::move(ce.buf), opt_endpoint(), extra_type() } };
+    std::size_t num_bytes = e->first.size();
+    if (ce.flags & has_endp) {
+      e->second = m_endps.front();
+      m_endps.pop();
+    }
+    if (ce.flags & has_cb) {
+      e->extra = std::move(m_cbs.front());
+      m_cbs.pop();
+    }
+    else if (ce.flags & has_parts) {
+      num_bytes = parts_size(m_parts.front());
+      e->extra = std::move(m_parts.front());
+      m_parts.pop();
+    }
+    else if (ce.flags & has_endps) {
+      e->extra = std::move(m_endp_lists.front());
+      m_endp_lists.pop();
+    }
     m_output_queue.pop();
-    --m_queue_size;
-    m_current_num_bytes -= e.first.size();
-    return opt_queue_element {e};
+    publish(m_output_queue.size(), 
+            m_current_num_bytes.load(std::memory_order_relaxed) - num_bytes);
+    return e;
   }
 
   void add_element(const chops::const_shared_buffer& buf) {
-    add_element(buf, opt_endpoint());
+    push_element(buf, 0);
   }
 
+  // when an element uses more than the main ring, room is made in every ring it uses 
+  // before anything is pushed, so a failed allocation can't leave the rings out of step
+
   void add_element(const chops::const_shared_buffer& buf, const E& endp) {
-    add_element(buf, opt_endpoint(endp));
+    reserve_one(m_endps);
+    m_endps.push(E(endp));
+    push_element(buf, has_endp);
+  }
+
+  void add_element(const chops::const_shared_buffer& buf, send_completion_cb&& cb) {
+    if (!cb) {
+      push_element(buf, 0);
+      return;
+    }
+    reserve_one(m_cbs);
+    m_cbs.push(std::move(cb));
+    push_element(buf, has_cb);
+  }
+
+  void add_element(const chops::const_shared_buffer& buf, const E& endp, 
+                   send_completion_cb&& cb) {
+    if (!cb) {
+      add_element(buf, endp);
+      return;
+    }
+    reserve_one(m_endps, m_cbs);
+    m_endps.push(E(endp));
+    m_cbs.push(std::move(cb));
+    push_element(buf, has_endp | has_cb);
+  }
+
+  // parts must not be empty
+  void add_element(shared_buffer_parts&& parts) {
+    auto first = parts.front();
+    auto num_bytes = parts_size(parts);
+    reserve_one(m_parts);
+    m_parts.push(std::move(parts));
+    push_element(first, has_parts, num_bytes);
+  }
+
+  void add_element(shared_buffer_parts&& parts, const E& endp) {
+    auto first = parts.front();
+    auto num_bytes = parts_size(parts);
+    reserve_one(m_endps, m_parts);
+    m_endps.push(E(endp));
+    m_parts.push(std::move(parts));
+    push_element(first, has_endp | has_parts, num_bytes);
+  }
+
+  // one element for all of the destinations, endps must not be empty
+  void add_element(const chops::const_shared_buffer& buf, std::vector<E>&& endps) {
+    reserve_one(m_endp_lists);
+    m_endp_lists.push(std::move(endps));
+    push_element(buf, has_endps);
+  }
+
+  static std::size_t parts_size(const shared_buffer_parts& parts) noexcept {
+    std::size_t sz = 0;
+    for (const auto& p : parts) {
+      sz += p.size();
+    }
+    return sz;
   }
 
   chops::net::output_queue_stats get_queue_stats() const noexcept {
-    return chops::net::output_queue_stats { m_queue_size, m_current_num_bytes };
+    return chops::net::output_queue_stats { m_queue_size.load(std::memory_order_relaxed), 
+                                            m_current_num_bytes.load(std::memory_order_relaxed) };
     // return chops::net::output_queue_stats {
     //   m_queue_size, m_current_num_bytes, m_total_bufs_sent, m_total_bytes_sent 
     // };
@@ -85,14 +291,32 @@ public:
 
 private:
 
-  void add_element(const chops::const_shared_buffer& buf, opt_endpoint&& opt_endp) {
-    m_output_queue.push(queue_element(buf, opt_endp));
-    ++m_queue_size;
-    m_current_num_bytes += buf.size(); // note - possible integer overflow
+  template <typename... Rs>
+  void reserve_one(Rs&... side_rings) {
+    m_output_queue.reserve_one();
+    (side_rings.reserve_one(), ...);
+  }
+
+  void push_element(const chops::const_shared_buffer& buf, std::uint8_t flags) {
+    push_element(buf, flags, buf.size());
+  }
+
+  void push_element(const chops::const_shared_buffer& buf, std::uint8_t flags, 
+                    std::size_t num_bytes) {
+    m_output_queue.push(compact_element { buf, flags });
+    // note - possible integer overflow
+    publish(m_output_queue.size(), 
+            m_current_num_bytes.load(std::memory_order_relaxed) + num_bytes);
     // ++m_total_bufs_sent;
     // m_total_bytes_sent += buf.size();
   }
 
+  // only the IO handler thread writes the counters
+  void publish(std::size_t sz, std::size_t num_bytes) noexcept {
+    m_queue_size.store(sz, std::memory_order_relaxed);
+    m_current_num_bytes.store(num_bytes, std::memory_order_relaxed);
+  }
+
 };
 
 } // end detail namespace
@@ -0,0 +1,73 @@
+/** @file 
+ *
+ *  @ingroup net_ip_module
+ *
+ *  @brief Function object and buffer types used when sending, shared by the IO handlers,
+ *  the output queue, and @c basic_io_interface.
+ *
+ *  @note The types are part of the public interface, applications get them through
+ *  @c basic_io_interface.hpp.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2018 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0. 
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef SEND_TYPES_HPP_INCLUDED
+#define SEND_TYPES_HPP_INCLUDED
+
+#include <system_error>
+#include <cstddef> // std::size_t
+#include <functional> // std::function
+#include <vector>
+
+#include <experimental/buffer>
+
+#include "utility/shared_buffer.hpp"
+
+namespace chops {
+namespace net {
+
+/**
+ *  @brief Function object type for send completion notifications.
+ *
+ *  The function object is invoked with a default constructed @c std::error_code and the
+ *  number of bytes written when the buffer has been fully written to the socket. If 
+ *  the buffer is discarded (the IO handler is stopped, or a write error occurs), the 
+ *  function object is invoked with an error code and a byte count of 0.
+ *
+ *  The function object is invoked from within the thread running the network IO, and 
+ *  it must not block.
+ */
+using send_completion_cb = std::function<void (std::error_code, std::size_t)>;
+
+/**
+ *  @brief The parts of a composite message, such as a small per recipient header followed
+ *  by a large body shared between recipients.
+ *
+ *  The parts are queued as one message and written with one scatter-gather write (for UDP,
+ *  as one datagram), so the parts are never copied into a contiguous buffer.
+ */
+using shared_buffer_parts = std::vector<chops::const_shared_buffer>;
+
+/**
+ *  @brief Function object type which encodes one fragment of a large buffer for 
+ *  transmission, used when fragmentation is enabled on a TCP IO handler.
+ *
+ *  The parameters are the fragment bytes, an id unique to the buffer being fragmented
+ *  (fragments of different buffers may be interleaved), the offset of the fragment 
+ *  within the buffer, and the total size of the buffer. The returned buffer (typically
+ *  a fragment header followed by the fragment bytes) is written to the socket.
+ */
+using fragment_encoder = std::function<chops::const_shared_buffer (
+        std::experimental::net::const_buffer, std::size_t, std::size_t, std::size_t)>;
+
+} // end net namespace
+} // end chops namespace
+
+#endif
+
@@ -0,0 +1,290 @@
+/** @file
+ *
+ *  @ingroup net_ip_module
+ *
+ *  @brief Kernel receive and transmit timestamp support, factored out, for TCP and
+ *  UDP io handlers.
+ *
+ *  Software timestamps are enabled through the Linux @c SO_TIMESTAMPING socket option.
+ *  Receive timestamps are read as ancillary data through @c recvmsg, transmit completion
+ *  timestamps are read from the socket error queue. Software timestamps are available
+ *  on any Linux network interface, including loopback. On other platforms enabling
+ *  timestamps fails with an @c operation_not_supported error.
+ *
+ *  @note For internal use only.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2018 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef SOCKET_TIMESTAMPS_HPP_INCLUDED
+#define SOCKET_TIMESTAMPS_HPP_INCLUDED
+
+#include <atomic>
+#include <system_error>
+#include <chrono>
+#include <deque>
+#include <utility> // std::pair
+#include <type_traits> // std::is_invocable_r_v
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint32_t, std::int64_t
+
+#include <experimental/buffer>
+
+#ifdef __linux__
+#include <cerrno>
+#include <ctime> // timespec
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <linux/net_tstamp.h>
+#include <linux/errqueue.h>
+#endif
+
+#include "net_ip/basic_io_interface.hpp"
+#include "net_ip/queue_stats.hpp"
+
+namespace chops {
+namespace net {
+namespace detail {
+
+/**
+ *  @brief Kernel software timestamps are taken from the realtime clock.
+ */
+using rx_timestamp = std::chrono::system_clock::time_point;
+
+// true if the message handler takes a kernel receive timestamp as a fourth parameter
+template <typename MH, typename IOT>
+constexpr bool is_timestamp_msg_hdlr =
+  std::is_invocable_r_v<bool, MH&, std::experimental::net::const_buffer,
+                        basic_io_interface<IOT>, typename IOT::endpoint_type, rx_timestamp>;
+
+template <typename IOT, typename MH>
+bool invoke_msg_hdlr(MH& msg_hdlr, std::experimental::net::const_buffer buf,
+                     basic_io_interface<IOT> io, const typename IOT::endpoint_type& endp,
+                     rx_timestamp ts) {
+  if constexpr (is_timestamp_msg_hdlr<MH, IOT>) {
+    return msg_hdlr(buf, io, endp, ts);
+  }
+  else {
+    return msg_hdlr(buf, io, endp);
+  }
+}
+
+#ifdef __linux__
+
+inline rx_timestamp to_rx_timestamp(const timespec& ts) noexcept {
+  return rx_timestamp(std::chrono::duration_cast<rx_timestamp::duration>(
+               std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec)));
+}
+
+inline bool set_timestamping_flags(int fd, int flags, std::error_code& ec) noexcept {
+  if (::setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) != 0) {
+    ec = std::error_code(errno, std::system_category());
+    return false;
+  }
+  return true;
+}
+
+// non-blocking receive, the receive timestamp is filled in if present in the ancillary data,
+// otherwise it is left unchanged; a would_block error is returned if no data is available
+inline std::size_t recv_with_timestamp(int fd, void* data, std::size_t sz,
+                                       void* addr, std::size_t& addr_len,
+                                       rx_timestamp& ts, std::error_code& ec) noexcept {
+  iovec iov { data, sz };
+  alignas(cmsghdr) char ctrl[CMSG_SPACE(sizeof(scm_timestamping))];
+  msghdr msg { };
+  msg.msg_name = addr;
+  msg.msg_namelen = static_cast<socklen_t>(addr_len);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = ctrl;
+  msg.msg_controllen = sizeof(ctrl);
+  auto ret = ::recvmsg(fd, &msg, MSG_DONTWAIT);
+  if (ret < 0) {
+    ec = (errno == EAGAIN || errno == EWOULDBLOCK) ?
+           std::make_error_code(std::errc::operation_would_block) :
+           std::error_code(errno, std::system_category());
+    return 0;
+  }
+  addr_len = msg.msg_namelen;
+  for (auto c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c)) {
+    if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMPING) {
+      // index 0 is the software timestamp
+      ts = to_rx_timestamp(reinterpret_cast<const scm_timestamping*>(CMSG_DATA(c))->ts[0]);
+    }
+  }
+  return static_cast<std::size_t>(ret);
+}
+
+// drain the error queue, invoking the function object with the timestamp key
+// and the transmit timestamp for each timestamp notification
+template <typename F>
+void drain_tx_timestamps(int fd, F&& func) noexcept {
+  while (true) {
+    alignas(cmsghdr) char ctrl[CMSG_SPACE(sizeof(scm_timestamping)) +
+                               CMSG_SPACE(sizeof(sock_extended_err) + sizeof(sockaddr_in6))];
+    msghdr msg { };
+    msg.msg_control = ctrl;
+    msg.msg_controllen = sizeof(ctrl);
+    if (::recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+      return;
+    }
+    const scm_timestamping* tss = nullptr;
+    const sock_extended_err* serr = nullptr;
+    for (auto c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c)) {
+      if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMPING) {
+        tss = reinterpret_cast<const scm_timestamping*>(CMSG_DATA(c));
+      }
+      else if ((c->cmsg_level == IPPROTO_IP && c->cmsg_type == IP_RECVERR) ||
+               (c->cmsg_level == IPPROTO_IPV6 && c->cmsg_type == IPV6_RECVERR)) {
+        serr = reinterpret_cast<const sock_extended_err*>(CMSG_DATA(c));
+      }
+    }
+    if (tss && serr && serr->ee_errno == ENOMSG &&
+        serr->ee_origin == SO_EE_ORIGIN_TIMESTAMPING) {
+      func(serr->ee_data, to_rx_timestamp(tss->ts[0]));
+    }
+  }
+}
+
+#endif
+
+/**
+ *  @brief Keep timestamping state for an IO handler, match transmit timestamps to writes,
+ *  and accumulate output latency statistics.
+ *
+ *  Writes are keyed the same way as the kernel @c SOF_TIMESTAMPING_OPT_ID key: for
+ *  datagram sockets each write increments the key by one, for stream sockets the key is
+ *  the byte offset of the last byte written. The latency is measured from the time the
+ *  buffer is handed to the socket until the kernel transmit timestamp.
+ *
+ *  The statistics can be queried concurrently; all other methods, including the enable
+ *  methods (each sets the combined flags of both directions), are called only from 
+ *  within the socket executor of the IO handler.
+ */
+class socket_timestamps {
+private:
+  using send_entry = std::pair<std::uint32_t, rx_timestamp>;
+
+private:
+  int                       m_flags;
+  std::uint32_t             m_next_key;
+  std::deque<send_entry>    m_pending;
+  std::atomic_size_t        m_num_tx_timestamps;
+  std::atomic<std::int64_t> m_total_ns;
+  std::atomic<std::int64_t> m_max_ns;
+
+public:
+  socket_timestamps() noexcept : m_flags(0), m_next_key(0), m_pending(),
+    m_num_tx_timestamps(0), m_total_ns(0), m_max_ns(0) { }
+
+  // the flag sets share SOF_TIMESTAMPING_SOFTWARE, so only the direction bits are tested
+  bool is_rx_enabled() const noexcept { return (m_flags & rx_bit()) != 0; }
+  bool is_tx_enabled() const noexcept { return (m_flags & tx_bit()) != 0; }
+
+  bool enable_rx(int fd, std::error_code& ec) noexcept { return enable(fd, rx_flags(), ec); }
+  bool enable_tx(int fd, std::error_code& ec) noexcept { return enable(fd, tx_flags(), ec); }
+
+  // called before each write is started, key_incr is 1 for each datagram or number of
+  // bytes for stream sockets
+  void record_write(std::size_t key_incr) {
+    if (!is_tx_enabled()) {
+      return;
+    }
+    m_next_key += static_cast<std::uint32_t>(key_incr);
+    m_pending.emplace_back(m_next_key - 1, std::chrono::system_clock::now());
+  }
+
+  // read all pending transmit timestamps from the error queue
+  void drain_tx(int fd) {
+#ifdef __linux__
+    drain_tx_timestamps(fd, [this] (std::uint32_t key, rx_timestamp ts) {
+        // a timestamp covers every write with a key up to and including its key
+        while (!m_pending.empty() &&
+               static_cast<std::int32_t>(key - m_pending.front().first) >= 0) {
+          record_latency(ts - m_pending.front().second);
+          m_pending.pop_front();
+        }
+      }
+    );
+#endif
+  }
+
+  // number of writes waiting for a transmit timestamp
+  std::size_t pending_size() const noexcept { return m_pending.size(); }
+
+  output_latency_stats get_output_latency_stats() const noexcept {
+    return output_latency_stats { m_num_tx_timestamps,
+                                  std::chrono::nanoseconds(m_total_ns.load()),
+                                  std::chrono::nanoseconds(m_max_ns.load()) };
+  }
+
+private:
+
+  static constexpr int rx_bit() noexcept {
+#ifdef __linux__
+    return SOF_TIMESTAMPING_RX_SOFTWARE;
+#else
+    return 1;
+#endif
+  }
+
+  static constexpr int tx_bit() noexcept {
+#ifdef __linux__
+    return SOF_TIMESTAMPING_TX_SOFTWARE;
+#else
+    return 2;
+#endif
+  }
+
+  static constexpr int rx_flags() noexcept {
+#ifdef __linux__
+    return SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+#else
+    return 1;
+#endif
+  }
+
+  static constexpr int tx_flags() noexcept {
+#ifdef __linux__
+    return SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE |
+           SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY;
+#else
+    return 2;
+#endif
+  }
+
+  bool enable(int fd, int flags, std::error_code& ec) noexcept {
+#ifdef __linux__
+    if (!set_timestamping_flags(fd, m_flags | flags, ec)) {
+      return false;
+    }
+    m_flags |= flags;
+    return true;
+#else
+    ec = std::make_error_code(std::errc::operation_not_supported);
+    return false;
+#endif
+  }
+
+  void record_latency(std::chrono::system_clock::duration d) noexcept {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+    ++m_num_tx_timestamps;
+    m_total_ns += ns;
+    if (ns > m_max_ns) {
+      m_max_ns = ns; // only the IO handler thread writes
+    }
+  }
+
+};
+
+} // end detail namespace
+} // end net namespace
+} // end chops namespace
+
+#endif
@@ -27,12 +27,15 @@
 #include <vector>
 #include <utility> // std::move, std::forward
 #include <cstddef> // for std::size_t
+#include <atomic>
+#include <algorithm> // std::min
 #include <functional> // std::bind
 
 #include "net_ip/detail/tcp_io.hpp"
 #include "net_ip/detail/net_entity_common.hpp"
 
 #include "net_ip/io_interface.hpp"
+#include "net_ip/socket_handoff.hpp"
 
 #include "utility/erase_where.hpp"
 
@@ -51,12 +54,24 @@ private:
   std::vector<tcp_io_ptr>    m_io_handlers;
   endpoint_type              m_acceptor_endp;
   bool                       m_reuse_addr;
+  // a listening socket inherited from another process, assigned in the first start
+  int                        m_inherited_handle;
 
 public:
   tcp_acceptor(std::experimental::net::io_context& ioc, const endpoint_type& endp,
                bool reuse_addr) :
     m_entity_common(), m_acceptor(ioc), m_io_handlers(), m_acceptor_endp(endp), 
-    m_reuse_addr(reuse_addr) { }
+    m_reuse_addr(reuse_addr), m_inherited_handle(-1) { }
+
+  tcp_acceptor(std::experimental::net::io_context& ioc, int inherited_handle) :
+    m_entity_common(), m_acceptor(ioc), m_io_handlers(), m_acceptor_endp(), 
+    m_reuse_addr(true), m_inherited_handle(inherited_handle) { }
+
+  ~tcp_acceptor() {
+    if (m_inherited_handle >= 0) {
+      close_handle(m_inherited_handle);
+    }
+  }
 
 private:
   // no copy or assignment semantics for this class
@@ -72,14 +87,21 @@ public:
   socket_type& get_socket() noexcept { return m_acceptor; }
 
   template <typename F1, typename F2>
-  bool start(F1&& io_state_chg, F2&& err_func) {
-    if (!m_entity_common.start(std::forward<F1>(io_state_chg), std::forward<F2>(err_func))) {
+  bool start(F1&& io_state_chg, F2&& err_func,
+             std::experimental::net::executor cb_exec = std::experimental::net::executor()) {
+    if (!m_entity_common.start(std::forward<F1>(io_state_chg), std::forward<F2>(err_func),
+                                cb_exec)) {
       // already started
       return false;
     }
     try {
-      m_acceptor = socket_type(m_acceptor.get_executor().context(), m_acceptor_endp,
-                               m_reuse_addr);
+      if (m_inherited_handle >= 0) {
+        assign_inherited();
+      }
+      else {
+        m_acceptor = socket_type(m_acceptor.get_executor().context(), m_acceptor_endp,
+                                 m_reuse_addr);
+      }
     }
     catch (const std::system_error& se) {
       m_entity_common.call_error_cb(tcp_io_ptr(), se.code());
@@ -90,23 +112,84 @@ public:
     return true;
   }
 
-  bool stop() {
+  // the handler container is moved out before closing, instead of each handler
+  // being erased one at a time through the notifier callback, which is quadratic in
+  // the number of connections
+  bool stop(bool abortive = false) {
     if (!m_entity_common.stop()) {
       return false; // stop already called
     }
-    auto iohs = m_io_handlers;
-    for (auto i : iohs) {
-      i->stop_io();
-    }
-    // m_io_handlers.clear(); // the stop_io on each tcp_io handler should clear the container
+    auto iohs = std::move(m_io_handlers);
+    m_io_handlers.clear();
+    close_io_handlers(iohs, 0u, iohs.size(), abortive);
     m_entity_common.call_error_cb(tcp_io_ptr(), std::make_error_code(net_ip_errc::tcp_acceptor_stopped));
     std::error_code ec;
     m_acceptor.close(ec);
     return true;
   }
 
+  // number of IO handlers closed by each function object posted in stop_async
+  static constexpr std::size_t stop_chunk_size = 1024u;
+
+  // as stop, but the IO handlers are closed in chunks, each chunk posted to the executor,
+  // so the closes of many connections are spread across the threads running the 
+  // io_context; the acceptor stops accepting immediately, and done is invoked (from 
+  // whichever thread closes the last chunk) once every IO handler has been closed
+  template <typename F>
+  bool stop_async(bool abortive, F&& done) {
+    if (!m_entity_common.stop()) {
+      done();
+      return false; // stop already called
+    }
+    std::error_code ec;
+    m_acceptor.close(ec);
+    auto iohs = std::make_shared<std::vector<tcp_io_ptr>>(std::move(m_io_handlers));
+    m_io_handlers.clear();
+    auto num_chunks = (iohs->size() + stop_chunk_size - 1u) / stop_chunk_size;
+    auto self = shared_from_this();
+    auto finish = [this, self, done = std::forward<F>(done)] () mutable {
+      m_entity_common.call_error_cb(tcp_io_ptr(), 
+                                    std::make_error_code(net_ip_errc::tcp_acceptor_stopped));
+      done();
+    };
+    if (num_chunks == 0u) {
+      finish();
+      return true;
+    }
+    auto remaining = std::make_shared<std::atomic_size_t>(num_chunks);
+    for (std::size_t c = 0u; c < num_chunks; ++c) {
+      std::experimental::net::post(m_acceptor.get_executor(), 
+                                   [this, self, iohs, remaining, finish, c, abortive] () mutable {
+          auto beg = c * stop_chunk_size;
+          close_io_handlers(*iohs, beg, std::min(beg + stop_chunk_size, iohs->size()), abortive);
+          if (--(*remaining) == 0u) {
+            finish();
+          }
+        }
+      );
+    }
+    return true;
+  }
+
 private:
 
+  // the inherited socket is already bound and listening; its endpoint is kept so that a
+  // start after a stop binds the same endpoint
+  void assign_inherited() {
+    auto handle = m_inherited_handle;
+    m_inherited_handle = -1;
+    std::error_code ec;
+    auto prot = handle_protocol<std::experimental::net::ip::tcp>(handle, ec);
+    if (!ec) {
+      m_acceptor.assign(prot, handle, ec);
+    }
+    if (ec) {
+      close_handle(handle);
+      throw std::system_error(ec);
+    }
+    m_acceptor_endp = m_acceptor.local_endpoint();
+  }
+
   void start_accept() {
     using namespace std::placeholders;
 
@@ -119,7 +202,8 @@ private:
           return;
         }
         tcp_io_ptr iop = std::make_shared<tcp_io>(std::move(sock), 
-          tcp_io::entity_notifier_cb(std::bind(&tcp_acceptor::notify_me, shared_from_this(), _1, _2)));
+          tcp_io::entity_notifier_cb(std::bind(&tcp_acceptor::notify_me, shared_from_this(), _1, _2)),
+          tcp_io::entity_notifier_cb(std::bind(&tcp_acceptor::report_error, shared_from_this(), _1, _2)));
         m_io_handlers.push_back(iop);
         m_entity_common.call_io_state_chg_cb(iop, m_io_handlers.size(), true);
         start_accept();
@@ -127,6 +211,24 @@ private:
     );
   }
 
+  // the state change callback count is the number of handlers after the one closed
+  void close_io_handlers(const std::vector<tcp_io_ptr>& iohs, std::size_t beg, std::size_t end,
+                         bool abortive) {
+    for (auto idx = beg; idx < end; ++idx) {
+      const auto& i = iohs[idx];
+      if (!i->is_io_started()) {
+        continue;
+      }
+      i->close(abortive);
+      m_entity_common.call_error_cb(i, std::make_error_code(net_ip_errc::tcp_io_handler_stopped));
+      m_entity_common.call_io_state_chg_cb(i, iohs.size() - 1u - idx, false);
+    }
+  }
+
+  void report_error(std::error_code err, tcp_io_ptr iop) {
+    m_entity_common.call_error_cb(iop, err);
+  }
+
   void notify_me(std::error_code err, tcp_io_ptr iop) {
     iop->close();
     m_entity_common.call_error_cb(iop, err);
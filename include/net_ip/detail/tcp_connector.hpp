@@ -36,6 +36,7 @@
 
 #include "net_ip/endpoints_resolver.hpp"
 #include "net_ip/io_interface.hpp"
+#include "net_ip/connect_scheduler.hpp"
 
 #include <cassert>
 
@@ -71,6 +72,14 @@ private:
   // time to shutdown
   bool                                  m_shutting_down;
 
+  // connect permits, used only when a connect scheduler is attached; the start count
+  // identifies permits granted to a previous start, after a stop
+  connect_scheduler_ptr                 m_scheduler;
+  std::size_t                           m_start_count;
+  std::size_t                           m_permit_ticket;
+  bool                                  m_permit_waiting;
+  bool                                  m_permit_held;
+
 public:
   template <typename Iter>
   tcp_connector(std::experimental::net::io_context& ioc, 
@@ -84,7 +93,12 @@ public:
       m_reconn_time(reconn_time),
       m_remote_host(),
       m_remote_port(),
-      m_shutting_down(false)
+      m_shutting_down(false),
+      m_scheduler(),
+      m_start_count(0),
+      m_permit_ticket(0),
+      m_permit_waiting(false),
+      m_permit_held(false)
     { }
 
   tcp_connector(std::experimental::net::io_context& ioc,
@@ -99,7 +113,12 @@ public:
       m_reconn_time(reconn_time),
       m_remote_host(remote_host),
       m_remote_port(remote_port),
-      m_shutting_down(false)
+      m_shutting_down(false),
+      m_scheduler(),
+      m_start_count(0),
+      m_permit_ticket(0),
+      m_permit_waiting(false),
+      m_permit_held(false)
     { }
 
 private:
@@ -115,13 +134,24 @@ public:
 
   socket_type& get_socket() noexcept { return m_socket; }
 
+  bool set_connect_scheduler(connect_scheduler_ptr sched) {
+    if (is_started()) {
+      return false;
+    }
+    m_scheduler = std::move(sched);
+    return true;
+  }
+
   template <typename F1, typename F2>
-  bool start(F1&& io_state_chg, F2&& err_cb) {
-    if (!m_entity_common.start(std::forward<F1>(io_state_chg), std::forward<F2>(err_cb))) {
+  bool start(F1&& io_state_chg, F2&& err_cb,
+             std::experimental::net::executor cb_exec = std::experimental::net::executor()) {
+    if (!m_entity_common.start(std::forward<F1>(io_state_chg), std::forward<F2>(err_cb),
+                                cb_exec)) {
       // already started
       return false;
     }
     m_shutting_down = false;
+    ++m_start_count;
     // empty endpoints container is the flag that a resolve is needed
     if (m_endpoints.empty()) {
       auto self = shared_from_this();
@@ -145,8 +175,8 @@ public:
     return true;
   }
 
-  bool stop() {
-    if (!close()) {
+  bool stop(bool abortive = false) {
+    if (!close(abortive)) {
       return false;
     }
     m_entity_common.call_error_cb(tcp_io_ptr(), std::make_error_code(net_ip_errc::tcp_connector_stopped));
@@ -156,7 +186,7 @@ public:
 
 private:
 
-  bool close() {
+  bool close(bool abortive) {
     if (!m_entity_common.stop()) {
       return false; // stop already called
     }
@@ -166,7 +196,7 @@ private:
     }
     if (m_io_handler) {
       if (m_io_handler->is_io_started()) {
-        m_io_handler->close();
+        m_io_handler->close(abortive);
       }
       m_io_handler.reset();
     }
@@ -175,12 +205,48 @@ private:
       // or in middle of an async connect
       m_timer.cancel();
     }
+    // a permit granted after this point is given back when its handler runs
+    if (m_permit_waiting) {
+      m_permit_waiting = false;
+      m_scheduler->cancel(m_permit_ticket);
+    }
     std::error_code ec;
     m_socket.close(ec);
     return true;
   }
 
   void start_connect() {
+    if (!m_scheduler) {
+      do_connect();
+      return;
+    }
+    auto self = shared_from_this();
+    auto sched = m_scheduler;
+    auto cnt = m_start_count;
+    m_permit_waiting = true;
+    m_permit_ticket = sched->acquire([this, self, sched, cnt] () {
+        std::experimental::net::post(m_socket.get_executor(), [this, self, sched, cnt] () {
+            if (cnt != m_start_count || m_shutting_down) {
+              sched->release();
+              return;
+            }
+            m_permit_waiting = false;
+            m_permit_held = true;
+            do_connect();
+          }
+        );
+      }
+    );
+  }
+
+  void release_permit() {
+    if (m_permit_held) {
+      m_permit_held = false;
+      m_scheduler->release();
+    }
+  }
+
+  void do_connect() {
     auto self = shared_from_this();
     std::experimental::net::async_connect(m_socket, m_endpoints.cbegin(), m_endpoints.cend(),
           [this, self] 
@@ -193,6 +259,7 @@ private:
   void handle_connect (const std::error_code& err, endpoints_iter /* iter */) {
     using namespace std::placeholders;
 
+    release_permit();
     if (err) {
       m_entity_common.call_error_cb(tcp_io_ptr(), err);
       if (!is_started() || m_shutting_down ) {
@@ -218,10 +285,15 @@ private:
       return;
     }
     m_io_handler = std::make_shared<tcp_io>(std::move(m_socket), 
-      tcp_io::entity_notifier_cb(std::bind(&tcp_connector::notify_me, shared_from_this(), _1, _2)));
+      tcp_io::entity_notifier_cb(std::bind(&tcp_connector::notify_me, shared_from_this(), _1, _2)),
+      tcp_io::entity_notifier_cb(std::bind(&tcp_connector::report_error, shared_from_this(), _1, _2)));
     m_entity_common.call_io_state_chg_cb(m_io_handler, 1, true);
   }
 
+  void report_error(std::error_code err, tcp_io_ptr iop) {
+    m_entity_common.call_error_cb(iop, err);
+  }
+
   void notify_me(std::error_code err, tcp_io_ptr iop) {
     assert (iop == m_io_handler);
 
@@ -27,15 +27,25 @@
 
 #include <cstddef> // std::size_t
 #include <utility> // std::forward, std::move
+#include <type_traits> // std::decay_t
+#include <chrono>
 #include <string>
 #include <string_view>
 #include <functional>
+#include <cstring> // std::memmove
+#include <deque>
+#include <vector>
+#include <array>
+#include <algorithm> // std::min, std::copy_n
 
 #include "net_ip/detail/output_queue.hpp"
 #include "net_ip/detail/io_common.hpp"
+#include "net_ip/detail/socket_timestamps.hpp"
+#include "net_ip/detail/tcp_kernel_stats.hpp"
 #include "net_ip/queue_stats.hpp"
 #include "net_ip/net_ip_error.hpp"
 #include "net_ip/basic_io_interface.hpp"
+#include "net_ip/spsc_msg_ring.hpp"
 #include "utility/shared_buffer.hpp"
 
 namespace chops {
@@ -44,21 +54,48 @@ namespace detail {
 
 std::size_t null_msg_frame (std::experimental::net::mutable_buffer) noexcept;
 
+class tcp_io;
+
+// true if the message handler takes the number of records in the buffer as a fourth
+// parameter, for fixed size record reads
+template <typename MH>
+constexpr bool is_record_batch_msg_hdlr =
+  std::is_invocable_r_v<bool, MH&, std::experimental::net::const_buffer,
+                        basic_io_interface<tcp_io>, std::experimental::net::ip::tcp::endpoint,
+                        std::size_t>;
+
 class tcp_io : public std::enable_shared_from_this<tcp_io> {
 public:
   using socket_type = std::experimental::net::ip::tcp::socket;
   using endpoint_type = std::experimental::net::ip::tcp::endpoint;
   using entity_notifier_cb = std::function<void (std::error_code, std::shared_ptr<tcp_io>)>;
+  using msg_ring = spsc_msg_ring<endpoint_type>;
 
 private:
   using byte_vec = chops::mutable_shared_buffer::byte_vec;
 
+  // small buffer carried inline in a posted function object, when inline sends are enabled
+  struct inline_msg {
+    std::array<std::byte, max_inline_send_size> bytes;
+    std::size_t                                 size;
+  };
+
+  // a large buffer being written in fragments
+  struct frag_msg {
+    chops::const_shared_buffer  buf;
+    std::size_t                 offset;
+    std::size_t                 id;
+    send_completion_cb          cb;
+  };
+
 private:
 
   socket_type            m_socket;
   io_common<tcp_io>      m_io_common;
   entity_notifier_cb     m_notifier_cb;
+  entity_notifier_cb     m_error_cb; // errors which do not stop the IO handler, may be empty
   endpoint_type          m_remote_endp;
+  socket_timestamps      m_timestamps;
 
   // the following members are only used for read processing; they could be 
   // passed through handlers, but are members for simplicity and to reduce 
@@ -66,13 +103,40 @@ private:
   byte_vec               m_byte_vec;
   std::size_t            m_read_size;
   std::string            m_delimiter;
+  rx_timestamp           m_rx_timestamp;
+  // used only when reading directly into an application ring
+  msg_ring*              m_ring;
+  std::function<std::size_t (std::experimental::net::mutable_buffer)> m_ring_frame;
+  std::size_t            m_ring_offset;
+  std::size_t            m_fixed_pending; // partial record bytes, fixed size record reads
+  // completion function object of the write in progress, if any
+  send_completion_cb     m_write_cb;
+  // used only when fragmentation of large buffers is enabled
+  std::size_t            m_frag_size;
+  fragment_encoder       m_frag_encoder;
+  std::deque<frag_msg>   m_frag_msgs;
+  std::size_t            m_frag_next_id;
+  bool                   m_last_write_frag;
+  // used only when inline sends are enabled; small buffers are appended to the fill 
+  // buffer, which is swapped with the write buffer when a write of staged data starts
+  std::size_t            m_inline_max;
+  std::vector<std::byte> m_stage_fill;
+  std::vector<std::byte> m_stage_write;
+  // parts of the composite message being written, and the buffer sequence referencing 
+  // them, which keeps its capacity between writes
+  shared_buffer_parts    m_write_parts;
+  std::vector<std::experimental::net::const_buffer> m_write_seq;
 
 public:
 
-  tcp_io(socket_type sock, entity_notifier_cb cb) noexcept : 
+  tcp_io(socket_type sock, entity_notifier_cb cb, 
+         entity_notifier_cb err_cb = entity_notifier_cb()) noexcept : 
     m_socket(std::move(sock)), m_io_common(), 
-    m_notifier_cb(cb), m_remote_endp(),
-    m_byte_vec(), m_read_size(0), m_delimiter() { }
+    m_notifier_cb(cb), m_error_cb(err_cb), m_remote_endp(), m_timestamps(),
+    m_byte_vec(), m_read_size(0), m_delimiter(), m_rx_timestamp(),
+    m_ring(nullptr), m_ring_frame(), m_ring_offset(0), m_fixed_pending(0), m_write_cb(),
+    m_frag_size(0), m_frag_encoder(), m_frag_msgs(), m_frag_next_id(0), m_last_write_frag(false),
+    m_inline_max(0), m_stage_fill(), m_stage_write(), m_write_parts(), m_write_seq() { }
 
 private:
   // no copy or assignment semantics for this class
@@ -89,13 +153,64 @@ public:
     return m_io_common.get_output_queue_stats();
   }
 
+  output_latency_stats get_output_latency_stats() const noexcept {
+    return m_timestamps.get_output_latency_stats();
+  }
+
+  // only socket queries, safe to call concurrently with reads and writes
+  tcp_kernel_stats get_tcp_kernel_stats() noexcept {
+    std::error_code ec;
+    return sample_tcp_kernel_stats(m_socket.native_handle(), ec);
+  }
+
   bool is_io_started() const noexcept { return m_io_common.is_io_started(); }
 
+  bool enable_fragmentation(std::size_t frag_size, fragment_encoder enc) {
+    if (is_io_started() || frag_size == 0) {
+      return false;
+    }
+    m_frag_size = frag_size;
+    m_frag_encoder = std::move(enc);
+    return true;
+  }
+
+  bool enable_inline_sends(std::size_t max_size) {
+    if (is_io_started() || max_size == 0 || max_size > max_inline_send_size) {
+      return false;
+    }
+    m_inline_max = max_size;
+    return true;
+  }
+
+  // writes read and update the timestamp state, so it is only changed from within the 
+  // socket executor; a failure is reported through the error callback
+  bool enable_tx_timestamps() {
+    auto self { shared_from_this() };
+    post(m_socket.get_executor(), [this, self] {
+        if (m_timestamps.is_tx_enabled()) {
+          return;
+        }
+        std::error_code ec;
+        if (!m_timestamps.enable_tx(m_socket.native_handle(), ec)) {
+          if (m_error_cb) {
+            m_error_cb(ec, self);
+          }
+          return;
+        }
+        start_tx_timestamp_wait();
+      }
+    );
+    return true;
+  }
+
   template <typename MH, typename MF>
   bool start_io(std::size_t header_size, MH&& msg_handler, MF&& msg_frame) {
     if (!start_io_setup()) {
       return false;
     }
+    if constexpr (is_timestamp_msg_hdlr<std::decay_t<MH>, tcp_io>) {
+      enable_rx_timestamps();
+    }
     m_read_size = header_size;
     m_byte_vec.resize(m_read_size);
     start_read(std::experimental::net::mutable_buffer(m_byte_vec.data(), m_byte_vec.size()),
@@ -105,6 +220,8 @@ public:
 
   template <typename MH>
   bool start_io(std::string_view delimiter, MH&& msg_handler) {
+    static_assert(!is_timestamp_msg_hdlr<std::decay_t<MH>, tcp_io>,
+                  "Receive timestamps are not supported for delimiter based reads");
     if (!start_io_setup()) {
       return false;
     }
@@ -118,6 +235,46 @@ public:
     return start_io(read_size, std::forward<MH>(msg_handler), null_msg_frame);
   }
 
+  template <typename MH>
+  bool start_io_fixed(std::size_t record_size, std::size_t max_records, MH&& msg_handler) {
+    if (!start_io_setup()) {
+      return false;
+    }
+    m_read_size = record_size;
+    m_fixed_pending = 0;
+    m_byte_vec.resize(record_size * (max_records == 0 ? 1 : max_records)); // only resize
+    start_read_fixed(std::forward<MH>(msg_handler));
+    return true;
+  }
+
+  template <typename MF>
+  bool start_io(msg_ring& ring, std::size_t header_size, MF&& msg_frame) {
+    if (!start_io_setup()) {
+      return false;
+    }
+    m_read_size = header_size;
+    m_ring = &ring;
+    m_ring_frame = std::forward<MF>(msg_frame);
+    std::weak_ptr<tcp_io> wp = weak_from_this();
+    ring.set_resume_cb([wp] {
+        if (auto self = wp.lock()) {
+          post(self->m_socket.get_executor(), [self] {
+              if (self->is_io_started()) {
+                self->start_ring_msg();
+              }
+            }
+          );
+        }
+      }
+    );
+    start_ring_msg();
+    return true;
+  }
+
+  bool start_io(msg_ring& ring, std::size_t read_size) {
+    return start_io(ring, read_size, null_msg_frame);
+  }
+
   bool start_io() {
     return start_io(1, 
                     [] (std::experimental::net::const_buffer, basic_io_interface<tcp_io>, 
@@ -139,34 +296,95 @@ public:
     return false;
   }
 
-  // use post for thread safety, multiple threads can call this method
+  // use post for thread safety, multiple threads can call this method; without inline
+  // sends enabled every buffer (including an empty one) is sent as a shared buffer
+  void send(const void* buf, std::size_t sz) {
+    if (m_inline_max == 0 || sz > m_inline_max) {
+      send(chops::const_shared_buffer(buf, sz));
+      return;
+    }
+    inline_msg msg;
+    std::copy_n(static_cast<const std::byte*>(buf), sz, msg.bytes.data());
+    msg.size = sz;
+    auto self { shared_from_this() };
+    post(m_socket.get_executor(), [this, self, msg] { stage_inline(msg); } );
+  }
+
   void send(chops::const_shared_buffer buf) {
     auto self { shared_from_this() };
-    post(m_socket.get_executor(), [this, self, buf] {
-        if (!m_io_common.start_write_setup(buf)) {
-          return; // buf queued or shutdown happening
+    post(m_socket.get_executor(), [this, self, buf] { send_direct(buf); } );
+  }
+
+  // must be called from within the socket executor, allowing many buffers (possibly for
+  // many IO handlers) to be sent from one posted function object
+  void send_direct(const chops::const_shared_buffer& buf) {
+    seal_stage();
+    if (!m_io_common.start_write_setup(buf)) {
+      return; // buf queued or shutdown happening
+    }
+    start_write(buf, send_completion_cb());
+  }
+
+  void send(chops::const_shared_buffer buf, send_completion_cb cb) {
+    auto self { shared_from_this() };
+    post(m_socket.get_executor(), [this, self, buf, cb = std::move(cb)] () mutable {
+        seal_stage();
+        if (!m_io_common.start_write_setup(buf, cb)) {
+          return; // buf queued or shutdown happening, cb moved or invoked
+        }
+        start_write(buf, std::move(cb));
+      }
+    );
+  }
+
+  // composite messages are written with one scatter-gather write, and are not fragmented
+  void send(shared_buffer_parts parts) {
+    if (!remove_empty_parts(parts)) {
+      return;
+    }
+    auto self { shared_from_this() };
+    post(m_socket.get_executor(), [this, self, parts = std::move(parts)] () mutable {
+        seal_stage();
+        if (!m_io_common.start_write_setup(parts)) {
+          return; // parts queued or shutdown happening
         }
-        start_write(buf);
+        start_parts_write(std::move(parts));
       }
     );
   }
 
+  void send(shared_buffer_parts parts, const endpoint_type&) {
+    send(std::move(parts));
+  }
+
   void send(const chops::const_shared_buffer& buf, const endpoint_type&) {
     send(buf);
   }
 
+  void send(const chops::const_shared_buffer& buf, const endpoint_type&, 
+            send_completion_cb cb) {
+    send(buf, std::move(cb));
+  }
+
 public:
   // this method can only be called through a net entity, assumes all error codes have already
-  // been reported back to the net entity
-  void close() {
+  // been reported back to the net entity; an abortive close sets a zero linger time, so
+  // the connection is reset instead of gracefully shutdown, and TIME_WAIT is skipped
+  void close(bool abortive = false) {
     if (!m_io_common.stop()) {
       return; // already stopped
     }
 //    auto self { shared_from_this() };
 //    post(m_socket.get_executor(), [this, self] {
-    // attempt graceful shutdown
     std::error_code ec;
-    m_socket.shutdown(std::experimental::net::ip::tcp::socket::shutdown_both, ec);
+    if (abortive) {
+      m_socket.set_option(std::experimental::net::socket_base::linger(true, std::chrono::seconds(0)),
+                          ec);
+    }
+    else {
+      // attempt graceful shutdown
+      m_socket.shutdown(std::experimental::net::ip::tcp::socket::shutdown_both, ec);
+    }
 //    auto self { shared_from_this() };
 //  post(m_socket.get_executor(), [this, self, ec] () mutable { 
     m_socket.close(ec); 
@@ -175,6 +393,20 @@ public:
 
 private:
 
+  // as with transmit timestamps, the timestamp state is only changed from within the 
+  // socket executor; if receive timestamps can't be enabled the error callback is invoked,
+  // and the time of read completion is used instead
+  void enable_rx_timestamps() {
+    auto self { shared_from_this() };
+    post(m_socket.get_executor(), [this, self] {
+        std::error_code ec;
+        if (!m_timestamps.enable_rx(m_socket.native_handle(), ec) && m_error_cb) {
+          m_error_cb(ec, self);
+        }
+      }
+    );
+  }
+
   bool start_io_setup() {
     if (!m_io_common.set_io_started()) { // concurrency protected
       return false;
@@ -190,6 +422,10 @@ private:
 
   template <typename MH, typename MF>
   void start_read(std::experimental::net::mutable_buffer mbuf, MH&& msg_hdlr, MF&& msg_frame) {
+    if constexpr (is_timestamp_msg_hdlr<std::decay_t<MH>, tcp_io>) {
+      start_read_ts(mbuf, 0, std::forward<MH>(msg_hdlr), std::forward<MF>(msg_frame));
+      return;
+    }
     // std::move in lambda instead of std::forward since an explicit copy or move of the function
     // object is desired so there are no dangling references
     auto self { shared_from_this() };
@@ -205,6 +441,93 @@ private:
   void handle_read(std::experimental::net::mutable_buffer, 
                    const std::error_code&, std::size_t, MH&&, MF&&);
 
+  // reads with recvmsg so that the kernel receive timestamp is available, the timestamp
+  // of the last segment completing the buffer is kept
+  template <typename MH, typename MF>
+  void start_read_ts(std::experimental::net::mutable_buffer mbuf, std::size_t num_read,
+                     MH&& msg_hdlr, MF&& msg_frame) {
+    auto self { shared_from_this() };
+    m_socket.async_wait(socket_type::wait_read,
+      [this, self, mbuf, num_read, mh = std::move(msg_hdlr), mf = std::move(msg_frame)]
+            (const std::error_code& err) mutable {
+        handle_wait_read(mbuf, num_read, err, mh, mf);
+      }
+    );
+  }
+
+  template <typename MH, typename MF>
+  void handle_wait_read(std::experimental::net::mutable_buffer, std::size_t, 
+                        const std::error_code&, MH&, MF&);
+
+  void start_tx_timestamp_wait() {
+    auto self { shared_from_this() };
+    m_socket.async_wait(socket_type::wait_error, [this, self] (const std::error_code& err) {
+        if (err || !is_io_started()) {
+          return;
+        }
+        m_timestamps.drain_tx(m_socket.native_handle());
+        start_tx_timestamp_wait();
+      }
+    );
+  }
+
+  void start_ring_msg() {
+    if (m_ring->producer_slot().size() == 0 && m_ring->pause_producer()) {
+      return; // ring is full, the consumer resumes reads when a slot is freed
+    }
+    m_ring_offset = 0;
+    start_ring_read(m_read_size);
+  }
+
+  void start_ring_read(std::size_t read_size) {
+    if (m_ring_offset + read_size > m_ring->slot_size()) {
+      m_notifier_cb(std::make_error_code(net_ip_errc::msg_too_large_for_ring_slot), 
+                    shared_from_this());
+      return;
+    }
+    auto slot = m_ring->producer_slot();
+    std::experimental::net::mutable_buffer mbuf(static_cast<std::byte*>(slot.data()) + m_ring_offset,
+                                                read_size);
+    auto self { shared_from_this() };
+    std::experimental::net::async_read(m_socket, mbuf,
+      [this, self, mbuf] (const std::error_code& err, std::size_t) {
+        handle_ring_read(mbuf, err);
+      }
+    );
+  }
+
+  void handle_ring_read(std::experimental::net::mutable_buffer mbuf, const std::error_code& err) {
+    if (err) {
+      m_notifier_cb(err, shared_from_this());
+      return;
+    }
+    m_ring_offset += mbuf.size();
+    std::size_t next_read_size = m_ring_frame(mbuf);
+    if (next_read_size == 0) { // msg fully received, publish to the consumer
+      m_ring->publish(m_ring_offset, m_remote_endp);
+      start_ring_msg();
+      return;
+    }
+    start_ring_read(next_read_size);
+  }
+
+  // read whatever is available, delivering all complete records and keeping any partial
+  // record at the front of the buffer for the next read
+  template <typename MH>
+  void start_read_fixed(MH&& msg_hdlr) {
+    auto self { shared_from_this() };
+    m_socket.async_read_some(
+      std::experimental::net::mutable_buffer(m_byte_vec.data() + m_fixed_pending, 
+                                             m_byte_vec.size() - m_fixed_pending),
+      [this, self, mh = std::move(msg_hdlr)] (const std::error_code& err, std::size_t nb) mutable {
+        handle_read_fixed(err, nb, std::move(mh));
+      }
+    );
+  }
+
+  template <typename MH>
+  void handle_read_fixed(const std::error_code&, std::size_t, MH&&);
+
   template <typename MH>
   void start_read_until(MH&& msg_hdlr) {
     auto self { shared_from_this() };
@@ -220,7 +543,21 @@ private:
   template <typename MH>
   void handle_read_until(const std::error_code&, std::size_t, MH&&);
 
-  void start_write(chops::const_shared_buffer);
+  void stage_inline(const inline_msg&);
+
+  void seal_stage();
+
+  void start_stage_write();
+
+  void start_write(chops::const_shared_buffer, send_completion_cb&&);
+
+  void write_buf(const chops::const_shared_buffer&);
+
+  void start_parts_write(shared_buffer_parts&&);
+
+  void start_frag_write();
+
+  void discard_frag_msgs(const std::error_code&);
 
   void handle_write(const std::error_code&, std::size_t);
 
@@ -240,8 +577,9 @@ void tcp_io::handle_read(std::experimental::net::mutable_buffer mbuf,
   // assert num_bytes == mbuf.size()
   std::size_t next_read_size = msg_frame(mbuf);
   if (next_read_size == 0) { // msg fully received, now invoke message handler
-    if (!msg_hdlr(std::experimental::net::const_buffer(m_byte_vec.data(), m_byte_vec.size()), 
-                  basic_io_interface<tcp_io>(weak_from_this()), m_remote_endp)) {
+    if (!invoke_msg_hdlr<tcp_io>(msg_hdlr, 
+                  std::experimental::net::const_buffer(m_byte_vec.data(), m_byte_vec.size()), 
+                  basic_io_interface<tcp_io>(weak_from_this()), m_remote_endp, m_rx_timestamp)) {
       // message handler not happy, tear everything down
       m_notifier_cb(std::make_error_code(net_ip_errc::message_handler_terminated), 
                     shared_from_this());
@@ -258,6 +596,79 @@ void tcp_io::handle_read(std::experimental::net::mutable_buffer mbuf,
   start_read(mbuf, std::forward<MH>(msg_hdlr), std::forward<MF>(msg_frame));
 }
 
+template <typename MH, typename MF>
+void tcp_io::handle_wait_read(std::experimental::net::mutable_buffer mbuf, std::size_t num_read,
+                              const std::error_code& err, MH& msg_hdlr, MF& msg_frame) {
+  if (err) {
+    handle_read(mbuf, err, num_read, msg_hdlr, msg_frame);
+    return;
+  }
+  std::error_code ec;
+  std::size_t nb = 0;
+  m_rx_timestamp = std::chrono::system_clock::now(); // replaced by the kernel timestamp
+  auto* ptr = static_cast<char*>(mbuf.data()) + num_read;
+#ifdef __linux__
+  std::size_t addr_len = 0;
+  nb = recv_with_timestamp(m_socket.native_handle(), ptr, mbuf.size() - num_read,
+                           nullptr, addr_len, m_rx_timestamp, ec);
+  if (ec == std::errc::operation_would_block) {
+    start_read_ts(mbuf, num_read, std::move(msg_hdlr), std::move(msg_frame));
+    return;
+  }
+#else
+  nb = m_socket.read_some(std::experimental::net::mutable_buffer(ptr, mbuf.size() - num_read),
+                          ec);
+#endif
+  if (!ec && nb == 0) {
+    ec = std::experimental::net::error::eof;
+  }
+  if (ec) {
+    handle_read(mbuf, ec, num_read, msg_hdlr, msg_frame);
+    return;
+  }
+  num_read += nb;
+  if (num_read < mbuf.size()) {
+    start_read_ts(mbuf, num_read, std::move(msg_hdlr), std::move(msg_frame));
+    return;
+  }
+  handle_read(mbuf, ec, num_read, msg_hdlr, msg_frame);
+}
+
+template <typename MH>
+void tcp_io::handle_read_fixed(const std::error_code& err, std::size_t num_bytes, MH&& msg_hdlr) {
+
+  if (err) {
+    m_notifier_cb(err, shared_from_this());
+    return;
+  }
+  std::size_t total = m_fixed_pending + num_bytes;
+  std::size_t num_recs = total / m_read_size;
+  const std::byte* ptr = m_byte_vec.data();
+  bool ok = true;
+  if constexpr (is_record_batch_msg_hdlr<std::decay_t<MH>>) {
+    ok = num_recs == 0 || 
+         msg_hdlr(std::experimental::net::const_buffer(ptr, num_recs * m_read_size),
+                  basic_io_interface<tcp_io>(weak_from_this()), m_remote_endp, num_recs);
+  }
+  else {
+    for (std::size_t i = 0; ok && i < num_recs; ++i, ptr += m_read_size) {
+      ok = msg_hdlr(std::experimental::net::const_buffer(ptr, m_read_size),
+                    basic_io_interface<tcp_io>(weak_from_this()), m_remote_endp);
+    }
+  }
+  if (!ok) {
+    // message handler not happy, tear everything down
+    m_notifier_cb(std::make_error_code(net_ip_errc::message_handler_terminated), 
+                  shared_from_this());
+    return;
+  }
+  m_fixed_pending = total - num_recs * m_read_size;
+  if (m_fixed_pending > 0 && num_recs > 0) {
+    std::memmove(m_byte_vec.data(), m_byte_vec.data() + num_recs * m_read_size, m_fixed_pending);
+  }
+  start_read_fixed(std::forward<MH>(msg_hdlr));
+}
+
 template <typename MH>
 void tcp_io::handle_read_until(const std::error_code& err, std::size_t num_bytes, MH&& msg_hdlr) {
 
@@ -277,27 +688,168 @@ void tcp_io::handle_read_until(const std::error_code& err, std::size_t num_bytes
 }
 
 
-inline void tcp_io::start_write(chops::const_shared_buffer buf) {
+// staged bytes always follow every queued buffer, so they are written once the queue
+// is empty
+inline void tcp_io::stage_inline(const inline_msg& msg) {
+  if (!is_io_started()) {
+    return;
+  }
+  m_stage_fill.insert(m_stage_fill.end(), msg.bytes.data(), msg.bytes.data() + msg.size);
+  if (m_io_common.start_write_setup()) {
+    start_stage_write();
+  }
+}
+
+// a buffer queued after staged bytes must be written after them, so the staged bytes 
+// are queued first (one allocation for all of the staged messages); staged bytes are 
+// normally only left while a write is in progress, but if not they are written now
+inline void tcp_io::seal_stage() {
+  if (m_stage_fill.empty()) {
+    return;
+  }
+  chops::const_shared_buffer buf(m_stage_fill.data(), m_stage_fill.size());
+  m_stage_fill.clear();
+  if (m_io_common.start_write_setup(buf)) {
+    start_write(buf, send_completion_cb());
+  }
+}
+
+// the staged bytes are written from the write buffer, which is not touched until the
+// write completes; both buffers keep their capacity, so steady state staging does not
+// allocate
+inline void tcp_io::start_stage_write() {
+  m_stage_write.swap(m_stage_fill);
+  m_stage_fill.clear();
+  m_last_write_frag = false;
+  m_timestamps.record_write(m_stage_write.size());
+  auto self { shared_from_this() };
+  std::experimental::net::async_write(m_socket, 
+          std::experimental::net::const_buffer(m_stage_write.data(), m_stage_write.size()),
+            [this, self] (const std::error_code& err, std::size_t nb) {
+      handle_write(err, nb);
+    }
+  );
+}
+
+inline void tcp_io::start_write(chops::const_shared_buffer buf, send_completion_cb&& cb) {
+  if (m_frag_size != 0 && buf.size() > m_frag_size) {
+    m_frag_msgs.push_back(frag_msg { buf, 0, m_frag_next_id++, std::move(cb) });
+    start_frag_write();
+    return;
+  }
+  m_write_cb = std::move(cb);
+  m_last_write_frag = false;
+  write_buf(buf);
+}
+
+// write the next slice of the oldest fragmented buffer, then rotate it to the back so
+// that slices of multiple large buffers are interleaved
+inline void tcp_io::start_frag_write() {
+  auto& fm = m_frag_msgs.front();
+  auto len = std::min(m_frag_size, fm.buf.size() - fm.offset);
+  auto enc = m_frag_encoder(std::experimental::net::const_buffer(fm.buf.data() + fm.offset, len),
+                            fm.id, fm.offset, fm.buf.size());
+  fm.offset += len;
+  if (fm.offset == fm.buf.size()) {
+    if (fm.cb) { // report the size of the whole buffer, not the last fragment
+      m_write_cb = [cb = std::move(fm.cb), sz = fm.buf.size()] (std::error_code err, std::size_t) {
+        cb(err, err ? 0 : sz);
+      };
+    }
+    m_frag_msgs.pop_front();
+  }
+  else if (m_frag_msgs.size() > 1u) {
+    m_frag_msgs.push_back(std::move(fm));
+    m_frag_msgs.pop_front();
+  }
+  m_last_write_frag = true;
+  write_buf(enc);
+}
+
+inline void tcp_io::discard_frag_msgs(const std::error_code& err) {
+  for (auto& fm : m_frag_msgs) {
+    if (fm.cb) {
+      fm.cb(err, 0);
+    }
+  }
+  m_frag_msgs.clear();
+}
+
+// the buffer is captured so that it stays alive until the write completes, since an 
+// encoded fragment is not referenced anywhere else
+inline void tcp_io::write_buf(const chops::const_shared_buffer& buf) {
+  m_timestamps.record_write(buf.size());
   auto self { shared_from_this() };
   std::experimental::net::async_write(m_socket, 
           std::experimental::net::const_buffer(buf.data(), buf.size()),
+            [this, self, buf] (const std::error_code& err, std::size_t nb) {
+      handle_write(err, nb);
+    }
+  );
+}
+
+// the parts are kept in a member until the write completes
+inline void tcp_io::start_parts_write(shared_buffer_parts&& parts) {
+  m_write_parts = std::move(parts);
+  m_write_seq.clear();
+  std::size_t total = 0;
+  for (const auto& p : m_write_parts) {
+    m_write_seq.emplace_back(p.data(), p.size());
+    total += p.size();
+  }
+  m_last_write_frag = false;
+  m_timestamps.record_write(total);
+  auto self { shared_from_this() };
+  std::experimental::net::async_write(m_socket, m_write_seq,
             [this, self] (const std::error_code& err, std::size_t nb) {
       handle_write(err, nb);
     }
   );
 }
 
-inline void tcp_io::handle_write(const std::error_code& err, std::size_t /* num_bytes */) {
+inline void tcp_io::handle_write(const std::error_code& err, std::size_t num_bytes) {
+  m_write_parts.clear(); // release shared bodies as soon as they are written
+  if (m_write_cb) {
+    send_completion_cb cb { std::move(m_write_cb) };
+    m_write_cb = nullptr;
+    cb(err, err ? 0 : num_bytes);
+  }
   if (err) {
     // read pops first, so usually no error is needed in write handlers
     // m_notifier_cb(err, shared_from_this());
+    m_io_common.discard_queued(err);
+    discard_frag_msgs(err);
+    m_stage_fill.clear();
+    return;
+  }
+  bool frag_pending = !m_frag_msgs.empty();
+  bool stage_pending = !m_stage_fill.empty();
+  // after a fragment, a queued buffer (if any) is written before the next fragment
+  if (!frag_pending || m_last_write_frag) {
+    auto elem = m_io_common.get_next_element(frag_pending || stage_pending);
+    if (elem) {
+      if (auto parts = elem->parts()) {
+        start_parts_write(std::move(*parts));
+        return;
+      }
+      auto cb = elem->cb();
+      start_write(elem->first, cb ? std::move(*cb) : send_completion_cb());
+      return;
+    }
+  }
+  if (!is_io_started()) { // shutting down, buffers may be left in the queue
+    m_io_common.discard_queued(std::make_error_code(net_ip_errc::send_discarded));
+    discard_frag_msgs(std::make_error_code(net_ip_errc::send_discarded));
+    m_stage_fill.clear();
     return;
   }
-  auto elem = m_io_common.get_next_element();
-  if (!elem) {
+  if (stage_pending && (!frag_pending || m_last_write_frag)) {
+    start_stage_write();
     return;
   }
-  start_write(elem->first);
+  if (frag_pending) {
+    start_frag_write();
+  }
 }
 
 using tcp_io_ptr = std::shared_ptr<tcp_io>;
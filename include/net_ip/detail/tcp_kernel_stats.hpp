@@ -0,0 +1,112 @@
+/** @file
+ *
+ *  @ingroup net_ip_module
+ *
+ *  @brief Sample kernel TCP connection state and socket queue sizes.
+ *
+ *  A sample is one @c getsockopt and two @c ioctl calls, cheap enough to be performed
+ *  periodically on every connection.
+ *
+ *  @note For internal use only.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2018 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef TCP_KERNEL_STATS_HPP_INCLUDED
+#define TCP_KERNEL_STATS_HPP_INCLUDED
+
+#include <system_error>
+#include <chrono>
+#include <cstdint> // std::uint32_t, std::uint64_t
+
+#ifdef __linux__
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <linux/sockios.h>
+#endif
+
+#include "net_ip/queue_stats.hpp"
+
+namespace chops {
+namespace net {
+namespace detail {
+
+#ifdef __linux__
+
+// the glibc tcp_info lags the kernel definition; the kernel fills in as much as it has,
+// later fields stay zero on older kernels
+struct tcp_info_ext {
+  ::tcp_info    base;
+  std::uint64_t pacing_rate;
+  std::uint64_t max_pacing_rate;
+  std::uint64_t bytes_acked;
+  std::uint64_t bytes_received;
+  std::uint32_t segs_out;
+  std::uint32_t segs_in;
+  std::uint32_t notsent_bytes;
+  std::uint32_t min_rtt;
+  std::uint32_t data_segs_in;
+  std::uint32_t data_segs_out;
+  std::uint64_t delivery_rate;
+};
+
+#endif
+
+inline tcp_kernel_stats sample_tcp_kernel_stats(int fd, std::error_code& ec) noexcept {
+  tcp_kernel_stats st { };
+#ifdef __linux__
+  tcp_info_ext info { };
+  socklen_t len = sizeof(info);
+  if (::getsockopt(fd, IPPROTO_TCP, TCP_INFO, &info, &len) != 0) {
+    ec = std::error_code(errno, std::system_category());
+    return st;
+  }
+  st.rtt = std::chrono::microseconds(info.base.tcpi_rtt);
+  st.rtt_var = std::chrono::microseconds(info.base.tcpi_rttvar);
+  st.snd_cwnd = info.base.tcpi_snd_cwnd;
+  st.total_retrans = info.base.tcpi_total_retrans;
+  st.delivery_rate = info.delivery_rate;
+  st.unsent_bytes = info.notsent_bytes;
+  int outq = 0;
+  int inq = 0;
+  if (::ioctl(fd, SIOCOUTQ, &outq) != 0 || ::ioctl(fd, SIOCINQ, &inq) != 0) {
+    ec = std::error_code(errno, std::system_category());
+    return st;
+  }
+  st.send_queue_bytes = static_cast<std::size_t>(outq);
+  st.recv_queue_bytes = static_cast<std::size_t>(inq);
+#else
+  ec = std::make_error_code(std::errc::operation_not_supported);
+#endif
+  return st;
+}
+
+// combine samples from multiple connections: queue sizes, retransmits and delivery
+// rates are summed, round trip times are the maximum of the samples
+inline tcp_kernel_stats accumulate_tcp_kernel_stats(tcp_kernel_stats tot,
+                                                    const tcp_kernel_stats& st) noexcept {
+  tot.rtt = (st.rtt > tot.rtt) ? st.rtt : tot.rtt;
+  tot.rtt_var = (st.rtt_var > tot.rtt_var) ? st.rtt_var : tot.rtt_var;
+  tot.snd_cwnd += st.snd_cwnd;
+  tot.total_retrans += st.total_retrans;
+  tot.delivery_rate += st.delivery_rate;
+  tot.send_queue_bytes += st.send_queue_bytes;
+  tot.unsent_bytes += st.unsent_bytes;
+  tot.recv_queue_bytes += st.recv_queue_bytes;
+  return tot;
+}
+
+} // end detail namespace
+} // end net namespace
+} // end chops namespace
+
+#endif
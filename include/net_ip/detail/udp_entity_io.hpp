@@ -23,19 +23,31 @@
 #include <experimental/internet>
 #include <experimental/buffer>
 
-#include <memory> // std::shared_ptr, std::enable_shared_from_this
+#include <memory> // std::shared_ptr, std::enable_shared_from_this, std::unique_ptr
 #include <system_error>
 
 #include <cstddef> // std::size_t
+#include <cstdint> // std::uint64_t
+#include <atomic>
+#include <vector>
 #include <utility> // std::forward, std::move
+#include <type_traits> // std::decay_t
+#include <chrono>
 
 #include "net_ip/detail/io_common.hpp"
 #include "net_ip/detail/net_entity_common.hpp"
 #include "net_ip/detail/output_queue.hpp"
+#include "net_ip/detail/socket_timestamps.hpp"
 
 #include "net_ip/queue_stats.hpp"
 #include "net_ip/net_ip_error.hpp"
 #include "net_ip/basic_io_interface.hpp"
+#include "net_ip/spsc_msg_ring.hpp"
+#include "net_ip/socket_filter.hpp"
+#include "net_ip/packet_ring.hpp"
+#include "net_ip/socket_handoff.hpp"
+#include "net_ip/detail/udp_rx_stats.hpp"
+#include "net_ip/detail/udp_send_many.hpp"
 #include "utility/shared_buffer.hpp"
 
 namespace chops {
@@ -50,6 +62,9 @@ public:
 private:
   using byte_vec = chops::mutable_shared_buffer::byte_vec;
 
+  // reads between samples of the kernel drop counter, when autotuning is enabled
+  static constexpr std::size_t rcvbuf_check_interval = 256u;
+
 private:
 
   io_common<udp_entity_io>          m_io_common;
@@ -57,6 +72,15 @@ private:
   socket_type                       m_socket;
   endpoint_type                     m_local_endp;
   endpoint_type                     m_default_dest_endp;
+  socket_timestamps                 m_timestamps;
+  socket_filter                     m_filter; // re-attached each time the socket is opened
+  send_completion_cb                m_write_cb; // of the write in progress, if any
+  // parts of the composite datagram being written, and the buffer sequence referencing them
+  shared_buffer_parts               m_write_parts;
+  std::vector<std::experimental::net::const_buffer> m_write_seq;
+  // destinations of the buffer being sent to many, and the next one to send to
+  std::vector<endpoint_type>        m_many_endps;
+  std::size_t                       m_many_next;
   // TODO: multicast stuff
 
   // following members could be passed through handler, but are members for 
@@ -64,13 +88,42 @@ private:
   byte_vec                          m_byte_vec;
   std::size_t                       m_max_size;
   endpoint_type                     m_sender_endp;
+  rx_timestamp                      m_rx_timestamp;
+  spsc_msg_ring<endpoint_type>*     m_ring; // only used when reading into an application ring
+  std::unique_ptr<packet_ring>      m_pkt_ring; // only used when reading from a packet ring
+  // while set, the UDP socket has the reject all filter and socket filters are refused
+  std::atomic<bool>                 m_pkt_ring_active;
+  int                               m_inherited_handle; // assigned in the first start
+  // receive buffer autotuning, a zero maximum means autotuning is off
+  std::size_t                       m_rcvbuf_max;
+  std::size_t                       m_reads_since_check;
+  std::uint64_t                     m_last_drops;
+  std::atomic<std::size_t>          m_rcvbuf_grows;
 
 public:
   udp_entity_io(std::experimental::net::io_context& ioc, 
                 const endpoint_type& local_endp) noexcept : 
     m_io_common(), m_entity_common(), 
-    m_socket(ioc), m_local_endp(local_endp), m_default_dest_endp(), 
-    m_byte_vec(), m_max_size(0), m_sender_endp() { }
+    m_socket(ioc), m_local_endp(local_endp), m_default_dest_endp(), m_timestamps(),
+    m_filter(), m_write_cb(), m_write_parts(), m_write_seq(), m_many_endps(), m_many_next(0),
+    m_byte_vec(), m_max_size(0), m_sender_endp(), m_rx_timestamp(),
+    m_ring(nullptr), m_pkt_ring(), m_pkt_ring_active(false), m_inherited_handle(-1),
+    m_rcvbuf_max(0), m_reads_since_check(0), m_last_drops(0), m_rcvbuf_grows(0) { }
+
+  udp_entity_io(std::experimental::net::io_context& ioc, int inherited_handle) noexcept : 
+    m_io_common(), m_entity_common(), 
+    m_socket(ioc), m_local_endp(), m_default_dest_endp(), m_timestamps(),
+    m_filter(), m_write_cb(), m_write_parts(), m_write_seq(), m_many_endps(), m_many_next(0),
+    m_byte_vec(), m_max_size(0), m_sender_endp(), m_rx_timestamp(),
+    m_ring(nullptr), m_pkt_ring(), m_pkt_ring_active(false), 
+    m_inherited_handle(inherited_handle),
+    m_rcvbuf_max(0), m_reads_since_check(0), m_last_drops(0), m_rcvbuf_grows(0) { }
+
+  ~udp_entity_io() {
+    if (m_inherited_handle >= 0) {
+      close_handle(m_inherited_handle);
+    }
+  }
 
 private:
   // no copy or assignment semantics for this class
@@ -94,21 +147,103 @@ public:
     return m_io_common.get_output_queue_stats();
   }
 
+  output_latency_stats get_output_latency_stats() const noexcept {
+    return m_timestamps.get_output_latency_stats();
+  }
+
+  udp_rx_stats get_udp_rx_stats() noexcept {
+    std::error_code ec;
+    auto st = sample_udp_rx_stats(m_socket.native_handle(), ec);
+    st.rcvbuf_grows = m_rcvbuf_grows.load();
+    return st;
+  }
+
+  bool enable_rcvbuf_autotune(std::size_t max_size) {
+    auto self { shared_from_this() };
+    post(m_socket.get_executor(), [this, self, max_size] {
+        m_rcvbuf_max = max_size;
+        m_reads_since_check = 0;
+        std::error_code ec;
+        m_last_drops = sample_udp_rx_stats(m_socket.native_handle(), ec).drops;
+      }
+    );
+    return true;
+  }
+
+  // writes read and update the timestamp state, so it is only changed from within the 
+  // socket executor; a failure is reported through the error callback
+  bool enable_tx_timestamps() {
+    auto self { shared_from_this() };
+    post(m_socket.get_executor(), [this, self] {
+        if (m_timestamps.is_tx_enabled()) {
+          return;
+        }
+        std::error_code ec;
+        if (!m_timestamps.enable_tx(m_socket.native_handle(), ec)) {
+          err_notify(ec);
+          return;
+        }
+        start_tx_timestamp_wait();
+      }
+    );
+    return true;
+  }
+
+  // before start the filter is only stored, and is attached when the socket is opened in
+  // start; afterwards the filter is changed from within the socket executor, as with the
+  // other post-start settings, and a failure is reported through the error callback; a
+  // filter is refused while reading from a packet ring, since replacing the reject all
+  // filter would queue a second, unread, copy of every datagram on the UDP socket
+  bool set_socket_filter(socket_filter filt) {
+    if (m_pkt_ring_active) {
+      return false;
+    }
+    if (!is_started()) {
+      m_filter = std::move(filt);
+      return true;
+    }
+    auto self { shared_from_this() };
+    post(m_socket.get_executor(), [this, self, filt = std::move(filt)] () mutable {
+        if (m_pkt_ring_active) {
+          return;
+        }
+        m_filter = std::move(filt);
+        if (!m_socket.is_open()) {
+          return; // attached when the socket is opened in the next start
+        }
+        std::error_code ec;
+        if (!attach_socket_filter(m_socket.native_handle(), m_filter, ec)) {
+          err_notify(ec);
+        }
+      }
+    );
+    return true;
+  }
+
   template <typename F1, typename F2>
-  bool start(F1&& io_state_chg, F2&& err_cb) {
-    if (!m_entity_common.start(std::forward<F1>(io_state_chg), std::forward<F2>(err_cb))) {
+  bool start(F1&& io_state_chg, F2&& err_cb,
+             std::experimental::net::executor cb_exec = std::experimental::net::executor()) {
+    if (!m_entity_common.start(std::forward<F1>(io_state_chg), std::forward<F2>(err_cb),
+                                cb_exec)) {
       // already started
       return false;
     }
     try {
+      if (m_inherited_handle >= 0) {
+        assign_inherited();
+      }
       // assume default constructed endpoints compare equal
-      if (m_local_endp == endpoint_type()) {
+      else if (m_local_endp == endpoint_type()) {
 // TODO: this needs to be changed, doesn't allow sending to an ipV6 endpoint
         m_socket.open(std::experimental::net::ip::udp::v4());
       }
       else {
         m_socket = socket_type(m_socket.get_executor().context(), m_local_endp);
       }
+      std::error_code ec;
+      if (!m_filter.empty() && !attach_socket_filter(m_socket.native_handle(), m_filter, ec)) {
+        throw std::system_error(ec);
+      }
     }
     catch (const std::system_error& se) {
       err_notify(se.code());
@@ -125,6 +260,7 @@ public:
       return false;
     }
     m_max_size = max_size;
+    enable_rx_timestamps<MH>();
     start_read(std::forward<MH>(msg_handler));
     return true;
   }
@@ -136,10 +272,66 @@ public:
     }
     m_max_size = max_size;
     m_default_dest_endp = endp;
+    enable_rx_timestamps<MH>();
     start_read(std::forward<MH>(msg_handler));
     return true;
   }
 
+  // datagrams larger than the ring slot size are truncated
+  bool start_io(spsc_msg_ring<endpoint_type>& ring) {
+    if (!m_io_common.set_io_started()) { // concurrency protected
+      return false;
+    }
+    std::weak_ptr<udp_entity_io> wp = weak_from_this();
+    ring.set_resume_cb([wp] {
+        if (auto self = wp.lock()) {
+          post(self->m_socket.get_executor(), [self] {
+              if (self->is_io_started()) {
+                self->start_ring_read();
+              }
+            }
+          );
+        }
+      }
+    );
+    m_ring = &ring;
+    start_ring_read();
+    return true;
+  }
+
+  template <typename MH>
+  bool start_io_packet_ring(const packet_ring_params& params, MH&& msg_handler) {
+    if (!m_io_common.set_io_started()) { // concurrency protected
+      return false;
+    }
+    if (!m_pkt_ring) {
+      m_pkt_ring = std::make_unique<packet_ring>(m_socket.get_executor().context());
+    }
+    // the bound port, which differs from the configured one when an ephemeral port is used
+    std::error_code ec;
+    auto port = m_socket.local_endpoint(ec).port();
+    if (!ec) {
+      m_pkt_ring->open(params, port, ec);
+    }
+    if (ec) {
+      err_notify(ec);
+      stop();
+      return false;
+    }
+    // the UDP socket stays open (e.g. for multicast membership), but its copies of the
+    // datagrams are dropped in the kernel
+    m_pkt_ring_active = true;
+    if (!attach_socket_filter(m_socket.native_handle(),
+                              socket_filter { filter_insn { bpf_ret_k, 0u, 0u, bpf_reject } }, 
+                              ec)) {
+      err_notify(ec);
+      stop();
+      return false;
+    }
+    start_packet_ring_read(std::forward<MH>(msg_handler));
+    return true;
+  }
+
   bool start_io() {
     if (!m_io_common.set_io_started()) { // concurrency protected
       return false;
@@ -161,6 +353,10 @@ public:
     }
     std::error_code ec;
     m_socket.close(ec);
+    if (m_pkt_ring) {
+      m_pkt_ring->close();
+    }
+    m_pkt_ring_active = false;
     err_notify(std::make_error_code(net_ip_errc::udp_io_handler_stopped));
     m_entity_common.call_io_state_chg_cb(shared_from_this(), 0, false);
     return true;
@@ -175,13 +371,31 @@ public:
     return true;
   }
 
+  void send(const void* buf, std::size_t sz) {
+    send(chops::const_shared_buffer(buf, sz));
+  }
+
   void send(chops::const_shared_buffer buf) {
     auto self { shared_from_this() };
-    post(m_socket.get_executor(), [this, self, buf] {
-        if (!m_io_common.start_write_setup(buf)) {
-          return; // buf queued or shutdown happening
+    post(m_socket.get_executor(), [this, self, buf] { send_direct(buf); } );
+  }
+
+  // must be called from within the socket executor, allowing many buffers (possibly for
+  // many IO handlers) to be sent from one posted function object
+  void send_direct(const chops::const_shared_buffer& buf) {
+    if (!m_io_common.start_write_setup(buf)) {
+      return; // buf queued or shutdown happening
+    }
+    start_write(buf, m_default_dest_endp, send_completion_cb());
+  }
+
+  void send(chops::const_shared_buffer buf, send_completion_cb cb) {
+    auto self { shared_from_this() };
+    post(m_socket.get_executor(), [this, self, buf, cb = std::move(cb)] () mutable {
+        if (!m_io_common.start_write_setup(buf, cb)) {
+          return; // buf queued or shutdown happening, cb moved or invoked
         }
-        start_write(buf, m_default_dest_endp);
+        start_write(buf, m_default_dest_endp, std::move(cb));
       }
     );
   }
@@ -192,17 +406,92 @@ public:
         if (!m_io_common.start_write_setup(buf, endp)) {
           return; // buf queued or shutdown happening
         }
-        start_write(buf, endp);
+        start_write(buf, endp, send_completion_cb());
+      }
+    );
+  }
+
+  void send(chops::const_shared_buffer buf, const endpoint_type& endp, send_completion_cb cb) {
+    auto self { shared_from_this() };
+    post(m_socket.get_executor(), [this, self, buf, endp, cb = std::move(cb)] () mutable {
+        if (!m_io_common.start_write_setup(buf, endp, cb)) {
+          return; // buf queued or shutdown happening, cb moved or invoked
+        }
+        start_write(buf, endp, std::move(cb));
+      }
+    );
+  }
+
+  // a composite message is sent as one datagram
+  void send(shared_buffer_parts parts) {
+    if (!remove_empty_parts(parts)) {
+      return;
+    }
+    auto self { shared_from_this() };
+    post(m_socket.get_executor(), [this, self, parts = std::move(parts)] () mutable {
+        if (!m_io_common.start_write_setup(parts)) {
+          return; // parts queued or shutdown happening
+        }
+        start_parts_write(std::move(parts), m_default_dest_endp);
+      }
+    );
+  }
+
+  void send(shared_buffer_parts parts, const endpoint_type& endp) {
+    if (!remove_empty_parts(parts)) {
+      return;
+    }
+    auto self { shared_from_this() };
+    post(m_socket.get_executor(), [this, self, parts = std::move(parts), endp] () mutable {
+        if (!m_io_common.start_write_setup(parts, endp)) {
+          return; // parts queued or shutdown happening
+        }
+        start_parts_write(std::move(parts), endp);
+      }
+    );
+  }
+
+  void send_to_many(chops::const_shared_buffer buf, std::vector<endpoint_type> endps) {
+    auto self { shared_from_this() };
+    post(m_socket.get_executor(), [this, self, buf, endps = std::move(endps)] () mutable {
+        if (endps.empty() || !m_io_common.start_write_setup(buf, endps)) {
+          return; // queued as one element, or shutdown happening
+        }
+        start_many_write(buf, std::move(endps));
       }
     );
   }
 
 private:
 
+  template <typename MH>
+  void enable_rx_timestamps() {
+    if constexpr (is_timestamp_msg_hdlr<std::decay_t<MH>, udp_entity_io>) {
+      // changed from within the socket executor, as for transmit timestamps
+      auto self { shared_from_this() };
+      post(m_socket.get_executor(), [this, self] {
+          std::error_code ec;
+          if (!m_timestamps.enable_rx(m_socket.native_handle(), ec)) {
+            err_notify(ec); // timestamps fall back to time of read completion
+          }
+        }
+      );
+    }
+  }
+
   template <typename MH>
   void start_read(MH&& msg_hdlr) {
     auto self { shared_from_this() };
     m_byte_vec.resize(m_max_size);
+    if constexpr (is_timestamp_msg_hdlr<std::decay_t<MH>, udp_entity_io>) {
+      // wait for readability, then read with recvmsg to obtain the ancillary data
+      m_socket.async_wait(socket_type::wait_read,
+                [this, self, mh = std::move(msg_hdlr)] (const std::error_code& err) mutable {
+          handle_wait_read(err, mh);
+        }
+      );
+      return;
+    }
     m_socket.async_receive_from(
               std::experimental::net::mutable_buffer(m_byte_vec.data(), m_byte_vec.size()),
               m_sender_endp,
@@ -213,6 +502,25 @@ private:
     );
   }
 
+  // the inherited socket is already bound (and may have multicast memberships); its 
+  // endpoint is kept so that a start after a stop binds the same endpoint
+  void assign_inherited() {
+    auto handle = m_inherited_handle;
+    m_inherited_handle = -1;
+    std::error_code ec;
+    auto prot = handle_protocol<std::experimental::net::ip::udp>(handle, ec);
+    if (!ec) {
+      m_socket.assign(prot, handle, ec);
+    }
+    if (ec) {
+      close_handle(handle);
+      throw std::system_error(ec);
+    }
+    m_local_endp = m_socket.local_endpoint();
+  }
+
+  void check_rcvbuf();
+
   void err_notify (const std::error_code& err) {
     m_entity_common.call_error_cb(shared_from_this(), err);
   }
@@ -220,7 +528,66 @@ private:
   template <typename MH>
   void handle_read(const std::error_code&, std::size_t, MH&&);
 
-  void start_write(chops::const_shared_buffer, const endpoint_type&);
+  template <typename MH>
+  void handle_wait_read(const std::error_code&, MH&);
+
+  template <typename MH>
+  void start_packet_ring_read(MH&& msg_hdlr) {
+    auto self { shared_from_this() };
+    m_pkt_ring->get_socket().async_wait(packet_ring::wait_socket_type::wait_read,
+                [this, self, mh = std::move(msg_hdlr)] (const std::error_code& err) mutable {
+        handle_packet_ring_read(err, mh);
+      }
+    );
+  }
+
+  template <typename MH>
+  void handle_packet_ring_read(const std::error_code&, MH&);
+
+  void start_ring_read() {
+    auto slot = m_ring->producer_slot();
+    if (slot.size() == 0) {
+      if (m_ring->pause_producer()) {
+        return; // ring is full, the consumer resumes reads when a slot is freed
+      }
+      slot = m_ring->producer_slot();
+    }
+    auto self { shared_from_this() };
+    m_socket.async_receive_from(slot, m_sender_endp,
+              [this, self] (const std::error_code& err, std::size_t nb) {
+        if (err) {
+          err_notify(err);
+          stop();
+          return;
+        }
+        m_ring->publish(nb, m_sender_endp);
+        if (m_rcvbuf_max != 0 && ++m_reads_since_check >= rcvbuf_check_interval) {
+          check_rcvbuf();
+        }
+        start_ring_read();
+      }
+    );
+  }
+
+  void start_tx_timestamp_wait() {
+    auto self { shared_from_this() };
+    m_socket.async_wait(socket_type::wait_error, [this, self] (const std::error_code& err) {
+        if (err) {
+          return;
+        }
+        m_timestamps.drain_tx(m_socket.native_handle());
+        start_tx_timestamp_wait();
+      }
+    );
+  }
+
+  void start_write(chops::const_shared_buffer, const endpoint_type&, send_completion_cb&&);
+
+  void start_many_write(chops::const_shared_buffer, std::vector<endpoint_type>&&);
+
+  void continue_many_write(chops::const_shared_buffer);
+
+  void start_parts_write(shared_buffer_parts&&, const endpoint_type&);
 
   void handle_write(const std::error_code&, std::size_t);
 
@@ -236,17 +603,94 @@ void udp_entity_io::handle_read(const std::error_code& err, std::size_t num_byte
     stop();
     return;
   }
-  if (!msg_hdlr(std::experimental::net::const_buffer(m_byte_vec.data(), num_bytes), 
-                basic_io_interface<udp_entity_io>(weak_from_this()), m_sender_endp)) {
+  if (!invoke_msg_hdlr<udp_entity_io>(msg_hdlr, 
+                std::experimental::net::const_buffer(m_byte_vec.data(), num_bytes), 
+                basic_io_interface<udp_entity_io>(weak_from_this()), m_sender_endp,
+                m_rx_timestamp)) {
     // message handler not happy, tear everything down
     err_notify(std::make_error_code(net_ip_errc::message_handler_terminated));
     stop();
     return;
   }
+  if (m_rcvbuf_max != 0 && ++m_reads_since_check >= rcvbuf_check_interval) {
+    check_rcvbuf();
+  }
   start_read(std::forward<MH>(msg_hdlr));
 }
 
-inline void udp_entity_io::start_write(chops::const_shared_buffer buf, const endpoint_type& endp) {
+// the drop counter is sampled periodically rather than on every read, since it is one
+// system call; the buffer grows by doubling each time new drops are seen
+inline void udp_entity_io::check_rcvbuf() {
+  m_reads_since_check = 0;
+  std::error_code ec;
+  auto st = sample_udp_rx_stats(m_socket.native_handle(), ec);
+  if (ec || st.drops == m_last_drops) {
+    return;
+  }
+  m_last_drops = st.drops;
+  if (grow_udp_rcvbuf(m_socket.native_handle(), st.rcvbuf_size, m_rcvbuf_max, ec)) {
+    ++m_rcvbuf_grows;
+  }
+  else if (ec) {
+    err_notify(ec);
+  }
+}
+
+template <typename MH>
+void udp_entity_io::handle_wait_read(const std::error_code& err, MH& msg_hdlr) {
+
+  if (err) {
+    handle_read(err, 0, msg_hdlr);
+    return;
+  }
+  std::error_code ec;
+  std::size_t nb = 0;
+  m_rx_timestamp = std::chrono::system_clock::now(); // replaced by the kernel timestamp
+#ifdef __linux__
+  std::size_t endp_len = m_sender_endp.capacity();
+  nb = recv_with_timestamp(m_socket.native_handle(), m_byte_vec.data(), m_byte_vec.size(),
+                           m_sender_endp.data(), endp_len, m_rx_timestamp, ec);
+  if (ec == std::errc::operation_would_block) {
+    start_read(std::move(msg_hdlr)); // spurious wakeup, wait again
+    return;
+  }
+  if (!ec) {
+    m_sender_endp.resize(endp_len);
+  }
+#else
+  nb = m_socket.receive_from(std::experimental::net::mutable_buffer(m_byte_vec.data(), 
+                                                                    m_byte_vec.size()),
+                             m_sender_endp, 0, ec);
+#endif
+  handle_read(ec, nb, msg_hdlr);
+}
+
+template <typename MH>
+void udp_entity_io::handle_packet_ring_read(const std::error_code& err, MH& msg_hdlr) {
+
+  if (err) {
+    err_notify(err);
+    stop();
+    return;
+  }
+  basic_io_interface<udp_entity_io> io(weak_from_this());
+  // all packets in the ready blocks are delivered as one batch
+  if (!m_pkt_ring->drain([&msg_hdlr, &io] (std::experimental::net::const_buffer buf,
+                                           const endpoint_type& endp, rx_timestamp ts) {
+          return invoke_msg_hdlr<udp_entity_io>(msg_hdlr, buf, io, endp, ts);
+        }
+      )) {
+    err_notify(std::make_error_code(net_ip_errc::message_handler_terminated));
+    stop();
+    return;
+  }
+  start_packet_ring_read(std::move(msg_hdlr));
+}
+
+inline void udp_entity_io::start_write(chops::const_shared_buffer buf, const endpoint_type& endp,
+                                       send_completion_cb&& cb) {
+  m_write_cb = std::move(cb);
+  m_timestamps.record_write(1);
   auto self { shared_from_this() };
   m_socket.async_send_to(std::experimental::net::const_buffer(buf.data(), buf.size()), endp,
             [this, self] (const std::error_code& err, std::size_t nb) {
@@ -255,17 +699,116 @@ inline void udp_entity_io::start_write(chops::const_shared_buffer buf, const end
   );
 }
 
-inline void udp_entity_io::handle_write(const std::error_code& err, std::size_t /* num_bytes */) {
+// the destinations the socket takes are sent directly (only when no write was in
+// progress, keeping send order), then the next destination is sent asynchronously and
+// the rest continue when it completes; the write stays in progress until every
+// destination has been sent; a send failing for one destination (unreachable, or an
+// endpoint of the wrong address family) is reported through the error callback and that
+// destination is skipped, so one bad destination does not cancel the rest of the fan-out
+inline void udp_entity_io::start_many_write(chops::const_shared_buffer buf,
+                                            std::vector<endpoint_type>&& endps) {
+  m_many_endps = std::move(endps);
+  m_many_next = 0;
+  continue_many_write(buf);
+}
+
+inline void udp_entity_io::continue_many_write(chops::const_shared_buffer buf) {
+  while (m_many_next < m_many_endps.size()) {
+    std::error_code ec;
+    auto sent = send_datagram_to_many(m_socket.native_handle(), buf.data(), buf.size(),
+                                      m_many_endps.data() + m_many_next,
+                                      m_many_endps.size() - m_many_next, ec);
+    if (sent != 0) {
+      m_timestamps.record_write(sent);
+    }
+    m_many_next += sent;
+    if (!ec || ec == std::errc::operation_not_supported) {
+      break; // socket buffer full, or no batched sends, continue asynchronously
+    }
+    err_notify(ec);
+    ++m_many_next; // skip the failed destination
+  }
+  auto self { shared_from_this() };
+  if (m_many_next == m_many_endps.size()) {
+    m_many_endps.clear();
+    // completed through the executor, as an async send would be
+    post(m_socket.get_executor(), [this, self, nb = buf.size()] {
+        handle_write(std::error_code(), nb);
+      }
+    );
+    return;
+  }
+  const auto& endp = m_many_endps[m_many_next++];
+  m_timestamps.record_write(1);
+  m_socket.async_send_to(std::experimental::net::const_buffer(buf.data(), buf.size()), endp,
+            [this, self, buf] (const std::error_code& err, std::size_t) {
+      if (err && (err == std::errc::operation_canceled || !is_io_started())) {
+        m_many_endps.clear();
+        handle_write(err, 0);
+        return;
+      }
+      if (err) {
+        err_notify(err); // this destination only, the rest are still sent
+      }
+      if (m_many_next == m_many_endps.size()) {
+        m_many_endps.clear();
+        handle_write(std::error_code(), buf.size());
+        return;
+      }
+      continue_many_write(buf);
+    }
+  );
+}
+
+// the parts are kept in a member until the write completes
+inline void udp_entity_io::start_parts_write(shared_buffer_parts&& parts, 
+                                             const endpoint_type& endp) {
+  m_write_parts = std::move(parts);
+  m_write_seq.clear();
+  for (const auto& p : m_write_parts) {
+    m_write_seq.emplace_back(p.data(), p.size());
+  }
+  m_timestamps.record_write(1);
+  auto self { shared_from_this() };
+  m_socket.async_send_to(m_write_seq, endp,
+            [this, self] (const std::error_code& err, std::size_t nb) {
+      handle_write(err, nb);
+    }
+  );
+}
+
+inline void udp_entity_io::handle_write(const std::error_code& err, std::size_t num_bytes) {
+  m_write_parts.clear();
+  if (m_write_cb) {
+    send_completion_cb cb { std::move(m_write_cb) };
+    m_write_cb = nullptr;
+    cb(err, err ? 0 : num_bytes);
+  }
   if (err) {
+    m_io_common.discard_queued(err);
     err_notify(err);
     stop();
     return;
   }
   auto elem = m_io_common.get_next_element();
   if (!elem) {
+    if (!is_io_started()) { // shutting down, buffers may be left in the queue
+      m_io_common.discard_queued(std::make_error_code(net_ip_errc::send_discarded));
+    }
+    return;
+  }
+  if (auto parts = elem->parts()) {
+    start_parts_write(std::move(*parts), 
+                      elem->second ? *(elem->second) : m_default_dest_endp);
+    return;
+  }
+  if (auto endps = elem->endps()) {
+    start_many_write(elem->first, std::move(*endps));
     return;
   }
-  start_write(elem->first, elem->second ? *(elem->second) : m_default_dest_endp);
+  auto cb = elem->cb();
+  start_write(elem->first, elem->second ? *(elem->second) : m_default_dest_endp, 
+              cb ? std::move(*cb) : send_completion_cb());
 }
 
 using udp_entity_io_ptr = std::shared_ptr<udp_entity_io>;
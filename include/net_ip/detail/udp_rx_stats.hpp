@@ -0,0 +1,92 @@
+/** @file
+ *
+ *  @ingroup net_ip_module
+ *
+ *  @brief Sample kernel UDP receive buffer state, including the count of datagrams 
+ *  dropped by the kernel, and grow the receive buffer.
+ *
+ *  The drop count is the kernel per socket drop counter, the same value delivered with
+ *  each datagram when the @c SO_RXQ_OVFL socket option is set. It is read with the 
+ *  @c SO_MEMINFO socket option instead, so that it is available without @c recvmsg 
+ *  ancillary data on every read.
+ *
+ *  @note For internal use only.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2018 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef UDP_RX_STATS_HPP_INCLUDED
+#define UDP_RX_STATS_HPP_INCLUDED
+
+#include <system_error>
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint32_t
+
+#ifdef __linux__
+#include <cerrno>
+#include <sys/socket.h>
+#include <linux/sock_diag.h> // SK_MEMINFO_ indices
+#endif
+
+#include "net_ip/queue_stats.hpp"
+
+namespace chops {
+namespace net {
+namespace detail {
+
+inline udp_rx_stats sample_udp_rx_stats(int fd, std::error_code& ec) noexcept {
+  udp_rx_stats st { };
+#ifdef __linux__
+  std::uint32_t mem[SK_MEMINFO_VARS] { };
+  socklen_t len = sizeof(mem);
+  if (::getsockopt(fd, SOL_SOCKET, SO_MEMINFO, mem, &len) != 0) {
+    ec = std::error_code(errno, std::system_category());
+    return st;
+  }
+  st.rcvbuf_size = mem[SK_MEMINFO_RCVBUF];
+  st.rcvbuf_used = mem[SK_MEMINFO_RMEM_ALLOC];
+  // the drops field is not present on kernels older than 4.6
+  if (len >= (SK_MEMINFO_DROPS + 1) * sizeof(std::uint32_t)) {
+    st.drops = mem[SK_MEMINFO_DROPS];
+  }
+#else
+  ec = std::make_error_code(std::errc::operation_not_supported);
+#endif
+  return st;
+}
+
+// double the receive buffer, up to a maximum; the kernel reports (and uses) twice the
+// value set, and limits the value to rmem_max unless the process has CAP_NET_ADMIN
+inline bool grow_udp_rcvbuf(int fd, std::size_t cur_size, std::size_t max_size, 
+                            std::error_code& ec) noexcept {
+#ifdef __linux__
+  if (cur_size >= max_size) {
+    return false;
+  }
+  int val = static_cast<int>(cur_size < max_size / 2u ? cur_size : max_size / 2u);
+  if (::setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &val, sizeof(val)) == 0) {
+    return true;
+  }
+  if (::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &val, sizeof(val)) != 0) {
+    ec = std::error_code(errno, std::system_category());
+    return false;
+  }
+  return true;
+#else
+  ec = std::make_error_code(std::errc::operation_not_supported);
+  return false;
+#endif
+}
+
+} // end detail namespace
+} // end net namespace
+} // end chops namespace
+
+#endif
+
@@ -0,0 +1,84 @@
+/** @file
+ *
+ *  @ingroup net_ip_module
+ *
+ *  @brief Send one datagram to many destination endpoints with batched @c sendmmsg
+ *  system calls.
+ *
+ *  @note For internal use only.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2018 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef UDP_SEND_MANY_HPP_INCLUDED
+#define UDP_SEND_MANY_HPP_INCLUDED
+
+#include <system_error>
+#include <cstddef> // std::size_t
+
+#ifdef __linux__
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/uio.h> // iovec
+#endif
+
+namespace chops {
+namespace net {
+namespace detail {
+
+// destinations per sendmmsg call
+constexpr std::size_t send_many_batch_size = 64u;
+
+// returns the number of datagrams handed to the kernel without blocking; fewer than
+// num_endps are sent if the socket buffer fills (with no error) or a send fails (with ec
+// set), and the remaining destinations are left to the caller
+template <typename Endp>
+std::size_t send_datagram_to_many(int fd, const void* data, std::size_t sz,
+                                  const Endp* endps, std::size_t num_endps,
+                                  std::error_code& ec) noexcept {
+#ifdef __linux__
+  iovec iov { const_cast<void*>(data), sz };
+  mmsghdr msgs[send_many_batch_size];
+  std::size_t sent = 0;
+  while (sent < num_endps) {
+    auto num = (num_endps - sent) < send_many_batch_size ? 
+                 (num_endps - sent) : send_many_batch_size;
+    for (std::size_t i = 0; i < num; ++i) {
+      msgs[i] = mmsghdr { };
+      const auto& endp = endps[sent + i];
+      msgs[i].msg_hdr.msg_name = const_cast<void*>(static_cast<const void*>(endp.data()));
+      msgs[i].msg_hdr.msg_namelen = static_cast<socklen_t>(endp.size());
+      msgs[i].msg_hdr.msg_iov = &iov;
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    int ret = ::sendmmsg(fd, msgs, static_cast<unsigned int>(num), MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (ret < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        ec = std::error_code(errno, std::system_category());
+      }
+      return sent;
+    }
+    sent += static_cast<std::size_t>(ret);
+    if (static_cast<std::size_t>(ret) < num) {
+      return sent;
+    }
+  }
+  return sent;
+#else
+  ec = std::make_error_code(std::errc::operation_not_supported);
+  return 0u;
+#endif
+}
+
+} // end detail namespace
+} // end net namespace
+} // end chops namespace
+
+#endif
+
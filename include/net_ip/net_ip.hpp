@@ -23,6 +23,8 @@
 #include <string_view>
 #include <vector>
 #include <chrono>
+#include <atomic>
+#include <future>
 
 #include <mutex>
 
@@ -201,6 +203,27 @@ public:
     return tcp_acceptor_net_entity(p);
   }
 
+/**
+ *  @brief Create a TCP acceptor @c net_entity from a listening socket handle inherited 
+ *  from another process.
+ *
+ *  The handle is typically received with @c import_socket_handles during a restart, 
+ *  while the previous process is still accepting connections. When @c start is called 
+ *  the handle is assigned to the acceptor instead of binding a local port. If the 
+ *  acceptor is later stopped and started again, the same local endpoint is bound.
+ *
+ *  @param handle Native handle of a bound and listening TCP socket, owned by the
+ *  acceptor from this call on.
+ *
+ *  @return @c tcp_acceptor_net_entity object.
+ */
+  tcp_acceptor_net_entity make_tcp_acceptor_from_handle (int handle) {
+    auto p = std::make_shared<detail::tcp_acceptor>(m_ioc, handle);
+    lg g(m_mutex);
+    m_acceptors.push_back(p);
+    return tcp_acceptor_net_entity(p);
+  }
+
 /**
  *  @brief Create a TCP connector @c net_entity, which will perform an active TCP
  *  connect to the specified host and port (once started).
@@ -352,6 +375,24 @@ public:
     return udp_net_entity(p);
   }
 
+/**
+ *  @brief Create a UDP @c net_entity from a bound UDP socket handle inherited from 
+ *  another process.
+ *
+ *  See @c make_tcp_acceptor_from_handle. Socket options set by the previous process
+ *  (such as multicast group memberships) are kept with the socket.
+ *
+ *  @param handle Native handle of a bound UDP socket, owned by the @c net_entity from 
+ *  this call on.
+ *
+ *  @return @c udp_net_entity object.
+ */
+  udp_net_entity make_udp_unicast_from_handle (int handle) {
+    auto p = std::make_shared<detail::udp_entity_io>(m_ioc, handle);
+    std::experimental::net::post(m_ioc.get_executor(), [p, this] () { m_udp_entities.push_back(p); } );
+    return udp_net_entity(p);
+  }
+
 /**
  *  @brief Create a UDP unicast @c net_entity for sending only (no local bind is performed).
  *
@@ -464,6 +505,60 @@ public:
     for (auto i : m_acceptors) { i->stop(); }
   }
 
+/**
+ *  @brief Stop all acceptors, connectors, and UDP entities in parallel, returning a 
+ *  @c std::future that becomes ready when all of them have been stopped.
+ *
+ *  Instead of stopping each net entity in turn from the calling thread, a stop function 
+ *  object for each net entity is posted to the executor of that net entity, so the 
+ *  stop processing is spread across all threads running the @c io_context. An acceptor
+ *  closes its TCP connections in chunks, each chunk posted separately, so a single 
+ *  acceptor with many connections is also stopped in parallel. The internal lock is 
+ *  held only while the function objects are posted.
+ *
+ *  The executor is the @c io_context executor, not a strand, so the stop processing is 
+ *  not serialized with other processing of a net entity; the same threading rules apply
+ *  as for @c stop_all, which calls @c stop from the calling thread.
+ *
+ *  The @c io_context must be running for the returned @c std::future to become ready.
+ *
+ *  @param abortive If @c true, TCP connections are closed with a zero linger time, 
+ *  resetting the connection instead of a graceful shutdown. This avoids TIME_WAIT 
+ *  state for large numbers of connections, at the cost of discarding any unsent data.
+ *
+ *  @return A @c std::future which becomes ready when all net entities have been stopped.
+ */
+  std::future<void> stop_all_async(bool abortive = false) {
+    auto prom = std::make_shared<std::promise<void>>();
+    auto fut = prom->get_future();
+
+    lg g(m_mutex);
+    auto cnt = std::make_shared<std::atomic_size_t>(m_udp_entities.size() + 
+                                                    m_connectors.size() + m_acceptors.size());
+    if (*cnt == 0u) {
+      prom->set_value();
+      return fut;
+    }
+    auto done = [prom, cnt] () {
+      if (--(*cnt) == 0u) {
+        prom->set_value();
+      }
+    };
+    for (auto i : m_udp_entities) {
+      std::experimental::net::post(i->get_socket().get_executor(), 
+                                   [i, done] () { i->stop(); done(); } );
+    }
+    for (auto i : m_connectors) {
+      std::experimental::net::post(i->get_socket().get_executor(), 
+                                   [i, done, abortive] () { i->stop(abortive); done(); } );
+    }
+    for (auto i : m_acceptors) {
+      std::experimental::net::post(i->get_socket().get_executor(), 
+                                   [i, done, abortive] () { i->stop_async(abortive, done); } );
+    }
+    return fut;
+  }
+
 };
 
 }  // end net namespace
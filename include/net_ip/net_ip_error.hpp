@@ -35,6 +35,8 @@ enum class net_ip_errc {
   tcp_acceptor_stopped = 5,
   tcp_connector_stopped = 6,
   udp_entity_stopped = 7,
+  msg_too_large_for_ring_slot = 8,
+  send_discarded = 9,
 };
 
 namespace detail {
@@ -59,6 +61,10 @@ struct net_ip_err_category : public std::error_category {
       return "tcp connector stopped";
     case net_ip_errc::udp_entity_stopped:
       return "udp entity stopped";
+    case net_ip_errc::msg_too_large_for_ring_slot:
+      return "message too large for ring slot";
+    case net_ip_errc::send_discarded:
+      return "send buffer discarded";
     }
     return "(unknown error)";
   }
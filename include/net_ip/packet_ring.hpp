@@ -0,0 +1,337 @@
+/** @file
+ *
+ *  @ingroup net_ip_module
+ *
+ *  @brief A memory mapped @c AF_PACKET receive ring (Linux @c TPACKET_V3), an optional
+ *  receive engine for UDP IO handlers ingesting high datagram rates.
+ *
+ *  The kernel copies each matching packet into a block of a ring shared with user space,
+ *  and only wakes the reader when a block is full or its timeout expires. All of the
+ *  packets in the ready blocks are then delivered in one batch without any system call
+ *  per datagram. A classic BPF filter on the packet socket selects the UDP destination
+ *  port (and optionally destination addresses) of the IO handler.
+ *
+ *  This works on any Linux interface (including loopback and veth interfaces), but only
+ *  for IPv4, and requires the @c CAP_NET_RAW capability. On other platforms opening the
+ *  ring fails with an @c operation_not_supported error.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2018 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef PACKET_RING_HPP_INCLUDED
+#define PACKET_RING_HPP_INCLUDED
+
+#include <experimental/internet>
+#include <experimental/socket>
+#include <experimental/io_context>
+#include <experimental/buffer>
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <system_error>
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint8_t, std::uint16_t, std::uint32_t
+
+#ifdef __linux__
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <unistd.h> // close
+#include <net/if.h> // if_nametoindex
+#include <arpa/inet.h> // htons
+#include <linux/if_packet.h>
+#include <linux/if_ether.h> // ETH_P_IP
+#endif
+
+#include "net_ip/socket_filter.hpp"
+
+namespace chops {
+namespace net {
+
+/**
+ *  @brief Maximum number of destination addresses in @c packet_ring_params, bounded by
+ *  the 8 bit jump offsets of the classic BPF filter.
+ */
+constexpr std::size_t max_packet_ring_dest_addrs = 248u;
+
+/**
+ *  @brief Parameters of a packet receive ring.
+ *
+ *  The ring memory is @c block_size times @c num_blocks bytes. A block is handed to the
+ *  application when it is full or when @c block_timeout expires after the first packet
+ *  was placed in it, so the timeout bounds the added latency at low packet rates.
+ */
+struct packet_ring_params {
+  std::string interface_name;
+  std::size_t block_size = 1u << 20u; // a multiple of the page size
+  std::size_t num_blocks = 16u;
+  std::chrono::milliseconds block_timeout { 4 };
+  // accepted destination addresses (e.g. multicast groups), empty accepts any address,
+  // at most max_packet_ring_dest_addrs
+  std::vector<std::experimental::net::ip::address_v4> dest_addrs;
+};
+
+namespace detail {
+
+/**
+ *  @brief Build a filter for a cooked (@c SOCK_DGRAM) packet socket accepting
+ *  unfragmented IPv4 UDP packets to a port and, optionally, a set of addresses.
+ *
+ *  @return The filter, empty if there are more than @c max_packet_ring_dest_addrs
+ *  addresses.
+ */
+inline socket_filter make_packet_ring_filter(std::uint16_t port,
+        const std::vector<std::experimental::net::ip::address_v4>& dest_addrs) {
+  constexpr std::uint16_t bpf_ldx_msh = 0xb1;  // BPF_LDX | BPF_B | BPF_MSH
+  constexpr std::uint16_t bpf_ld_h_ind = 0x48; // BPF_LD | BPF_H | BPF_IND
+  constexpr std::uint16_t bpf_jset_k = 0x45;   // BPF_JMP | BPF_JSET | BPF_K
+
+  // the address block, if present, starts at index 4, the port block follows
+  std::size_t n = dest_addrs.size();
+  if (n > max_packet_ring_dest_addrs) { // the jump to the reject instruction would overflow
+    return socket_filter { };
+  }
+  std::size_t port_idx = 4u + (n > 0u ? n + 1u : 0u);
+  std::size_t rej_idx = port_idx + 4u;
+  auto jmp = [] (std::size_t to, std::size_t from) { // relative to the next instruction
+    return static_cast<std::uint8_t>(to - from - 1u);
+  };
+
+  socket_filter filt;
+  filt.push_back(filter_insn { bpf_ld_b_abs, 0u, 0u, 9u }); // IP protocol
+  filt.push_back(filter_insn { bpf_jeq_k, 0u, jmp(rej_idx, 1u), 17u }); // UDP
+  filt.push_back(filter_insn { bpf_ld_h_abs, 0u, 0u, 6u }); // flags and fragment offset
+  // more fragments flag or a fragment offset, so first fragments are rejected as well
+  filt.push_back(filter_insn { bpf_jset_k, jmp(rej_idx, 3u), 0u, 0x3fffu });
+  if (n > 0u) {
+    filt.push_back(filter_insn { bpf_ld_w_abs, 0u, 0u, 16u }); // destination address
+    for (std::size_t i = 0u; i < n; ++i) {
+      auto idx = 5u + i;
+      bool last = (i + 1u == n);
+      filt.push_back(filter_insn { bpf_jeq_k, last ? std::uint8_t(0u) : jmp(port_idx, idx),
+                                   last ? jmp(rej_idx, idx) : std::uint8_t(0u),
+                                   dest_addrs[i].to_uint() });
+    }
+  }
+  filt.push_back(filter_insn { bpf_ldx_msh, 0u, 0u, 0u }); // IP header length
+  filt.push_back(filter_insn { bpf_ld_h_ind, 0u, 0u, 2u }); // UDP destination port
+  filt.push_back(filter_insn { bpf_jeq_k, 0u, 1u, port });
+  filt.push_back(filter_insn { bpf_ret_k, 0u, 0u, bpf_accept });
+  filt.push_back(filter_insn { bpf_ret_k, 0u, 0u, bpf_reject });
+  return filt;
+}
+
+/**
+ *  @brief Own an @c AF_PACKET socket and its memory mapped @c TPACKET_V3 receive ring.
+ *
+ *  The packet socket is wrapped in a UDP socket object only so that the executor can
+ *  wait for readability; no UDP operations are performed on it. The ring memory is
+ *  unmapped on destruction (or the next @c open), not in @c close, so that a @c close
+ *  from another thread cannot unmap memory being read.
+ */
+class packet_ring {
+public:
+  using wait_socket_type = std::experimental::net::ip::udp::socket;
+  using endpoint_type = std::experimental::net::ip::udp::endpoint;
+
+private:
+  wait_socket_type  m_sock;
+  std::uint8_t*     m_map;
+  std::size_t       m_map_size;
+  std::size_t       m_block_size;
+  std::size_t       m_num_blocks;
+  std::size_t       m_cur_block;
+
+public:
+  explicit packet_ring(std::experimental::net::io_context& ioc) noexcept :
+    m_sock(ioc), m_map(nullptr), m_map_size(0u), m_block_size(0u), m_num_blocks(0u),
+    m_cur_block(0u) { }
+
+  ~packet_ring() { unmap(); }
+
+private:
+  packet_ring(const packet_ring&) = delete;
+  packet_ring& operator=(const packet_ring&) = delete;
+
+public:
+
+  wait_socket_type& get_socket() noexcept { return m_sock; }
+
+  bool open(const packet_ring_params& params, std::uint16_t port, std::error_code& ec) {
+#ifdef __linux__
+    close();
+    unmap();
+    auto fail = [&ec] (int fd) {
+      ec = std::error_code(errno, std::system_category());
+      if (fd >= 0) {
+        ::close(fd);
+      }
+      return false;
+    };
+    unsigned int ifindex = ::if_nametoindex(params.interface_name.c_str());
+    if (ifindex == 0u) {
+      return fail(-1);
+    }
+    int fd = ::socket(AF_PACKET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, htons(ETH_P_IP));
+    if (fd < 0) {
+      return fail(fd);
+    }
+    auto filt = make_packet_ring_filter(port, params.dest_addrs);
+    if (filt.empty()) {
+      ::close(fd);
+      ec = std::make_error_code(std::errc::invalid_argument);
+      return false;
+    }
+    // attach the filter before binding, so that no other traffic is queued
+    if (!attach_socket_filter(fd, filt, ec)) {
+      ::close(fd);
+      return false;
+    }
+    int ver = TPACKET_V3;
+    if (::setsockopt(fd, SOL_PACKET, PACKET_VERSION, &ver, sizeof(ver)) != 0) {
+      return fail(fd);
+    }
+    tpacket_req3 req { };
+    req.tp_block_size = static_cast<unsigned int>(params.block_size);
+    req.tp_block_nr = static_cast<unsigned int>(params.num_blocks);
+    req.tp_frame_size = 2048u; // only a hint for TPACKET_V3, packets are variable length
+    req.tp_frame_nr = static_cast<unsigned int>((params.block_size / 2048u) * params.num_blocks);
+    req.tp_retire_blk_tov = static_cast<unsigned int>(params.block_timeout.count());
+    if (::setsockopt(fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) != 0) {
+      return fail(fd);
+    }
+    auto map_size = params.block_size * params.num_blocks;
+    void* m = ::mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED, fd, 0);
+    if (m == MAP_FAILED) { // MAP_LOCKED may exceed the locked memory limit
+      m = ::mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (m == MAP_FAILED) {
+      return fail(fd);
+    }
+    sockaddr_ll sll { };
+    sll.sll_family = AF_PACKET;
+    sll.sll_protocol = htons(ETH_P_IP);
+    sll.sll_ifindex = static_cast<int>(ifindex);
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&sll), sizeof(sll)) != 0) {
+      ::munmap(m, map_size);
+      return fail(fd);
+    }
+    m_map = static_cast<std::uint8_t*>(m);
+    m_map_size = map_size;
+    m_block_size = params.block_size;
+    m_num_blocks = params.num_blocks;
+    m_cur_block = 0u;
+    m_sock.assign(std::experimental::net::ip::udp::v4(), fd, ec);
+    if (ec) {
+      ::close(fd);
+      unmap();
+      return false;
+    }
+    return true;
+#else
+    ec = std::make_error_code(std::errc::operation_not_supported);
+    return false;
+#endif
+  }
+
+  void close() noexcept {
+    std::error_code ec;
+    m_sock.close(ec);
+  }
+
+/**
+ *  @brief Deliver the UDP payload of every packet in the blocks handed to user space,
+ *  returning each block to the kernel after its packets are delivered.
+ *
+ *  The function object is invoked with the payload, the sender endpoint, and the
+ *  kernel receive timestamp, and returns @c false to stop delivering.
+ *
+ *  @return @c false if the function object returned @c false, otherwise @c true.
+ */
+  template <typename F>
+  bool drain(F&& func) {
+#ifdef __linux__
+    while (m_map) {
+      auto* bd = reinterpret_cast<tpacket_block_desc*>(m_map + m_cur_block * m_block_size);
+      if ((__atomic_load_n(&bd->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) == 0u) {
+        return true;
+      }
+      bool keep_going = true;
+      auto num_pkts = bd->hdr.bh1.num_pkts;
+      auto* pkt = reinterpret_cast<std::uint8_t*>(bd) + bd->hdr.bh1.offset_to_first_pkt;
+      for (unsigned int i = 0u; i < num_pkts && keep_going; ++i) {
+        auto* hdr = reinterpret_cast<tpacket3_hdr*>(pkt);
+        keep_going = deliver(hdr, func);
+        pkt += hdr->tp_next_offset;
+      }
+      __atomic_store_n(&bd->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+      m_cur_block = (m_cur_block + 1u) % m_num_blocks;
+      if (!keep_going) {
+        return false;
+      }
+    }
+#endif
+    return true;
+  }
+
+private:
+
+#ifdef __linux__
+  template <typename F>
+  static bool deliver(const tpacket3_hdr* hdr, F& func) {
+    const auto* sll = reinterpret_cast<const sockaddr_ll*>(
+              reinterpret_cast<const std::uint8_t*>(hdr) + TPACKET_ALIGN(sizeof(tpacket3_hdr)));
+    if (sll->sll_pkttype == PACKET_OUTGOING) {
+      return true;
+    }
+    const auto* ip = reinterpret_cast<const std::uint8_t*>(hdr) + hdr->tp_net;
+    std::size_t caplen = hdr->tp_snaplen;
+    std::size_t ihl = (ip[0] & 0x0fu) * 4u;
+    if (caplen < ihl + 8u) {
+      return true;
+    }
+    const auto* udp = ip + ihl;
+    std::size_t udp_len = (std::size_t(udp[4]) << 8u) | udp[5];
+    if (udp_len < 8u) {
+      return true;
+    }
+    std::size_t payload_len = udp_len - 8u;
+    if (payload_len > caplen - ihl - 8u) {
+      payload_len = caplen - ihl - 8u; // truncated by the ring
+    }
+    std::experimental::net::ip::address_v4::bytes_type src { ip[12], ip[13], ip[14], ip[15] };
+    endpoint_type sender(std::experimental::net::ip::address_v4(src),
+                         static_cast<unsigned short>((udp[0] << 8u) | udp[1]));
+    auto ts = std::chrono::system_clock::time_point(
+              std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                      std::chrono::seconds(hdr->tp_sec) + std::chrono::nanoseconds(hdr->tp_nsec)));
+    return func(std::experimental::net::const_buffer(udp + 8u, payload_len), sender, ts);
+  }
+#endif
+
+  void unmap() noexcept {
+#ifdef __linux__
+    if (m_map) {
+      ::munmap(m_map, m_map_size);
+    }
+#endif
+    m_map = nullptr;
+    m_map_size = 0u;
+  }
+
+};
+
+} // end detail namespace
+
+} // end net namespace
+} // end chops namespace
+
+#endif
+
@@ -17,6 +17,8 @@
 #define QUEUE_STATS_HPP_INCLUDED
 
 #include <cstddef> // std::size_t 
+#include <cstdint> // std::uint32_t, std::uint64_t
+#include <chrono>
 
 namespace chops {
 namespace net {
@@ -34,6 +36,57 @@ struct output_queue_stats {
   // std::size_t total_bytes_sent;
 };
 
+/**
+ *  @brief @c output_latency_stats provides information on the time between a buffer 
+ *  being written to the socket and the kernel transmit timestamp for that buffer.
+ *
+ *  These values are only collected when transmit timestamps are enabled on an IO 
+ *  handler.
+ */
+
+struct output_latency_stats {
+
+  std::size_t num_tx_timestamps = 0;
+  std::chrono::nanoseconds total_tx_latency { };
+  std::chrono::nanoseconds max_tx_latency { };
+};
+
+/**
+ *  @brief @c tcp_kernel_stats provides a sample of kernel TCP connection state, 
+ *  including the kernel socket queues which are not visible in @c output_queue_stats.
+ *
+ *  The values are sampled from @c TCP_INFO and the @c SIOCOUTQ and @c SIOCINQ ioctls
+ *  (Linux only, all values are zero on other platforms).
+ */
+
+struct tcp_kernel_stats {
+
+  std::chrono::microseconds rtt { }; // smoothed round trip time
+  std::chrono::microseconds rtt_var { };
+  std::uint32_t snd_cwnd = 0; // congestion window, in segments
+  std::uint32_t total_retrans = 0;
+  std::uint64_t delivery_rate = 0; // bytes per second, zero if not supported by the kernel
+  std::size_t send_queue_bytes = 0; // bytes not yet sent or not yet acknowledged by the peer
+  std::size_t unsent_bytes = 0; // bytes in the send queue not yet sent
+  std::size_t recv_queue_bytes = 0; // bytes received but not yet read
+};
+
+/**
+ *  @brief @c udp_rx_stats provides a sample of the kernel receive buffer of a UDP
+ *  socket, including datagrams dropped by the kernel because the buffer was full.
+ *
+ *  The values are sampled with the @c SO_MEMINFO socket option (Linux only, all values
+ *  except @c rcvbuf_grows are zero on other platforms).
+ */
+
+struct udp_rx_stats {
+
+  std::uint64_t drops = 0; // datagrams dropped by the kernel since the socket was opened
+  std::size_t rcvbuf_size = 0; // kernel receive buffer size, in bytes
+  std::size_t rcvbuf_used = 0; // bytes of received datagrams not yet read
+  std::size_t rcvbuf_grows = 0; // times the receive buffer was grown by autotuning
+};
+
 } // end net namespace
 } // end chops namespace
 
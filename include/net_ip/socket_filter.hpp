@@ -0,0 +1,193 @@
+/** @file
+ *
+ *  @ingroup net_ip_module
+ *
+ *  @brief Classic BPF socket filters, allowing unwanted UDP datagrams to be dropped
+ *  in the kernel, along with functions to build simple byte match filters.
+ *
+ *  A datagram rejected by a socket filter is dropped before it is queued to the socket,
+ *  saving the copy to user space, the thread wakeup, and the message handler call.
+ *  Filters are attached with the Linux @c SO_ATTACH_FILTER socket option; on other
+ *  platforms attaching a filter fails with an @c operation_not_supported error.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2018 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef SOCKET_FILTER_HPP_INCLUDED
+#define SOCKET_FILTER_HPP_INCLUDED
+
+#include <cstddef> // std::size_t, std::byte
+#include <cstdint> // std::uint8_t, std::uint16_t, std::uint32_t
+#include <vector>
+#include <system_error>
+#include <initializer_list>
+
+#ifdef __linux__
+#include <cerrno>
+#include <sys/socket.h>
+#include <linux/filter.h>
+#endif
+
+namespace chops {
+namespace net {
+
+/**
+ *  @brief One classic BPF instruction, layout compatible with the Linux @c sock_filter
+ *  structure.
+ */
+struct filter_insn {
+  std::uint16_t code;
+  std::uint8_t  jt;
+  std::uint8_t  jf;
+  std::uint32_t k;
+};
+
+/**
+ *  @brief A classic BPF program; an empty program means no filter.
+ */
+using socket_filter = std::vector<filter_insn>;
+
+#ifdef __linux__
+static_assert(sizeof(filter_insn) == sizeof(sock_filter), "filter_insn must match sock_filter");
+#endif
+
+namespace detail {
+
+// the subset of classic BPF opcodes used by the filter builders
+constexpr std::uint16_t bpf_ld_w_abs = 0x20; // BPF_LD | BPF_W | BPF_ABS
+constexpr std::uint16_t bpf_ld_h_abs = 0x28; // BPF_LD | BPF_H | BPF_ABS
+constexpr std::uint16_t bpf_ld_b_abs = 0x30; // BPF_LD | BPF_B | BPF_ABS
+constexpr std::uint16_t bpf_jeq_k = 0x15;    // BPF_JMP | BPF_JEQ | BPF_K
+constexpr std::uint16_t bpf_ret_k = 0x06;    // BPF_RET | BPF_K
+
+constexpr std::uint32_t bpf_accept = 0xFFFFFFFFu; // keep the entire datagram
+constexpr std::uint32_t bpf_reject = 0u;
+
+// a UDP socket filter sees the datagram starting at the UDP header
+constexpr std::size_t udp_header_size = 8u;
+
+inline std::uint16_t ld_abs_code(std::size_t width) noexcept {
+  return width == 4u ? bpf_ld_w_abs : (width == 2u ? bpf_ld_h_abs : bpf_ld_b_abs);
+}
+
+inline bool attach_socket_filter(int fd, const socket_filter& filt, std::error_code& ec) noexcept {
+#ifdef __linux__
+  if (filt.empty()) {
+    if (::setsockopt(fd, SOL_SOCKET, SO_DETACH_FILTER, nullptr, 0) != 0 && errno != ENOENT) {
+      ec = std::error_code(errno, std::system_category());
+      return false;
+    }
+    return true;
+  }
+  sock_fprog prog { };
+  prog.len = static_cast<unsigned short>(filt.size());
+  prog.filter = reinterpret_cast<sock_filter*>(const_cast<filter_insn*>(filt.data()));
+  if (::setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog)) != 0) {
+    ec = std::error_code(errno, std::system_category());
+    return false;
+  }
+  return true;
+#else
+  ec = std::make_error_code(std::errc::operation_not_supported);
+  return false;
+#endif
+}
+
+} // end detail namespace
+
+/**
+ *  @brief Build a UDP socket filter accepting only datagrams whose payload contains the
+ *  given bytes at the given offset.
+ *
+ *  Datagrams too short to contain the bytes are rejected. The bytes are compared in
+ *  4, 2, and 1 byte loads, so matching a 4 byte channel id is a single comparison.
+ *
+ *  @param offset Offset of the bytes within the UDP payload.
+ *
+ *  @param bytes Pointer to the bytes to match.
+ *
+ *  @param len Number of bytes to match, at most 500.
+ *
+ *  @return The filter, empty if @c len is 0 or too large.
+ */
+inline socket_filter make_byte_match_filter(std::size_t offset, const void* bytes,
+                                            std::size_t len) {
+  socket_filter filt;
+  if (len == 0u || len > 500u) {
+    return filt;
+  }
+  const auto* p = static_cast<const std::uint8_t*>(bytes);
+  std::vector<std::size_t> widths;
+  for (std::size_t rem = len; rem > 0u; ) {
+    widths.push_back(rem >= 4u ? 4u : (rem >= 2u ? 2u : 1u));
+    rem -= widths.back();
+  }
+  auto n = widths.size();
+  std::size_t off = 0u;
+  for (std::size_t i = 0u; i < n; ++i) {
+    std::uint32_t val = 0u;
+    for (std::size_t b = 0u; b < widths[i]; ++b) {
+      val = (val << 8u) | p[off + b]; // loads are in network byte order
+    }
+    filt.push_back(filter_insn { detail::ld_abs_code(widths[i]), 0u, 0u,
+                   static_cast<std::uint32_t>(detail::udp_header_size + offset + off) });
+    // on mismatch jump to the reject instruction at the end
+    filt.push_back(filter_insn { detail::bpf_jeq_k, 0u,
+                                 static_cast<std::uint8_t>(2u * (n - i) - 1u), val });
+    off += widths[i];
+  }
+  filt.push_back(filter_insn { detail::bpf_ret_k, 0u, 0u, detail::bpf_accept });
+  filt.push_back(filter_insn { detail::bpf_ret_k, 0u, 0u, detail::bpf_reject });
+  return filt;
+}
+
+/**
+ *  @brief Build a UDP socket filter accepting only datagrams where an unsigned integer
+ *  field in the payload is one of a set of values, for example a set of channel ids.
+ *
+ *  The field is read in network (big endian) byte order. Datagrams too short to contain
+ *  the field are rejected.
+ *
+ *  @param offset Offset of the field within the UDP payload.
+ *
+ *  @param width Width of the field in bytes, 1, 2, or 4.
+ *
+ *  @param values Accepted field values, at most 255.
+ *
+ *  @return The filter, empty if the width or number of values is invalid.
+ */
+inline socket_filter make_value_match_filter(std::size_t offset, std::size_t width,
+                                             const std::vector<std::uint32_t>& values) {
+  socket_filter filt;
+  if ((width != 1u && width != 2u && width != 4u) || values.empty() || values.size() > 255u) {
+    return filt;
+  }
+  auto n = values.size();
+  filt.push_back(filter_insn { detail::ld_abs_code(width), 0u, 0u,
+                 static_cast<std::uint32_t>(detail::udp_header_size + offset) });
+  for (std::size_t i = 0u; i < n; ++i) {
+    // on match jump to the accept instruction at the end
+    filt.push_back(filter_insn { detail::bpf_jeq_k, static_cast<std::uint8_t>(n - i), 0u,
+                                 values[i] });
+  }
+  filt.push_back(filter_insn { detail::bpf_ret_k, 0u, 0u, detail::bpf_reject });
+  filt.push_back(filter_insn { detail::bpf_ret_k, 0u, 0u, detail::bpf_accept });
+  return filt;
+}
+
+inline socket_filter make_value_match_filter(std::size_t offset, std::size_t width,
+                                             std::initializer_list<std::uint32_t> values) {
+  return make_value_match_filter(offset, width, std::vector<std::uint32_t>(values));
+}
+
+} // end net namespace
+} // end chops namespace
+
+#endif
+
@@ -0,0 +1,261 @@
+/** @file
+ *
+ *  @ingroup net_ip_module
+ *
+ *  @brief Functions to hand open sockets (e.g. TCP listening sockets and bound UDP
+ *  sockets) to a successor process over a Unix domain socket, allowing a restart
+ *  without closing the sockets.
+ *
+ *  The exporting (old) process obtains the native handles through the @c basic_net_entity
+ *  @c get_socket method and calls @c export_socket_handles, which waits for the successor
+ *  to connect. The successor calls @c import_socket_handles and creates its net entities
+ *  from the received handles (see the @c net_ip @c make methods taking a native handle).
+ *  Both processes accept connections or receive datagrams until the old process stops its
+ *  net entities, so no connect is refused during the restart.
+ *
+ *  The handles are passed with the Unix @c SCM_RIGHTS control message; on other platforms
+ *  the functions fail with an @c operation_not_supported error.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2018 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef SOCKET_HANDOFF_HPP_INCLUDED
+#define SOCKET_HANDOFF_HPP_INCLUDED
+
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint32_t
+#include <cstring> // std::memcpy
+#include <string_view>
+#include <vector>
+#include <system_error>
+
+#include <experimental/internet>
+
+#ifdef __linux__
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h> // close, unlink
+#endif
+
+namespace chops {
+namespace net {
+
+/**
+ *  @brief Maximum number of handles passed in one handoff (the Linux @c SCM_MAX_FD
+ *  limit).
+ */
+constexpr std::size_t max_handoff_handles = 253u;
+
+/**
+ *  @brief Send socket handles over a connected Unix domain stream socket.
+ *
+ *  The handles stay open in the sending process.
+ *
+ *  @return @c false if the handles could not be sent, with @c ec set, otherwise @c true.
+ */
+inline bool send_socket_handles(int unix_fd, const std::vector<int>& handles,
+                                std::error_code& ec) noexcept {
+#ifdef __linux__
+  if (handles.empty() || handles.size() > max_handoff_handles) {
+    ec = std::make_error_code(std::errc::invalid_argument);
+    return false;
+  }
+  std::uint32_t num = static_cast<std::uint32_t>(handles.size());
+  iovec iov { &num, sizeof(num) };
+  std::vector<char> ctl(CMSG_SPACE(handles.size() * sizeof(int)), 0);
+  msghdr msg { };
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = ctl.data();
+  msg.msg_controllen = ctl.size();
+  cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+  cm->cmsg_level = SOL_SOCKET;
+  cm->cmsg_type = SCM_RIGHTS;
+  cm->cmsg_len = CMSG_LEN(handles.size() * sizeof(int));
+  std::memcpy(CMSG_DATA(cm), handles.data(), handles.size() * sizeof(int));
+  if (::sendmsg(unix_fd, &msg, MSG_NOSIGNAL) != static_cast<ssize_t>(sizeof(num))) {
+    ec = std::error_code(errno, std::system_category());
+    return false;
+  }
+  return true;
+#else
+  ec = std::make_error_code(std::errc::operation_not_supported);
+  return false;
+#endif
+}
+
+/**
+ *  @brief Receive socket handles from a connected Unix domain stream socket, in the
+ *  order they were sent.
+ *
+ *  The received handles are owned by the caller, and are marked close on exec.
+ *
+ *  @return The handles, empty if none could be received, with @c ec set.
+ */
+inline std::vector<int> receive_socket_handles(int unix_fd, std::error_code& ec) {
+  std::vector<int> handles;
+#ifdef __linux__
+  std::uint32_t num = 0u;
+  iovec iov { &num, sizeof(num) };
+  std::vector<char> ctl(CMSG_SPACE(max_handoff_handles * sizeof(int)), 0);
+  msghdr msg { };
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = ctl.data();
+  msg.msg_controllen = ctl.size();
+  auto nb = ::recvmsg(unix_fd, &msg, MSG_CMSG_CLOEXEC | MSG_WAITALL);
+  if (nb < 0) {
+    ec = std::error_code(errno, std::system_category());
+    return handles;
+  }
+  for (cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg, cm)) {
+    if (cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_RIGHTS) {
+      auto n = (cm->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+      auto first = handles.size();
+      handles.resize(first + n);
+      std::memcpy(handles.data() + first, CMSG_DATA(cm), n * sizeof(int));
+    }
+  }
+  if (nb != static_cast<ssize_t>(sizeof(num)) || handles.size() != num ||
+      (msg.msg_flags & MSG_CTRUNC) != 0) {
+    for (auto h : handles) {
+      ::close(h);
+    }
+    handles.clear();
+    ec = std::make_error_code(std::errc::protocol_error);
+  }
+#else
+  ec = std::make_error_code(std::errc::operation_not_supported);
+#endif
+  return handles;
+}
+
+namespace detail {
+
+#ifdef __linux__
+inline bool make_unix_addr(std::string_view path, sockaddr_un& addr, std::error_code& ec) noexcept {
+  addr = sockaddr_un { };
+  addr.sun_family = AF_UNIX;
+  if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+    ec = std::make_error_code(std::errc::invalid_argument);
+    return false;
+  }
+  std::memcpy(addr.sun_path, path.data(), path.size());
+  return true;
+}
+#endif
+
+inline void close_handle(int handle) noexcept {
+#ifdef __linux__
+  ::close(handle);
+#endif
+}
+
+// protocol (IPv4 or IPv6) of an inherited socket handle, for assigning it to a socket
+template <typename Protocol>
+Protocol handle_protocol(int handle, std::error_code& ec) noexcept {
+#ifdef __linux__
+  sockaddr_storage ss { };
+  socklen_t len = sizeof(ss);
+  if (::getsockname(handle, reinterpret_cast<sockaddr*>(&ss), &len) != 0) {
+    ec = std::error_code(errno, std::system_category());
+  }
+  return ss.ss_family == AF_INET6 ? Protocol::v6() : Protocol::v4();
+#else
+  ec = std::make_error_code(std::errc::operation_not_supported);
+  return Protocol::v4();
+#endif
+}
+
+} // end detail namespace
+
+/**
+ *  @brief Wait for a successor process to connect to a Unix domain socket path, then send
+ *  it socket handles.
+ *
+ *  This call blocks until the successor connects, so it is typically made from a
+ *  dedicated thread. An existing file at the path is removed first, and the path is
+ *  removed when the handoff completes.
+ *
+ *  @return @c false if the handoff failed, with @c ec set, otherwise @c true.
+ */
+inline bool export_socket_handles(std::string_view path, const std::vector<int>& handles,
+                                  std::error_code& ec) {
+#ifdef __linux__
+  sockaddr_un addr;
+  if (!detail::make_unix_addr(path, addr, ec)) {
+    return false;
+  }
+  int lfd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (lfd < 0) {
+    ec = std::error_code(errno, std::system_category());
+    return false;
+  }
+  ::unlink(addr.sun_path);
+  if (::bind(lfd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      ::listen(lfd, 1) != 0) {
+    ec = std::error_code(errno, std::system_category());
+    ::close(lfd);
+    return false;
+  }
+  int cfd = ::accept4(lfd, nullptr, nullptr, SOCK_CLOEXEC);
+  if (cfd < 0) {
+    ec = std::error_code(errno, std::system_category());
+    ::close(lfd);
+    ::unlink(addr.sun_path);
+    return false;
+  }
+  bool ret = send_socket_handles(cfd, handles, ec);
+  ::close(cfd);
+  ::close(lfd);
+  ::unlink(addr.sun_path);
+  return ret;
+#else
+  ec = std::make_error_code(std::errc::operation_not_supported);
+  return false;
+#endif
+}
+
+/**
+ *  @brief Connect to the Unix domain socket path of an exporting process and receive
+ *  its socket handles.
+ *
+ *  @return The handles, empty if the handoff failed, with @c ec set.
+ */
+inline std::vector<int> import_socket_handles(std::string_view path, std::error_code& ec) {
+#ifdef __linux__
+  sockaddr_un addr;
+  if (!detail::make_unix_addr(path, addr, ec)) {
+    return std::vector<int> { };
+  }
+  int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    ec = std::error_code(errno, std::system_category());
+    return std::vector<int> { };
+  }
+  if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+    ec = std::error_code(errno, std::system_category());
+    ::close(fd);
+    return std::vector<int> { };
+  }
+  auto handles = receive_socket_handles(fd, ec);
+  ::close(fd);
+  return handles;
+#else
+  ec = std::make_error_code(std::errc::operation_not_supported);
+  return std::vector<int> { };
+#endif
+}
+
+} // end net namespace
+} // end chops namespace
+
+#endif
+
@@ -0,0 +1,182 @@
+/** @file
+ *
+ *  @ingroup net_ip_module
+ *
+ *  @brief A single producer, single consumer lock-free ring of message slots, which
+ *  an IO handler reads directly into.
+ *
+ *  When an IO handler is started with a ring (instead of a message handler), each
+ *  incoming message is read (and framed) directly into the next free slot, then published
+ *  to the consuming thread. There is no message handler invocation and no copy from
+ *  an internal buffer. When the ring is full the IO handler stops reading, which
+ *  provides natural backpressure (TCP flow control, or UDP socket buffer drops), and
+ *  resumes reading when the consumer frees a slot.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2018 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef SPSC_MSG_RING_HPP_INCLUDED
+#define SPSC_MSG_RING_HPP_INCLUDED
+
+#include <cstddef> // std::size_t, std::byte
+#include <atomic>
+#include <vector>
+#include <functional> // std::function
+#include <utility> // std::forward
+
+#include <experimental/buffer>
+
+namespace chops {
+namespace net {
+
+/**
+ *  @brief Lock-free ring of fixed capacity message slots, with one producer (an IO handler)
+ *  and one consumer (an application thread).
+ *
+ *  The number of slots is rounded up to a power of two. Each slot holds a message of up
+ *  to the slot size in bytes plus the endpoint the message was received from. A TCP
+ *  message larger than the slot size causes the IO handler to report an error and stop;
+ *  a UDP datagram larger than the slot size is truncated.
+ *
+ *  The ring must outlive any IO handler reading into it.
+ *
+ *  @tparam E Endpoint type, @c ip::tcp::endpoint or @c ip::udp::endpoint.
+ */
+template <typename E>
+class spsc_msg_ring {
+public:
+  using endpoint_type = E;
+  using resume_cb = std::function<void ()>;
+
+private:
+  struct slot_hdr {
+    std::size_t  size = 0;
+    E            endp { };
+  };
+
+private:
+  std::size_t               m_slot_size;
+  std::size_t               m_mask;
+  std::vector<std::byte>    m_bytes;
+  std::vector<slot_hdr>     m_hdrs;
+  resume_cb                 m_resume_cb;
+
+  alignas(64) std::atomic_size_t m_head; // next slot to consume, written by consumer
+  alignas(64) std::atomic_size_t m_tail; // next slot to fill, written by producer
+  alignas(64) std::atomic_bool   m_producer_paused;
+
+public:
+
+/**
+ *  @brief Construct a ring.
+ *
+ *  @param num_slots Number of slots, rounded up to a power of two.
+ *
+ *  @param slot_size Maximum message size, in bytes.
+ */
+  spsc_msg_ring(std::size_t num_slots, std::size_t slot_size) :
+    m_slot_size(slot_size), m_mask(round_up_pow2(num_slots) - 1),
+    m_bytes((m_mask + 1) * slot_size), m_hdrs(m_mask + 1), m_resume_cb(),
+    m_head(0), m_tail(0), m_producer_paused(false) { }
+
+private:
+  spsc_msg_ring(const spsc_msg_ring&) = delete;
+  spsc_msg_ring& operator=(const spsc_msg_ring&) = delete;
+
+public:
+
+  std::size_t capacity() const noexcept { return m_mask + 1; }
+  std::size_t slot_size() const noexcept { return m_slot_size; }
+
+  std::size_t size() const noexcept {
+    return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+  }
+  bool empty() const noexcept { return size() == 0; }
+  bool full() const noexcept { return size() == capacity(); }
+
+/**
+ *  @brief Consume the oldest message, if any, freeing its slot after the function object
+ *  returns.
+ *
+ *  Only called from the consumer thread.
+ *
+ *  @param func Function object invoked with a @c const_buffer referencing the message
+ *  and the endpoint the message was received from.
+ *
+ *  @return @c false if the ring is empty, otherwise @c true.
+ */
+  template <typename F>
+  bool consume(F&& func) {
+    auto head = m_head.load(std::memory_order_relaxed);
+    if (head == m_tail.load(std::memory_order_acquire)) {
+      return false;
+    }
+    const auto& hdr = m_hdrs[head & m_mask];
+    func(std::experimental::net::const_buffer(slot_data(head), hdr.size),
+         static_cast<const E&>(hdr.endp));
+    // seq_cst store and load, pairs with the producer pause handshake
+    m_head.store(head + 1);
+    if (m_producer_paused.load() && m_producer_paused.exchange(false)) {
+      m_resume_cb();
+    }
+    return true;
+  }
+
+// the following methods are called by the IO handler (producer) only
+
+  void set_resume_cb(resume_cb cb) { m_resume_cb = std::move(cb); }
+
+  // return the next free slot, or an empty buffer if the ring is full
+  std::experimental::net::mutable_buffer producer_slot() noexcept {
+    auto tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_head.load(std::memory_order_acquire) == capacity()) {
+      return std::experimental::net::mutable_buffer();
+    }
+    return std::experimental::net::mutable_buffer(slot_data(tail), m_slot_size);
+  }
+
+  void publish(std::size_t sz, const E& endp) noexcept {
+    auto tail = m_tail.load(std::memory_order_relaxed);
+    auto& hdr = m_hdrs[tail & m_mask];
+    hdr.size = sz;
+    hdr.endp = endp;
+    m_tail.store(tail + 1, std::memory_order_release);
+  }
+
+  // called when the ring is full, returns true if the producer is paused and the resume
+  // callback will be invoked, false if a slot has become available in the meantime
+  bool pause_producer() noexcept {
+    m_producer_paused.store(true);
+    if (m_tail.load(std::memory_order_relaxed) - m_head.load() < capacity()) {
+      // the consumer may have freed a slot before seeing the pause flag
+      return !m_producer_paused.exchange(false);
+    }
+    return true;
+  }
+
+private:
+
+  std::byte* slot_data(std::size_t idx) noexcept {
+    return m_bytes.data() + (idx & m_mask) * m_slot_size;
+  }
+
+  static std::size_t round_up_pow2(std::size_t n) noexcept {
+    std::size_t p = 1;
+    while (p < n) {
+      p <<= 1;
+    }
+    return p;
+  }
+
+};
+
+} // end net namespace
+} // end chops namespace
+
+#endif
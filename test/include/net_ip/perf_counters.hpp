@@ -0,0 +1,181 @@
+/** @file
+ *
+ *  @ingroup test_module
+ *
+ *  @brief Optional hardware and software performance counter capture for measured
+ *  regions of the @c net_ip tests.
+ *
+ *  Wall clock time alone does not show why a path is slow. When the @c CHOPS_PERF_COUNTERS
+ *  environment variable is set, a @c perf_counters object opens Linux @c perf_event_open
+ *  counters for CPU cycles, instructions, cache misses, branch misses and context
+ *  switches, and @c report writes the counts of the measured region divided by the
+ *  number of messages to an output stream. Otherwise (or on other platforms) all of the
+ *  methods do nothing.
+ *
+ *  Counters are inherited by threads created after construction, so a @c perf_counters
+ *  object constructed before a @c worker is started includes the IO processing of the
+ *  worker threads. Counters which cannot be opened (e.g. hardware counters in a virtual
+ *  machine, or kernel restrictions set through @c perf_event_paranoid) are skipped.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2018 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#ifndef PERF_COUNTERS_HPP_INCLUDED
+#define PERF_COUNTERS_HPP_INCLUDED
+
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint32_t, std::uint64_t
+#include <cstdlib> // std::getenv
+#include <cstring> // std::memset
+#include <string_view>
+#include <array>
+#include <ostream>
+#include <iomanip> // std::setprecision
+
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h> // syscall, read, close
+#include <linux/perf_event.h>
+#endif
+
+namespace chops {
+namespace test {
+
+class perf_counters {
+private:
+  struct counter_def {
+    const char*    name;
+    std::uint32_t  type;
+    std::uint64_t  config;
+  };
+
+  static constexpr std::size_t num_counters = 5u;
+
+#ifdef __linux__
+  static constexpr std::array<counter_def, num_counters> defs { {
+    { "cycles",        PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { "instructions",  PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { "cache misses",  PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { "branch misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    { "ctx switches",  PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES }
+  } };
+#endif
+
+private:
+  std::array<int, num_counters>            m_fds;
+  std::array<std::uint64_t, num_counters>  m_counts;
+
+public:
+
+  perf_counters() : m_fds(), m_counts() {
+    m_fds.fill(-1);
+    m_counts.fill(0u);
+#ifdef __linux__
+    if (std::getenv("CHOPS_PERF_COUNTERS") == nullptr) {
+      return;
+    }
+    for (std::size_t i = 0; i < num_counters; ++i) {
+      m_fds[i] = open_counter(defs[i], false);
+      if (m_fds[i] < 0) { // retry counting only user space
+        m_fds[i] = open_counter(defs[i], true);
+      }
+    }
+#endif
+  }
+
+  ~perf_counters() {
+#ifdef __linux__
+    for (auto fd : m_fds) {
+      if (fd >= 0) {
+        ::close(fd);
+      }
+    }
+#endif
+  }
+
+  perf_counters(const perf_counters&) = delete;
+  perf_counters& operator=(const perf_counters&) = delete;
+
+  bool is_enabled() const noexcept {
+    for (auto fd : m_fds) {
+      if (fd >= 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void start() {
+#ifdef __linux__
+    for (auto fd : m_fds) {
+      if (fd >= 0) {
+        ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+    }
+#endif
+  }
+
+  void stop() {
+#ifdef __linux__
+    for (std::size_t i = 0; i < num_counters; ++i) {
+      if (m_fds[i] < 0) {
+        continue;
+      }
+      ::ioctl(m_fds[i], PERF_EVENT_IOC_DISABLE, 0);
+      std::uint64_t val = 0u;
+      if (::read(m_fds[i], &val, sizeof(val)) == static_cast<ssize_t>(sizeof(val))) {
+        m_counts[i] = val;
+      }
+    }
+#endif
+  }
+
+  // write the counts of the last measured region divided by the number of messages
+  void report(std::ostream& os, std::string_view label, std::size_t num_msgs) const {
+#ifdef __linux__
+    if (!is_enabled() || num_msgs == 0u) {
+      return;
+    }
+    os << "****** Perf counters per msg, " << label << ", msgs: " << num_msgs;
+    for (std::size_t i = 0; i < num_counters; ++i) {
+      if (m_fds[i] >= 0) {
+        os << ", " << defs[i].name << ": " << std::fixed << std::setprecision(2) <<
+              static_cast<double>(m_counts[i]) / static_cast<double>(num_msgs);
+      }
+    }
+    os << std::endl;
+#endif
+  }
+
+private:
+
+#ifdef __linux__
+  static int open_counter(const counter_def& def, bool user_only) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = def.type;
+    attr.config = def.config;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_hv = 1;
+    attr.exclude_kernel = user_only ? 1 : 0;
+    return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+  }
+#endif
+
+};
+
+} // end namespace test
+} // end namespace chops
+
+#endif
+
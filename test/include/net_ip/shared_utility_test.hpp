@@ -47,8 +47,6 @@
 #include <experimental/buffer>
 #include <experimental/internet> // ip::udp::endpoint
 
-#include <boost/endian/conversion.hpp>
-
 #include "utility/shared_buffer.hpp"
 #include "utility/repeat.hpp"
 #include "utility/make_byte_array.hpp"
@@ -56,6 +54,7 @@
 #include "net_ip/io_interface.hpp"
 
 #include "net_ip/component/simple_variable_len_msg_frame.hpp"
+#include "net_ip/component/msg_layout.hpp"
 
 namespace chops {
 namespace test {
@@ -68,10 +67,14 @@ inline chops::mutable_shared_buffer make_body_buf(std::string_view pre,
   return buf.append(body.data(), body.size());
 }
 
+using var_len_msg_size = chops::net::layout_field<std::uint16_t, 0>;
+using var_len_msg_hdr = chops::net::msg_layout<var_len_msg_size>;
+
 inline chops::const_shared_buffer make_variable_len_msg(const chops::mutable_shared_buffer& body) {
   assert(body.size() < std::numeric_limits<std::uint16_t>::max());
-  std::uint16_t hdr = boost::endian::native_to_big(static_cast<std::uint16_t>(body.size()));
-  chops::mutable_shared_buffer msg(static_cast<const void*>(&hdr), 2);
+  chops::mutable_shared_buffer msg;
+  chops::net::make_layout_view<var_len_msg_hdr>(msg).set<var_len_msg_size>(
+                                         static_cast<std::uint16_t>(body.size()));
   return chops::const_shared_buffer(std::move(msg.append(body.data(), body.size())));
 }
 
@@ -88,12 +91,8 @@ inline chops::const_shared_buffer make_lf_text_msg(const chops::mutable_shared_b
 }
 
 inline std::size_t decode_variable_len_msg_hdr(const std::byte* buf_ptr, std::size_t sz) {
-  assert (sz == 2);
-  std::uint16_t hdr;
-  std::byte* hdr_ptr = static_cast<std::byte*>(static_cast<void*>(&hdr));
-  *(hdr_ptr+0) = *(buf_ptr+0);
-  *(hdr_ptr+1) = *(buf_ptr+1);
-  return boost::endian::big_to_native(hdr);
+  assert (sz == var_len_msg_hdr::size);
+  return chops::net::layout_hdr_decoder<var_len_msg_size>(buf_ptr, sz);
 }
 
 template <typename F>
@@ -189,9 +188,17 @@ struct io_handler_mock {
     return chops::net::output_queue_stats { qs_base, qs_base +1 };
   }
 
+  chops::net::tcp_kernel_stats get_tcp_kernel_stats() const {
+    chops::net::tcp_kernel_stats st { };
+    st.rtt = std::chrono::microseconds(qs_base);
+    st.send_queue_bytes = qs_base + 2;
+    return st;
+  }
+
   bool send_called = false;
 
   void send(chops::const_shared_buffer) { send_called = true; }
+  void send(const void*, std::size_t) { send_called = true; }
   void send(chops::const_shared_buffer, const endpoint_type&) { send_called = true; }
 
   bool mf_sio_called = false;
@@ -296,6 +303,31 @@ std::experimental::net::ip::udp::endpoint make_udp_endpoint(const char* addr, in
                            static_cast<unsigned short>(port_num));
 }
 
+// connects the client to the acceptor and wraps the accepted socket in a tcp_io handler
+// with an entity notifier that does nothing
+inline chops::net::detail::tcp_io_ptr accept_tcp_io(std::experimental::net::ip::tcp::acceptor& acc,
+                                                    std::experimental::net::ip::tcp::socket& client) {
+  client.connect(acc.local_endpoint());
+  return std::make_shared<chops::net::detail::tcp_io>(acc.accept(),
+                                                      [] (std::error_code, auto) { } );
+}
+
+// a tcp_io handler with a connected loopback client; IO processing is not started, so
+// that options can be enabled first, and the handler is closed on destruction
+struct tcp_io_fixture {
+  std::experimental::net::ip::tcp::acceptor   acc;
+  std::experimental::net::ip::tcp::socket     client;
+  chops::net::detail::tcp_io_ptr              iohp;
+  chops::net::tcp_io_interface                io;
+
+  explicit tcp_io_fixture(std::experimental::net::io_context& ioc) :
+    acc(ioc, std::experimental::net::ip::tcp::endpoint(
+                 std::experimental::net::ip::address_v4::loopback(), 0)),
+    client(ioc), iohp(accept_tcp_io(acc, client)), io(iohp) { }
+
+  ~tcp_io_fixture() { iohp->close(); }
+};
+
 
 } // end namespace test
 } // end namespace chops
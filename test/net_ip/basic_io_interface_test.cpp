@@ -47,6 +47,7 @@ void basic_io_interface_test_default_constructed() {
         REQUIRE_THROWS (io_intf.is_io_started());
         REQUIRE_THROWS (io_intf.get_socket());
         REQUIRE_THROWS (io_intf.get_output_queue_stats());
+        REQUIRE_THROWS (io_intf.get_tcp_kernel_stats());
 
         REQUIRE_THROWS (io_intf.send(nullptr, 0));
         REQUIRE_THROWS (io_intf.send(buf));
@@ -89,6 +90,9 @@ void basic_io_interface_test_methods() {
         chops::net::output_queue_stats s = io_intf.get_output_queue_stats();
         REQUIRE (s.output_queue_size == chops::test::io_handler_mock::qs_base);
         REQUIRE (s.bytes_in_output_queue == (chops::test::io_handler_mock::qs_base + 1));
+        chops::net::tcp_kernel_stats ks = io_intf.get_tcp_kernel_stats();
+        REQUIRE (ks.rtt.count() == chops::test::io_handler_mock::qs_base);
+        REQUIRE (ks.send_queue_bytes == (chops::test::io_handler_mock::qs_base + 2));
       }
     }
     AND_WHEN ("send or start_io or stop_io is called") {
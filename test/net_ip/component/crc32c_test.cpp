@@ -0,0 +1,116 @@
+/** @file
+ *
+ *  @ingroup test_module
+ *
+ *  @brief Test scenarios for CRC32C message integrity functions.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2018 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch.hpp"
+
+#include <experimental/buffer>
+#include <experimental/internet>
+
+#include <cstddef> // std::size_t, std::byte
+#include <cstdint> // std::uint32_t
+#include <atomic>
+#include <vector>
+
+#include "net_ip/component/crc32c.hpp"
+
+#include "net_ip/shared_utility_test.hpp"
+
+#include "utility/shared_buffer.hpp"
+
+SCENARIO ( "Testing crc32c computation",
+           "[crc32c]" ) {
+
+  using namespace chops::net;
+
+  GIVEN ("Standard check values") {
+    const char chk[] = "123456789";
+    std::vector<std::byte> zeros(32, std::byte(0x00));
+    std::vector<std::byte> ones(32, std::byte(0xFF));
+    THEN ("the CRC32C values match the published values") {
+      REQUIRE (crc32c(chk, 9) == 0xE3069283u);
+      REQUIRE (crc32c(zeros.data(), zeros.size()) == 0x8A9136AAu);
+      REQUIRE (crc32c(ones.data(), ones.size()) == 0x62A8AB43u);
+    }
+    AND_THEN ("the table and hardware implementations agree for all lengths and offsets") {
+      std::vector<std::byte> data(300);
+      for (std::size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<std::byte>(i * 7 + 3);
+      }
+      for (std::size_t off = 0; off < 8; ++off) {
+        for (std::size_t sz = 0; sz + off <= data.size(); sz += 13) {
+          auto p = data.data() + off;
+          REQUIRE (detail::crc32c_sw(~0u, p, sz) == detail::crc32c_hw(~0u, p, sz));
+        }
+      }
+    }
+    AND_THEN ("a CRC can be computed incrementally") {
+      REQUIRE (crc32c(chk+4, 5, crc32c(chk, 4)) == 0xE3069283u);
+    }
+  } // end given
+}
+
+SCENARIO ( "Testing crc32c trailer append and validation message handlers",
+           "[crc32c]" ) {
+
+  using namespace chops::net;
+  using namespace chops::test;
+  using namespace std::experimental::net;
+
+  chops::mutable_shared_buffer buf("Hello CRC", 9);
+  append_crc32c(buf);
+  REQUIRE (buf.size() == 9 + crc32c_size);
+  REQUIRE (is_crc32c_valid(const_buffer(buf.data(), buf.size())));
+
+  auto ioh = std::make_shared<io_handler_mock>();
+  io_interface_mock io(ioh);
+  auto endp = make_udp_endpoint("127.0.0.1", 30001);
+
+  std::size_t msg_size = 0;
+  auto app_hdlr = [&msg_size] (const_buffer b, io_interface_mock, ip::udp::endpoint) {
+    msg_size = b.size();
+    return true;
+  };
+
+  GIVEN ("A message handler that closes on a mismatch") {
+    auto mh = make_crc32c_msg_hdlr(app_hdlr);
+    WHEN ("a valid message is received") {
+      THEN ("the application handler is invoked without the trailer") {
+        REQUIRE (mh(const_buffer(buf.data(), buf.size()), io, endp));
+        REQUIRE (msg_size == 9);
+      }
+    }
+    AND_WHEN ("a corrupted message is received") {
+      *(buf.data() + 2) = std::byte(0x00);
+      THEN ("false is returned and the application handler is not invoked") {
+        REQUIRE_FALSE (mh(const_buffer(buf.data(), buf.size()), io, endp));
+        REQUIRE_FALSE (mh(const_buffer(buf.data(), 2), io, endp));
+        REQUIRE (msg_size == 0);
+      }
+    }
+  } // end given
+
+  GIVEN ("A message handler that counts mismatches") {
+    std::atomic_size_t errs { 0 };
+    auto mh = make_crc32c_msg_hdlr(app_hdlr, errs);
+    WHEN ("a corrupted message is received") {
+      *(buf.data() + buf.size() - 1) ^= std::byte(0x01);
+      THEN ("true is returned and the error is counted") {
+        REQUIRE (mh(const_buffer(buf.data(), buf.size()), io, endp));
+        REQUIRE (errs == 1);
+        REQUIRE (msg_size == 0);
+      }
+    }
+  } // end given
+}
\ No newline at end of file
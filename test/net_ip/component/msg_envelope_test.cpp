@@ -0,0 +1,119 @@
+/** @file
+ *
+ *  @ingroup test_module
+ *
+ *  @brief Test scenarios for envelope batching functions and @c envelope_sender class
+ *  template.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2018 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch.hpp"
+
+#include <experimental/buffer>
+#include <experimental/internet>
+#include <experimental/io_context>
+
+#include <cstddef> // std::size_t, std::byte
+#include <memory> // std::make_shared
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "net_ip/component/msg_envelope.hpp"
+#include "net_ip/basic_io_interface.hpp"
+
+#include "utility/shared_buffer.hpp"
+
+struct capture_io_handler {
+  using socket_type = int;
+  using endpoint_type = std::experimental::net::ip::udp::endpoint;
+
+  std::vector<chops::const_shared_buffer> bufs;
+
+  void send(chops::const_shared_buffer buf) { bufs.push_back(buf); }
+  void send(chops::const_shared_buffer buf, const endpoint_type&) { bufs.push_back(buf); }
+};
+
+using capture_io_intf = chops::net::basic_io_interface<capture_io_handler>;
+
+std::vector<std::string> unpack(const chops::const_shared_buffer& env) {
+  using namespace std::experimental::net;
+  std::vector<std::string> msgs;
+  auto mh = chops::net::make_envelope_msg_hdlr(
+        [&msgs] (const_buffer b, capture_io_intf, ip::udp::endpoint) {
+      msgs.emplace_back(static_cast<const char*>(b.data()), b.size());
+      return true;
+    }
+  );
+  REQUIRE (chops::net::decode_envelope_hdr(env.data(), chops::net::envelope_hdr_size) ==
+           env.size() - chops::net::envelope_hdr_size);
+  REQUIRE (mh(const_buffer(env.data(), env.size()), capture_io_intf(), ip::udp::endpoint()));
+  return msgs;
+}
+
+SCENARIO ( "Testing envelope_sender and envelope message handler",
+           "[msg_envelope]" ) {
+
+  using namespace std::experimental::net;
+  using namespace std::chrono_literals;
+
+  io_context ioc;
+  auto ioh = std::make_shared<capture_io_handler>();
+  auto sender = chops::net::make_envelope_sender(ioc, capture_io_intf(ioh), 32, 20ms);
+
+  GIVEN ("An envelope sender") {
+    WHEN ("a few small messages are sent and then flushed") {
+      REQUIRE (sender->send("ab", 2));
+      REQUIRE (sender->send("", 0));
+      REQUIRE (sender->send("cde", 3));
+      REQUIRE (sender->num_pending() == 3);
+      REQUIRE (ioh->bufs.empty());
+      sender->flush();
+      sender->flush();
+      THEN ("a single envelope containing all of the messages is sent") {
+        REQUIRE (sender->num_pending() == 0);
+        REQUIRE (ioh->bufs.size() == 1);
+        auto msgs = unpack(ioh->bufs[0]);
+        REQUIRE (msgs == std::vector<std::string> { "ab", "", "cde" });
+      }
+    }
+    AND_WHEN ("messages exceed the maximum envelope size") {
+      for (int i = 0; i < 10; ++i) {
+        REQUIRE (sender->send("0123456", 7));
+      }
+      THEN ("envelopes are sent without exceeding the maximum size") {
+        REQUIRE (ioh->bufs.size() == 3);
+        for (const auto& b : ioh->bufs) {
+          REQUIRE (b.size() <= 32);
+          REQUIRE (unpack(b).size() == 3);
+        }
+        REQUIRE (sender->num_pending() == 1);
+      }
+    }
+    AND_WHEN ("the maximum delay expires") {
+      REQUIRE (sender->send("xyz", 3));
+      ioc.run_for(200ms);
+      THEN ("the envelope is sent") {
+        REQUIRE (ioh->bufs.size() == 1);
+        REQUIRE (unpack(ioh->bufs[0]) == std::vector<std::string> { "xyz" });
+      }
+    }
+    AND_WHEN ("a malformed envelope is received") {
+      auto ba = chops::mutable_shared_buffer(std::string("\0\0\0\3\0\5a", 7).data(), 7);
+      auto mh = chops::net::make_envelope_msg_hdlr(
+            [] (const_buffer, capture_io_intf, ip::udp::endpoint) { return true; } );
+      THEN ("false is returned") {
+        REQUIRE_FALSE (mh(const_buffer(ba.data(), ba.size()), capture_io_intf(),
+                          ip::udp::endpoint()));
+        REQUIRE_FALSE (mh(const_buffer(ba.data(), 2), capture_io_intf(), ip::udp::endpoint()));
+      }
+    }
+  } // end given
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+/** @file
+ *
+ *  @ingroup test_module
+ *
+ *  @brief Test scenarios for message layout declarations and views.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2018 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch.hpp"
+
+#include <experimental/buffer>
+
+#include <cstddef> // std::size_t, std::byte
+#include <cstdint> // std::uint16_t, std::uint32_t, std::uint64_t, std::int32_t
+
+#include "net_ip/component/msg_layout.hpp"
+#include "net_ip/component/simple_variable_len_msg_frame.hpp"
+
+#include "utility/shared_buffer.hpp"
+#include "utility/make_byte_array.hpp"
+
+enum class msg_kind : std::uint8_t { hello = 1, data = 2 };
+
+using body_len = chops::net::layout_field<std::uint16_t, 0>;
+using kind = chops::net::layout_field<msg_kind, 2>;
+using seq_num = chops::net::layout_field<std::uint32_t, 3, chops::net::byte_order::little>;
+using stamp = chops::net::layout_field<std::uint64_t, 7>;
+using delta = chops::net::layout_field<std::int32_t, 15>;
+
+using hdr_layout = chops::net::msg_layout<body_len, kind, seq_num, stamp, delta>;
+
+static_assert(hdr_layout::size == 19);
+static_assert(hdr_layout::contains<seq_num>);
+static_assert(!hdr_layout::contains<chops::net::layout_field<std::uint8_t, 19>>);
+
+SCENARIO ( "Testing message layout encode and decode views",
+           "[msg_layout]" ) {
+
+  using namespace std::experimental::net;
+
+  GIVEN ("A buffer with known big and little endian field values") {
+    auto ba = chops::make_byte_array(0x01, 0x02, // body_len, big endian
+                                     0x02, // kind
+                                     0x04, 0x03, 0x02, 0x01, // seq_num, little endian
+                                     0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, // stamp
+                                     0xFF, 0xFF, 0xFF, 0xFE); // delta, -2
+    WHEN ("a layout view decodes the fields") {
+      auto v = chops::net::make_layout_view<hdr_layout>(const_buffer(ba.data(), ba.size()));
+      THEN ("the values are converted from the declared byte order") {
+        REQUIRE (v.get<body_len>() == 0x0102);
+        REQUIRE (v.get<kind>() == msg_kind::data);
+        REQUIRE (v.get<seq_num>() == 0x01020304u);
+        REQUIRE (v.get<stamp>() == 0x1122334455667788ull);
+        REQUIRE (v.get<delta>() == -2);
+        REQUIRE (chops::net::layout_hdr_decoder<body_len>(ba.data(), 2) == 0x0102);
+      }
+    }
+    AND_WHEN ("the same values are encoded into a shared buffer") {
+      chops::mutable_shared_buffer buf;
+      chops::net::make_layout_view<hdr_layout>(buf).set<body_len>(0x0102)
+                                                    .set<kind>(msg_kind::data)
+                                                    .set<seq_num>(0x01020304u)
+                                                    .set<stamp>(0x1122334455667788ull)
+                                                    .set<delta>(-2);
+      THEN ("the buffer is sized to the layout and the bytes match") {
+        REQUIRE (buf.size() == hdr_layout::size);
+        REQUIRE (chops::mutable_shared_buffer(ba.data(), ba.size()) == buf);
+      }
+    }
+    AND_WHEN ("a header decoder is used with a simple variable length message frame") {
+      auto mf = chops::net::make_simple_variable_len_msg_frame(
+                                   chops::net::layout_hdr_decoder<body_len>);
+      THEN ("the body length is returned") {
+        REQUIRE (mf(mutable_buffer(ba.data(), 2)) == 0x0102);
+        REQUIRE (mf(mutable_buffer(ba.data(), 0x0102)) == 0);
+      }
+    }
+  } // end given
+}
\ No newline at end of file
@@ -0,0 +1,367 @@
+/** @file
+ *
+ *  @ingroup test_module
+ *
+ *  @brief Test scenarios for @c rmcast_sender and @c rmcast_receiver classes.
+ *
+ *  A relay between the sender and receiver drops selected datagrams, simulating
+ *  multicast loss. A further scenario sends through a loopback multicast group, and is
+ *  skipped if the group cannot be joined.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2018 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch.hpp"
+
+#include <experimental/internet>
+#include <experimental/socket>
+#include <experimental/io_context>
+#include <experimental/buffer>
+
+#include <system_error> // std::error_code
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint64_t
+#include <memory> // std::make_shared
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "net_ip/component/reliable_multicast.hpp"
+#include "net_ip/component/worker.hpp"
+#include "net_ip/io_interface.hpp"
+
+#include "net_ip/shared_utility_test.hpp"
+
+using namespace std::experimental::net;
+using namespace std::chrono_literals;
+
+// forwards data datagrams to the receiver and everything else back to the sender,
+// dropping the first transmission of some sequence numbers and every transmission of
+// others
+struct lossy_relay {
+  ip::udp::socket           sock;
+  ip::udp::endpoint         sender_endp;
+  ip::udp::endpoint         recv_endp;
+  std::set<std::uint64_t>   drop_once;
+  std::set<std::uint64_t>   drop_always;
+  std::atomic_bool          done { false };
+  std::thread               thr;
+
+  lossy_relay(io_context& ioc, const ip::udp::endpoint& relay_endp) : sock(ioc, relay_endp) {
+    sock.non_blocking(true);
+  }
+
+  void start() {
+    thr = std::thread([this] {
+        char buf[2048];
+        while (!done) {
+          ip::udp::endpoint from;
+          std::error_code ec;
+          auto n = sock.receive_from(mutable_buffer(buf, sizeof(buf)), from, 0, ec);
+          if (ec) {
+            std::this_thread::sleep_for(1ms);
+            continue;
+          }
+          if (from == recv_endp) {
+            sock.send_to(const_buffer(buf, n), sender_endp, 0, ec);
+            continue;
+          }
+          auto v = chops::net::make_layout_view<chops::net::rmcast_hdr>(const_buffer(buf, n));
+          if (v.get<chops::net::rmcast_type_field>() == chops::net::rmcast_msg_type::data) {
+            auto seq = v.get<chops::net::rmcast_seq_field>();
+            if (drop_always.count(seq) != 0u || drop_once.erase(seq) != 0u) {
+              continue;
+            }
+          }
+          sock.send_to(const_buffer(buf, n), recv_endp, 0, ec);
+        }
+      }
+    );
+  }
+
+  void stop() {
+    done = true;
+    thr.join();
+  }
+};
+
+SCENARIO ( "Testing reliable multicast sender and receiver through a lossy relay",
+           "[reliable_multicast]" ) {
+
+  chops::net::worker wk;
+  wk.start();
+  auto& ioc = wk.get_io_context();
+
+  auto sender_endp = chops::test::make_udp_endpoint("127.0.0.1", 30881);
+  auto relay_endp = chops::test::make_udp_endpoint("127.0.0.1", 30882);
+  auto recv_endp = chops::test::make_udp_endpoint("127.0.0.1", 30883);
+
+  auto send_ioh = std::make_shared<chops::net::detail::udp_entity_io>(ioc, sender_endp);
+  send_ioh->start([] (auto, std::size_t, bool) { }, [] (auto, std::error_code) { });
+  auto recv_ioh = std::make_shared<chops::net::detail::udp_entity_io>(ioc, recv_endp);
+  recv_ioh->start([] (auto, std::size_t, bool) { }, [] (auto, std::error_code) { });
+
+  lossy_relay relay(ioc, relay_endp);
+  relay.sender_endp = sender_endp;
+  relay.recv_endp = recv_endp;
+
+  auto sender = chops::net::make_rmcast_sender(ioc, chops::net::udp_io_interface(send_ioh),
+                                               relay_endp, 64, 20ms);
+  auto receiver = chops::net::make_rmcast_receiver(ioc, chops::net::udp_io_interface(recv_ioh),
+                                                   32, 20ms, 5);
+  std::mutex mut;
+  std::vector<std::string> msgs;
+  std::vector<std::uint64_t> lost;
+
+  auto start_all = [&] {
+    relay.start();
+    REQUIRE (sender->start());
+    REQUIRE (receiver->start(
+        [&] (const_buffer b, chops::net::udp_io_interface, ip::udp::endpoint) {
+          std::lock_guard<std::mutex> gd { mut };
+          msgs.emplace_back(static_cast<const char*>(b.data()), b.size());
+          return true;
+        },
+        [&] (std::uint64_t first, std::uint64_t cnt) {
+          std::lock_guard<std::mutex> gd { mut };
+          for (auto i = first; i < first + cnt; ++i) {
+            lost.push_back(i);
+          }
+        },
+        256));
+  };
+  auto wait_for_msgs = [&] (std::size_t num) {
+    auto start = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - start < 5s) {
+      {
+        std::lock_guard<std::mutex> gd { mut };
+        if (msgs.size() >= num) {
+          return;
+        }
+      }
+      std::this_thread::sleep_for(10ms);
+    }
+  };
+
+  constexpr int num_msgs = 20;
+  std::vector<std::string> expected;
+  for (int i = 0; i < num_msgs; ++i) {
+    expected.push_back("msg" + std::to_string(i));
+  }
+
+  GIVEN ("A relay which drops the first transmission of some datagrams, including the last") {
+    relay.drop_once = { 1, 3, 7, 8, num_msgs - 1 };
+    start_all();
+    WHEN ("messages are sent") {
+      for (const auto& m : expected) {
+        sender->send(m.data(), m.size());
+        std::this_thread::sleep_for(2ms);
+      }
+      wait_for_msgs(num_msgs);
+      THEN ("all messages are delivered in order after retransmission") {
+        std::lock_guard<std::mutex> gd { mut };
+        REQUIRE (msgs == expected);
+        REQUIRE (lost.empty());
+        REQUIRE (sender->get_stats().num_retransmitted >= 5u);
+        REQUIRE (receiver->get_stats().num_naks_sent >= 4u);
+        REQUIRE (receiver->get_stats().num_delivered == num_msgs);
+      }
+    }
+  } // end given
+
+  GIVEN ("A relay which drops every transmission of one datagram") {
+    relay.drop_always = { 4 };
+    start_all();
+    WHEN ("messages are sent") {
+      for (const auto& m : expected) {
+        sender->send(m.data(), m.size());
+      }
+      wait_for_msgs(num_msgs - 1);
+      THEN ("after the NAK attempts the datagram is reported lost and the rest delivered") {
+        std::lock_guard<std::mutex> gd { mut };
+        auto exp = expected;
+        exp.erase(exp.begin() + 4);
+        REQUIRE (msgs == exp);
+        REQUIRE (lost == std::vector<std::uint64_t> { 4u });
+        REQUIRE (receiver->get_stats().num_lost == 1u);
+      }
+    }
+  } // end given
+
+  sender->stop();
+  receiver->stop();
+  relay.stop();
+  send_ioh->stop();
+  recv_ioh->stop();
+  wk.reset();
+}
+
+SCENARIO ( "Testing reliable multicast sender and receiver through a loopback multicast group",
+           "[reliable_multicast]" ) {
+
+  chops::net::worker wk;
+  wk.start();
+  auto& ioc = wk.get_io_context();
+
+  auto group = ip::make_address("239.255.88.1");
+  auto loopback = ip::make_address_v4("127.0.0.1");
+  auto sender_endp = chops::test::make_udp_endpoint("127.0.0.1", 30884);
+  auto group_endp = ip::udp::endpoint(group, 30885);
+
+  auto send_ioh = std::make_shared<chops::net::detail::udp_entity_io>(ioc, sender_endp);
+  send_ioh->start([] (auto, std::size_t, bool) { }, [] (auto, std::error_code) { });
+  auto recv_ioh = std::make_shared<chops::net::detail::udp_entity_io>(ioc,
+                      ip::udp::endpoint(ip::address_v4::any(), 30885));
+  recv_ioh->start([] (auto, std::size_t, bool) { }, [] (auto, std::error_code) { });
+
+  std::error_code ec;
+  send_ioh->get_socket().set_option(ip::multicast::outbound_interface(loopback), ec);
+  if (!ec) {
+    send_ioh->get_socket().set_option(ip::multicast::enable_loopback(true), ec);
+  }
+  if (!ec) {
+    recv_ioh->get_socket().set_option(ip::multicast::join_group(group.to_v4(), loopback), ec);
+  }
+
+  if (ec) {
+    WARN ("Loopback multicast unavailable, skipping: " << ec.message());
+  }
+  else {
+
+    GIVEN ("A sender and receiver joined to a loopback multicast group") {
+      auto sender = chops::net::make_rmcast_sender(ioc, chops::net::udp_io_interface(send_ioh),
+                                                   group_endp, 64, 20ms);
+      auto receiver = chops::net::make_rmcast_receiver(ioc,
+                                                       chops::net::udp_io_interface(recv_ioh),
+                                                       32, 20ms, 5);
+      std::mutex mut;
+      std::vector<std::string> msgs;
+      REQUIRE (sender->start());
+      REQUIRE (receiver->start(
+          [&] (const_buffer b, chops::net::udp_io_interface, ip::udp::endpoint) {
+            std::lock_guard<std::mutex> gd { mut };
+            msgs.emplace_back(static_cast<const char*>(b.data()), b.size());
+            return true;
+          },
+          [] (std::uint64_t, std::uint64_t) { },
+          256));
+
+      WHEN ("messages are sent to the group") {
+        constexpr int num_msgs = 20;
+        std::vector<std::string> expected;
+        for (int i = 0; i < num_msgs; ++i) {
+          expected.push_back("msg" + std::to_string(i));
+          sender->send(expected.back().data(), expected.back().size());
+          std::this_thread::sleep_for(2ms);
+        }
+        auto start = std::chrono::steady_clock::now();
+        while (std::chrono::steady_clock::now() - start < 5s) {
+          {
+            std::lock_guard<std::mutex> gd { mut };
+            if (msgs.size() >= expected.size()) {
+              break;
+            }
+          }
+          std::this_thread::sleep_for(10ms);
+        }
+        THEN ("all messages are delivered in order") {
+          std::lock_guard<std::mutex> gd { mut };
+          REQUIRE (msgs == expected);
+          REQUIRE (receiver->get_stats().num_delivered == num_msgs);
+        }
+      }
+      sender->stop();
+      receiver->stop();
+    } // end given
+
+  }
+
+  send_ioh->stop();
+  recv_ioh->stop();
+  wk.reset();
+}
+
+SCENARIO ( "Testing a reliable multicast receiver when a retransmission fills a full pending map",
+           "[reliable_multicast] [max_pending]" ) {
+
+  chops::net::worker wk;
+  wk.start();
+  auto& ioc = wk.get_io_context();
+
+  auto recv_endp = chops::test::make_udp_endpoint("127.0.0.1", 30886);
+  auto recv_ioh = std::make_shared<chops::net::detail::udp_entity_io>(ioc, recv_endp);
+  recv_ioh->start([] (auto, std::size_t, bool) { }, [] (auto, std::error_code) { });
+
+  // the NAK interval is long enough that no gap is given up on by the timer
+  constexpr std::size_t max_pending = 4u;
+  auto receiver = chops::net::make_rmcast_receiver(ioc, chops::net::udp_io_interface(recv_ioh),
+                                                   max_pending, 5s, 5);
+  std::mutex mut;
+  std::vector<std::uint64_t> seqs;
+  std::vector<std::uint64_t> lost;
+  REQUIRE (receiver->start(
+      [&] (const_buffer b, chops::net::udp_io_interface, ip::udp::endpoint) {
+        std::lock_guard<std::mutex> gd { mut };
+        seqs.push_back(static_cast<std::uint64_t>(*static_cast<const char*>(b.data()) - '0'));
+        return true;
+      },
+      [&] (std::uint64_t first, std::uint64_t cnt) {
+        std::lock_guard<std::mutex> gd { mut };
+        lost.push_back(first);
+        lost.push_back(cnt);
+      },
+      256));
+
+  // data datagrams are built directly, the payload is the sequence number as a digit
+  ip::udp::socket sender(ioc, chops::test::make_udp_endpoint("127.0.0.1", 0));
+  auto send_seq = [&] (std::uint64_t seq) {
+    chops::mutable_shared_buffer dg;
+    chops::net::make_layout_view<chops::net::rmcast_hdr>(dg)
+            .set<chops::net::rmcast_type_field>(chops::net::rmcast_msg_type::data)
+            .set<chops::net::rmcast_seq_field>(seq);
+    char digit = static_cast<char>('0' + seq);
+    dg.append(&digit, 1u);
+    sender.send_to(const_buffer(dg.data(), dg.size()), recv_endp);
+    std::this_thread::sleep_for(10ms);
+  };
+
+  GIVEN ("A receiver with a gap at sequence 1 and a full pending map") {
+    send_seq(0u);
+    for (std::uint64_t s = 2u; s < 2u + max_pending; ++s) {
+      send_seq(s);
+    }
+    WHEN ("the missing datagram arrives") {
+      send_seq(1u);
+      auto start = std::chrono::steady_clock::now();
+      while (std::chrono::steady_clock::now() - start < 2s) {
+        {
+          std::lock_guard<std::mutex> gd { mut };
+          if (seqs.size() >= 2u + max_pending) {
+            break;
+          }
+        }
+        std::this_thread::sleep_for(10ms);
+      }
+      THEN ("every datagram is delivered in order and no loss is reported") {
+        std::lock_guard<std::mutex> gd { mut };
+        REQUIRE (seqs == std::vector<std::uint64_t> { 0u, 1u, 2u, 3u, 4u, 5u });
+        REQUIRE (lost.empty());
+        REQUIRE (receiver->get_stats().num_lost == 0u);
+      }
+    }
+  } // end given
+
+  receiver->stop();
+  recv_ioh->stop();
+  wk.reset();
+}
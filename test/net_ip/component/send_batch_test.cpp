@@ -0,0 +1,94 @@
+/** @file
+ *
+ *  @ingroup test_module
+ *
+ *  @brief Test scenarios for @c send_batch class template.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2018 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch.hpp"
+
+#include <experimental/internet>
+#include <experimental/socket>
+#include <experimental/io_context>
+#include <experimental/buffer>
+
+#include <system_error> // std::error_code
+#include <cstddef> // std::size_t
+#include <memory> // std::make_shared
+#include <string>
+#include <vector>
+
+#include "net_ip/component/send_batch.hpp"
+#include "net_ip/component/worker.hpp"
+#include "net_ip/io_interface.hpp"
+
+#include "net_ip/shared_utility_test.hpp"
+
+SCENARIO ( "Testing send_batch across IO handlers on two io_contexts",
+           "[send_batch]" ) {
+
+  using namespace std::experimental::net;
+
+  chops::net::worker wk1;
+  wk1.start();
+  chops::net::worker wk2;
+  wk2.start();
+
+  constexpr int num_per_ctx = 2;
+
+  std::vector<ip::tcp::socket> clients;
+  std::vector<std::shared_ptr<chops::net::detail::tcp_io>> iohs;
+  for (auto* ioc : { &wk1.get_io_context(), &wk2.get_io_context() }) {
+    ip::tcp::acceptor acc(*ioc, ip::tcp::endpoint(ip::address_v4::loopback(), 0));
+    for (int i = 0; i < num_per_ctx; ++i) {
+      clients.emplace_back(*ioc);
+      iohs.push_back(chops::test::accept_tcp_io(acc, clients.back()));
+      REQUIRE (chops::net::tcp_io_interface(iohs.back()).start_io());
+    }
+  }
+
+  GIVEN ("A send batch with buffers added for all IO handlers") {
+    chops::net::send_batch<chops::net::tcp_io> batch;
+    constexpr int num_rounds = 50;
+    for (int r = 0; r < num_rounds; ++r) {
+      for (std::size_t i = 0; i < iohs.size(); ++i) {
+        std::string msg = std::to_string(i) + ":" + std::to_string(r) + ";";
+        REQUIRE (batch.add(chops::net::tcp_io_interface(iohs[i]), msg.data(), msg.size()));
+      }
+    }
+    REQUIRE_FALSE (batch.add(chops::net::tcp_io_interface(), "x", 1));
+    REQUIRE (batch.size() == num_rounds * iohs.size());
+
+    WHEN ("the batch is flushed") {
+      auto num_posts = batch.flush();
+      THEN ("one function object is posted per executor and each connection gets its data in order") {
+        REQUIRE (num_posts == 2u);
+        REQUIRE (batch.size() == 0u);
+        REQUIRE (batch.flush() == 0u);
+        for (std::size_t i = 0; i < clients.size(); ++i) {
+          std::string expected;
+          for (int r = 0; r < num_rounds; ++r) {
+            expected += std::to_string(i) + ":" + std::to_string(r) + ";";
+          }
+          std::string recvd(expected.size(), ' ');
+          read(clients[i], mutable_buffer(recvd.data(), recvd.size()));
+          REQUIRE (recvd == expected);
+        }
+      }
+    }
+  } // end given
+
+  for (auto& p : iohs) {
+    p->close();
+  }
+  wk1.reset();
+  wk2.reset();
+}
@@ -86,6 +86,17 @@ SCENARIO ( "Testing send_to_all class",
         REQUIRE(tot.bytes_in_output_queue == sta.size() * (io_handler_mock::qs_base + 1));
       }
     }
+    AND_WHEN ("get_total_tcp_kernel_stats is called") {
+      auto ioh1 = std::make_shared<io_handler_mock>();
+      auto ioh2 = std::make_shared<io_handler_mock>();
+      sta.add_io_interface(io_interface_mock(ioh1));
+      sta.add_io_interface(io_interface_mock(ioh2));
+      THEN ("queue sizes are summed and the maximum round trip time is returned") {
+        auto tot = sta.get_total_tcp_kernel_stats();
+        REQUIRE(tot.send_queue_bytes == sta.size() * (io_handler_mock::qs_base + 2));
+        REQUIRE(tot.rtt.count() == io_handler_mock::qs_base);
+      }
+    }
   } // end given
 }
 
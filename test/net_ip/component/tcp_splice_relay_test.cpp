@@ -0,0 +1,107 @@
+/** @file
+ *
+ *  @ingroup test_module
+ *
+ *  @brief Test scenarios for @c tcp_splice_relay class.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2018 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch.hpp"
+
+#ifdef __linux__
+
+#include <experimental/internet>
+#include <experimental/socket>
+#include <experimental/io_context>
+#include <experimental/buffer>
+
+#include <system_error> // std::error_code
+#include <cstddef> // std::size_t
+#include <memory> // std::make_shared
+#include <future>
+#include <string>
+#include <vector>
+
+#include "net_ip/component/tcp_splice_relay.hpp"
+#include "net_ip/component/worker.hpp"
+#include "net_ip/io_interface.hpp"
+
+SCENARIO ( "Testing tcp_splice_relay between two TCP connections",
+           "[tcp_splice_relay]" ) {
+
+  using namespace std::experimental::net;
+
+  chops::net::worker wk;
+  wk.start();
+  auto& ioc = wk.get_io_context();
+
+  ip::tcp::acceptor acc(ioc, ip::tcp::endpoint(ip::address_v4::loopback(), 0));
+  ip::tcp::socket client(ioc);
+  client.connect(acc.local_endpoint());
+  auto ioh_a = std::make_shared<chops::net::detail::tcp_io>(acc.accept(),
+                                                            [] (std::error_code, auto) { } );
+  ip::tcp::socket upstream(ioc);
+  upstream.connect(acc.local_endpoint());
+  auto ioh_b = std::make_shared<chops::net::detail::tcp_io>(acc.accept(),
+                                                            [] (std::error_code, auto) { } );
+
+  GIVEN ("A relay between a client connection and an upstream connection") {
+    auto relay = chops::net::make_tcp_splice_relay(chops::net::tcp_io_interface(ioh_a),
+                                                   chops::net::tcp_io_interface(ioh_b));
+    std::promise<std::error_code> done_prom;
+    auto done_fut = done_prom.get_future();
+    std::size_t a_to_b = 0;
+    std::size_t b_to_a = 0;
+    REQUIRE (relay->start([&] (std::error_code err, std::size_t ab, std::size_t ba) {
+        a_to_b = ab;
+        b_to_a = ba;
+        done_prom.set_value(err);
+      }
+    ));
+
+    WHEN ("data is sent in both directions followed by half-closes") {
+      std::vector<char> big(300000, 'z');
+      // write concurrently, the relay applies back pressure when the upstream isn't reading
+      auto wr_fut = std::async(std::launch::async, [&] {
+          write(client, const_buffer(big.data(), big.size()));
+        }
+      );
+      std::vector<char> recv_big(big.size());
+      read(upstream, mutable_buffer(recv_big.data(), recv_big.size()));
+      wr_fut.get();
+
+      std::string reply("a reply");
+      write(upstream, const_buffer(reply.data(), reply.size()));
+      std::string recv_reply(reply.size(), ' ');
+      read(client, mutable_buffer(recv_reply.data(), recv_reply.size()));
+
+      client.shutdown(ip::tcp::socket::shutdown_send);
+      char c;
+      std::error_code ec;
+      auto n = upstream.read_some(mutable_buffer(&c, 1), ec);
+      upstream.shutdown(ip::tcp::socket::shutdown_send);
+
+      THEN ("the bytes and the half-closes are relayed, and the done callback is invoked") {
+        REQUIRE (recv_big == big);
+        REQUIRE (recv_reply == reply);
+        REQUIRE (n == 0);
+        REQUIRE (ec == error::eof);
+        REQUIRE_FALSE (done_fut.get());
+        REQUIRE (a_to_b == big.size());
+        REQUIRE (b_to_a == reply.size());
+        REQUIRE (relay->get_bytes_a_to_b() == big.size());
+      }
+    }
+  } // end given
+
+  wk.reset();
+}
+
+#endif
\ No newline at end of file
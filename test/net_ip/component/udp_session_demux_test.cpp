@@ -0,0 +1,145 @@
+/** @file
+ *
+ *  @ingroup test_module
+ *
+ *  @brief Test scenarios for @c udp_session_demux class template.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2018 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch.hpp"
+
+#include <experimental/buffer>
+#include <experimental/internet>
+
+#include <cstddef> // std::size_t
+#include <memory> // std::make_shared
+#include <chrono>
+#include <thread>
+#include <functional> // std::ref
+
+#include "net_ip/component/udp_session_demux.hpp"
+
+#include "net_ip/shared_utility_test.hpp"
+
+#include "utility/make_byte_array.hpp"
+
+struct session_data {
+  int cnt = 0;
+};
+
+using demux_session = chops::net::basic_udp_session<chops::test::io_handler_mock, session_data>;
+
+SCENARIO ( "Testing udp_session_demux class",
+           "[udp_session_demux]" ) {
+
+  using namespace chops::test;
+  using namespace std::experimental::net;
+
+  auto ba = chops::make_byte_array(0x20, 0x21, 0x22);
+  const_buffer buf(ba.data(), ba.size());
+
+  auto ioh = std::make_shared<io_handler_mock>();
+  io_interface_mock io(ioh);
+
+  int expired = 0;
+  auto demux = chops::net::make_udp_session_demux<session_data, io_handler_mock>(
+        [] (const_buffer b, demux_session& s) {
+          ++s.get_state().cnt;
+          s.send(chops::const_shared_buffer(b.data(), b.size()));
+          return b.size() > 1; // single byte datagram ends the session
+        },
+        std::chrono::seconds(10),
+        [&expired] (demux_session&) { ++expired; }
+  );
+
+  GIVEN ("A udp_session_demux object") {
+    REQUIRE (demux.size() == 0);
+    WHEN ("datagrams arrive from multiple endpoints") {
+      auto e1 = make_udp_endpoint("127.0.0.1", 30001);
+      auto e2 = make_udp_endpoint("127.0.0.1", 30002);
+      REQUIRE (demux(buf, io, e1));
+      REQUIRE (demux(buf, io, e2));
+      REQUIRE (demux(buf, io, e1));
+      THEN ("a session is created for each endpoint and state is kept per session") {
+        REQUIRE (demux.size() == 2);
+        REQUIRE (demux.find(e1));
+        REQUIRE (demux.find(e1)->get_state().cnt == 2);
+        REQUIRE (demux.find(e2)->get_state().cnt == 1);
+        REQUIRE (demux.find(e2)->get_remote_endpoint() == e2);
+        REQUIRE_FALSE (demux.find(make_udp_endpoint("127.0.0.1", 30003)));
+        REQUIRE (ioh->send_called);
+      }
+    }
+    AND_WHEN ("the session handler returns false") {
+      auto e1 = make_udp_endpoint("127.0.0.1", 30001);
+      demux(buf, io, e1);
+      demux(const_buffer(ba.data(), 1), io, e1);
+      THEN ("the session is removed") {
+        REQUIRE (demux.size() == 0);
+        REQUIRE_FALSE (demux.find(e1));
+      }
+    }
+    AND_WHEN ("many sessions are created and every other one is erased") {
+      constexpr int num = 1000;
+      for (int i = 0; i < num; ++i) {
+        demux(buf, io, make_udp_endpoint("10.1.2.3", 20000+i));
+      }
+      REQUIRE (demux.size() == num);
+      REQUIRE (demux.capacity() >= 2*num);
+      for (int i = 0; i < num; i += 2) {
+        REQUIRE (demux.erase(make_udp_endpoint("10.1.2.3", 20000+i)));
+      }
+      THEN ("the remaining sessions are all found") {
+        REQUIRE (demux.size() == num/2);
+        for (int i = 0; i < num; ++i) {
+          auto p = demux.find(make_udp_endpoint("10.1.2.3", 20000+i));
+          REQUIRE ((p != nullptr) == (i % 2 == 1));
+        }
+        REQUIRE_FALSE (demux.erase(make_udp_endpoint("10.1.2.3", 20000)));
+      }
+    }
+    AND_WHEN ("expire_idle is called") {
+      demux(buf, io, make_udp_endpoint("127.0.0.1", 30001));
+      demux(buf, io, make_udp_endpoint("::1", 30001));
+      REQUIRE (demux.size() == 2);
+      auto now = std::chrono::steady_clock::now();
+      THEN ("only sessions idle longer than the idle time are removed") {
+        REQUIRE (demux.expire_idle(now) == 0);
+        REQUIRE (demux.size() == 2);
+        REQUIRE (demux.expire_idle(now + std::chrono::seconds(11)) == 2);
+        REQUIRE (demux.size() == 0);
+        REQUIRE (expired == 2);
+      }
+    }
+    AND_WHEN ("expire_idle is called with many sessions, half of them idle") {
+      constexpr int num = 1000;
+      for (int i = 0; i < num; i += 2) {
+        demux(buf, io, make_udp_endpoint("10.1.2.3", 20000+i));
+      }
+      auto idle_before = std::chrono::steady_clock::now();
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      for (int i = 1; i < num; i += 2) {
+        demux(buf, io, make_udp_endpoint("10.1.2.3", 20000+i));
+      }
+      auto cap = demux.capacity();
+      THEN ("the idle sessions are removed in place and the rest are all found") {
+        REQUIRE (demux.expire_idle(idle_before + std::chrono::seconds(10) + 
+                                   std::chrono::milliseconds(10)) == num/2);
+        REQUIRE (expired == num/2);
+        REQUIRE (demux.size() == num/2);
+        REQUIRE (demux.capacity() == cap);
+        for (int i = 0; i < num; ++i) {
+          auto p = demux.find(make_udp_endpoint("10.1.2.3", 20000+i));
+          REQUIRE ((p != nullptr) == (i % 2 == 1));
+        }
+      }
+    }
+  } // end given
+}
@@ -0,0 +1,104 @@
+/** @file
+ *
+ *  @ingroup test_module
+ *
+ *  @brief Test scenarios for @c connect_scheduler class.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2018 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch.hpp"
+
+#include <experimental/io_context>
+
+#include <cstddef> // std::size_t
+#include <memory> // std::make_shared
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "net_ip/connect_scheduler.hpp"
+#include "net_ip/component/worker.hpp"
+
+using namespace std::chrono_literals;
+
+SCENARIO ( "Connect scheduler test, in flight limit", "[connect_scheduler]" ) {
+
+  std::experimental::net::io_context ioc;
+
+  GIVEN ("A connect scheduler with a limit of 2 connects in progress and no rate limit") {
+    auto sched = std::make_shared<chops::net::connect_scheduler>(ioc, 2, 0);
+    std::size_t grants = 0;
+
+    WHEN ("5 permits are requested") {
+      for (int i = 0; i < 5; ++i) {
+        sched->acquire([&grants] { ++grants; } );
+      }
+      THEN ("2 are granted and 3 wait") {
+        REQUIRE (grants == 2u);
+        REQUIRE (sched->in_flight() == 2u);
+        REQUIRE (sched->waiting() == 3u);
+      }
+      AND_WHEN ("a permit is released") {
+        sched->release();
+        THEN ("one more is granted") {
+          REQUIRE (grants == 3u);
+          REQUIRE (sched->in_flight() == 2u);
+          REQUIRE (sched->waiting() == 2u);
+        }
+      }
+    }
+
+    WHEN ("a waiting request is cancelled") {
+      sched->acquire([&grants] { ++grants; } );
+      sched->acquire([&grants] { ++grants; } );
+      auto t = sched->acquire([&grants] { ++grants; } );
+      THEN ("it is removed, and a granted request cannot be cancelled") {
+        REQUIRE (sched->cancel(t));
+        REQUIRE_FALSE (sched->cancel(t));
+        REQUIRE_FALSE (sched->cancel(0u));
+        REQUIRE (sched->waiting() == 0u);
+        sched->release();
+        REQUIRE (grants == 2u);
+        REQUIRE (sched->in_flight() == 1u);
+      }
+    }
+  } // end given
+}
+
+SCENARIO ( "Connect scheduler test, rate limit", "[connect_scheduler]" ) {
+
+  chops::net::worker wk;
+  wk.start();
+  auto& ioc = wk.get_io_context();
+
+  GIVEN ("A connect scheduler limited to 50 connects per second") {
+    auto sched = std::make_shared<chops::net::connect_scheduler>(ioc, 0, 50);
+    std::atomic<std::size_t> grants { 0 };
+
+    WHEN ("6 permits are requested at once") {
+      auto start = std::chrono::steady_clock::now();
+      for (int i = 0; i < 6; ++i) {
+        sched->acquire([&grants] { ++grants; } );
+      }
+      THEN ("one is granted immediately and the rest are spaced 20 ms apart") {
+        REQUIRE (grants == 1u);
+        while (grants < 6u) {
+          std::this_thread::sleep_for(5ms);
+        }
+        REQUIRE ((std::chrono::steady_clock::now() - start) >= 100ms);
+        REQUIRE (sched->in_flight() == 6u);
+        REQUIRE (sched->waiting() == 0u);
+      }
+    }
+  } // end given
+
+  wk.reset();
+}
+
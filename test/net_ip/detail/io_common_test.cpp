@@ -145,6 +145,36 @@ void io_common_test(chops::const_shared_buffer buf, int num_bufs,
       }
     }
 
+    AND_WHEN ("Start_write_setup is called with completion function objects") {
+      int num_discarded = 0;
+      chops::net::send_completion_cb cb = [&num_discarded] (std::error_code err, std::size_t) {
+        if (err == std::make_error_code(chops::net::net_ip_errc::send_discarded)) {
+          ++num_discarded;
+        }
+      };
+      auto cb1 = cb;
+      bool ret = iocommon.start_write_setup(buf, cb1);
+      REQUIRE_FALSE (ret);
+      REQUIRE (num_discarded == 1);
+      iocommon.set_io_started();
+      auto cb2 = cb;
+      ret = iocommon.start_write_setup(buf, cb2);
+      REQUIRE (ret);
+      REQUIRE (cb2);
+      chops::repeat(num_bufs, [&iocommon, &buf, &endp, &cb] () {
+          auto c = cb;
+          iocommon.start_write_setup(buf, endp, c);
+        }
+      );
+      THEN ("the first is invoked immediately, then queued ones are invoked when discarded") {
+        REQUIRE (iocommon.get_output_queue_stats().output_queue_size == num_bufs);
+        iocommon.discard_queued(std::make_error_code(chops::net::net_ip_errc::send_discarded));
+        REQUIRE (num_discarded == num_bufs + 1);
+        REQUIRE (iocommon.get_output_queue_stats().output_queue_size == 0);
+        REQUIRE_FALSE (iocommon.is_write_in_progress());
+      }
+    }
+
   } // end given
 }
 
@@ -20,6 +20,10 @@
 #include <utility> // std::move
 #include <functional> // std::ref
 #include <cstddef> // std::size_t
+#include <vector>
+
+#include <experimental/io_context>
+#include <experimental/executor>
 
 #include "net_ip/detail/net_entity_common.hpp"
 #include "net_ip/basic_io_interface.hpp"
@@ -112,3 +116,93 @@ SCENARIO ( "Net entity base test", "[net_entity_common]" ) {
   net_entity_common_test<chops::test::io_handler_mock>();
 }
 
+SCENARIO ( "Net entity base test, callbacks delivered through an executor",
+           "[net_entity_common] [executor]" ) {
+
+  using namespace chops::net;
+  using iot = chops::test::io_handler_mock;
+
+  std::experimental::net::io_context ioc;
+  std::vector<std::size_t> nums;
+  std::vector<std::error_code> errs;
+
+  detail::net_entity_common<iot> ne { };
+  auto iohp = std::make_shared<iot>();
+
+  GIVEN ("A net_entity_common started with an io_context executor") {
+    ne.start([&nums] (basic_io_interface<iot> io, std::size_t n, bool) {
+          REQUIRE (io.is_valid());
+          nums.push_back(n);
+        },
+        [&errs] (basic_io_interface<iot>, std::error_code e) { errs.push_back(e); },
+        ioc.get_executor()
+    );
+
+    WHEN ("state change and error callbacks are invoked") {
+      ne.call_io_state_chg_cb(iohp, 1, true);
+      ne.call_io_state_chg_cb(iohp, 2, true);
+      ne.call_error_cb(iohp, std::make_error_code(net_ip_errc::tcp_io_handler_stopped));
+      ne.call_io_state_chg_cb(iohp, 0, false);
+      THEN ("nothing is delivered until the executor runs, then all callbacks run in order") {
+        REQUIRE (nums.empty());
+        REQUIRE (errs.empty());
+        REQUIRE (ioc.poll() == 1u); // a single posted function object for the batch
+        REQUIRE (nums == std::vector<std::size_t> { 1u, 2u, 0u });
+        REQUIRE (errs.size() == 1u);
+        REQUIRE (errs[0] == std::make_error_code(net_ip_errc::tcp_io_handler_stopped));
+        AND_THEN ("later callbacks are posted again") {
+          ne.call_io_state_chg_cb(iohp, 5, true);
+          ioc.restart();
+          REQUIRE (ioc.poll() == 1u);
+          REQUIRE (nums.back() == 5u);
+        }
+      }
+    }
+  } // end given
+}
+
+SCENARIO ( "Net entity base test, a throwing callback delivered through an executor",
+           "[net_entity_common] [executor]" ) {
+
+  using namespace chops::net;
+  using iot = chops::test::io_handler_mock;
+
+  std::experimental::net::io_context ioc;
+  std::vector<std::size_t> nums;
+  int num_errs = 0;
+
+  detail::net_entity_common<iot> ne { };
+  auto iohp = std::make_shared<iot>();
+
+  GIVEN ("A net_entity_common started with an error callback which throws the first time") {
+    ne.start([&nums] (basic_io_interface<iot>, std::size_t n, bool) { nums.push_back(n); },
+        [&num_errs] (basic_io_interface<iot>, std::error_code e) {
+          if (++num_errs == 1) {
+            throw std::system_error(e);
+          }
+        },
+        ioc.get_executor()
+    );
+
+    WHEN ("the throwing callback is followed by other callbacks in the same batch") {
+      ne.call_io_state_chg_cb(iohp, 1, true);
+      ne.call_error_cb(iohp, std::make_error_code(net_ip_errc::tcp_io_handler_stopped));
+      ne.call_io_state_chg_cb(iohp, 0, false);
+      THEN ("the exception propagates, and the rest of the callbacks are still delivered") {
+        REQUIRE_THROWS_AS (ioc.poll(), std::system_error);
+        REQUIRE (nums == std::vector<std::size_t> { 1u });
+        ioc.restart();
+        ioc.poll();
+        REQUIRE (nums == std::vector<std::size_t> { 1u, 0u });
+        AND_THEN ("later callbacks are posted again") {
+          ne.call_error_cb(iohp, std::make_error_code(net_ip_errc::tcp_io_handler_stopped));
+          ne.call_io_state_chg_cb(iohp, 7, true);
+          ioc.restart();
+          REQUIRE (ioc.poll() == 1u);
+          REQUIRE (num_errs == 2);
+          REQUIRE (nums.back() == 7u);
+        }
+      }
+    }
+  } // end given
+}
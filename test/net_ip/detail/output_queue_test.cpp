@@ -16,10 +16,15 @@
 #include "catch.hpp"
 
 #include <utility> // std::move
+#include <system_error> // std::error_code
+#include <cstddef> // std::size_t
+#include <vector>
+#include <iostream> // std::cerr for perf counter reports
 
 #include <experimental/internet> // endpoint declarations
 
 #include "net_ip/detail/output_queue.hpp"
+#include "net_ip/perf_counters.hpp"
 
 #include "utility/repeat.hpp"
 #include "utility/make_byte_array.hpp"
@@ -105,3 +110,174 @@ SCENARIO ( "Output_queue test, tcp endpoint",
                         ip::tcp::endpoint(ip::tcp::v6(), 9876));
 }
 
+
+SCENARIO ( "Output_queue test, interleaved adds and removes with endpoints and callbacks",
+           "[output_queue] [udp] [ring]" ) {
+  using namespace std::experimental::net;
+
+  chops::net::detail::output_queue<ip::udp::endpoint> outq { };
+  std::size_t num_cbs = 0;
+
+  GIVEN ("An output_queue that grows and wraps around") {
+    WHEN ("elements with and without endpoints and callbacks are added and removed") {
+      int next_add = 0;
+      int next_remove = 0;
+      auto count_cb = [&num_cbs] () {
+        return chops::net::send_completion_cb([&num_cbs] (std::error_code, std::size_t) { 
+            ++num_cbs;
+          }
+        );
+      };
+      auto add = [&] () {
+        auto ba = chops::make_byte_array(static_cast<unsigned char>(next_add));
+        chops::const_shared_buffer buf(ba.data(), ba.size());
+        ip::udp::endpoint endp(ip::udp::v4(), static_cast<unsigned short>(next_add));
+        switch (next_add % 4) {
+          case 0: outq.add_element(buf); break;
+          case 1: outq.add_element(buf, endp); break;
+          case 2: outq.add_element(buf, count_cb()); break;
+          case 3: outq.add_element(buf, endp, count_cb()); break;
+        }
+        ++next_add;
+      };
+      auto remove = [&] () {
+        auto e = outq.get_next_element();
+        REQUIRE (e);
+        REQUIRE (e->first.size() == 1u);
+        REQUIRE (static_cast<int>(*(e->first.data())) == (next_remove & 0xFF));
+        REQUIRE (e->second.has_value() == (next_remove % 2 == 1));
+        if (e->second) {
+          REQUIRE (e->second->port() == next_remove);
+        }
+        REQUIRE ((e->cb() != nullptr) == (next_remove % 4 >= 2));
+        if (auto cb = e->cb()) {
+          (*cb)(std::error_code(), 1u);
+        }
+        ++next_remove;
+      };
+      for (int round = 0; round < 20; ++round) {
+        chops::repeat(37, add);
+        chops::repeat(29, remove);
+      }
+      THEN ("elements come out in order with their endpoints and callbacks") {
+        REQUIRE (outq.get_queue_stats().output_queue_size == 20u * 8u);
+        REQUIRE (outq.get_queue_stats().bytes_in_output_queue == 20u * 8u);
+        chops::repeat(20 * 8, remove);
+        REQUIRE_FALSE (outq.get_next_element());
+        REQUIRE (outq.get_queue_stats().output_queue_size == 0u);
+        REQUIRE (outq.get_queue_stats().bytes_in_output_queue == 0u);
+        REQUIRE (num_cbs == static_cast<std::size_t>(next_add / 2));
+      }
+    }
+  } // end given
+}
+
+SCENARIO ( "Output_queue test, composite message parts",
+           "[output_queue] [udp] [composite_send]" ) {
+  using namespace std::experimental::net;
+
+  chops::net::detail::output_queue<ip::udp::endpoint> outq { };
+
+  GIVEN ("An output_queue and a body shared by composite messages") {
+    auto body_ba = chops::make_byte_array(0x0B, 0x0B, 0x0B, 0x0B);
+    chops::const_shared_buffer body(body_ba.data(), body_ba.size());
+    auto hdr_ba = chops::make_byte_array(0x0A, 0x0A);
+    chops::const_shared_buffer hdr(hdr_ba.data(), hdr_ba.size());
+    ip::udp::endpoint endp(ip::udp::v4(), 5555u);
+
+    WHEN ("composite messages are added between single buffers") {
+      outq.add_element(hdr);
+      outq.add_element(chops::net::shared_buffer_parts { hdr, body });
+      outq.add_element(chops::net::shared_buffer_parts { hdr, body, hdr }, endp);
+      outq.add_element(body);
+      THEN ("the queued byte count includes all of the parts, and the parts come out in order") {
+        REQUIRE (outq.get_queue_stats().output_queue_size == 4u);
+        REQUIRE (outq.get_queue_stats().bytes_in_output_queue == 2u + 6u + 8u + 4u);
+        auto e = outq.get_next_element();
+        REQUIRE_FALSE (e->parts());
+        e = outq.get_next_element();
+        REQUIRE (e->parts()->size() == 2u);
+        REQUIRE_FALSE (e->second);
+        REQUIRE (outq.get_queue_stats().bytes_in_output_queue == 8u + 4u);
+        e = outq.get_next_element();
+        REQUIRE (e->parts()->size() == 3u);
+        REQUIRE (e->second);
+        REQUIRE (*(e->second) == endp);
+        e = outq.get_next_element();
+        REQUIRE_FALSE (e->parts());
+        REQUIRE (e->first.size() == body.size());
+        REQUIRE (outq.get_queue_stats().output_queue_size == 0u);
+        REQUIRE (outq.get_queue_stats().bytes_in_output_queue == 0u);
+      }
+    }
+  } // end given
+}
+
+SCENARIO ( "Output_queue test, one buffer for many destinations",
+           "[output_queue] [udp] [send_to_many]" ) {
+  using namespace std::experimental::net;
+
+  chops::net::detail::output_queue<ip::udp::endpoint> outq { };
+
+  GIVEN ("An output_queue and a buffer sent to several destinations") {
+    auto ba = chops::make_byte_array(0x0A, 0x0B, 0x0C);
+    chops::const_shared_buffer buf(ba.data(), ba.size());
+    std::vector<ip::udp::endpoint> endps { ip::udp::endpoint(ip::udp::v4(), 5555u),
+                                           ip::udp::endpoint(ip::udp::v4(), 5556u),
+                                           ip::udp::endpoint(ip::udp::v4(), 5557u) };
+
+    WHEN ("the buffer and destinations are added between single buffers") {
+      outq.add_element(buf);
+      outq.add_element(buf, std::vector<ip::udp::endpoint>(endps));
+      outq.add_element(buf, endps[0]);
+      THEN ("they are queued as one element and come out in order") {
+        REQUIRE (outq.get_queue_stats().output_queue_size == 3u);
+        auto e = outq.get_next_element();
+        REQUIRE_FALSE (e->endps());
+        e = outq.get_next_element();
+        REQUIRE (*(e->endps()) == endps);
+        REQUIRE_FALSE (e->second);
+        REQUIRE (e->first.size() == buf.size());
+        e = outq.get_next_element();
+        REQUIRE_FALSE (e->endps());
+        REQUIRE (*(e->second) == endps[0]);
+        REQUIRE (outq.get_queue_stats().output_queue_size == 0u);
+        REQUIRE (outq.get_queue_stats().bytes_in_output_queue == 0u);
+      }
+    }
+  } // end given
+}
+
+SCENARIO ( "Output_queue test, perf counters for adds and removes",
+           "[output_queue] [tcp] [perf]" ) {
+  using namespace std::experimental::net;
+
+  constexpr int num_bufs = 100000;
+  chops::net::detail::output_queue<ip::tcp::endpoint> outq { };
+  auto ba = chops::make_byte_array(0x40, 0x41, 0x42, 0x43);
+  chops::const_shared_buffer buf(ba.data(), ba.size());
+  chops::test::perf_counters pc;
+
+  GIVEN ("An output_queue kept at a shallow depth") {
+    WHEN ("many bufs are added and removed, in groups of 8") {
+      std::size_t num_removed = 0;
+      pc.start();
+      chops::repeat(num_bufs / 8, [&] () {
+          chops::repeat(8, [&outq, &buf] () { outq.add_element(buf); } );
+          chops::repeat(8, [&outq, &num_removed] () {
+              if (outq.get_next_element()) {
+                ++num_removed;
+              }
+            }
+          );
+        }
+      );
+      pc.stop();
+      pc.report(std::cerr, "output_queue add and remove", num_bufs);
+      THEN ("all bufs are removed") {
+        REQUIRE (num_removed == static_cast<std::size_t>(num_bufs));
+        REQUIRE_FALSE (outq.get_next_element());
+      }
+    }
+  } // end given
+}
@@ -0,0 +1,150 @@
+/** @file
+ *
+ *  @ingroup test_module
+ *
+ *  @brief Test scenarios for @c socket_timestamps detail class and functions.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2018 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch.hpp"
+
+#include <experimental/internet>
+#include <experimental/socket>
+#include <experimental/io_context>
+#include <experimental/buffer>
+
+#include <system_error> // std::error_code
+#include <cstddef> // std::size_t
+#include <chrono>
+#include <thread>
+
+#include "net_ip/detail/socket_timestamps.hpp"
+
+#include "net_ip/shared_utility_test.hpp"
+
+#include "utility/make_byte_array.hpp"
+
+using namespace std::experimental::net;
+
+using ts_mock = chops::test::io_handler_mock;
+
+struct plain_hdlr {
+  bool operator()(const_buffer, chops::net::basic_io_interface<ts_mock>, ip::udp::endpoint) {
+    return true;
+  }
+};
+
+struct ts_hdlr {
+  bool operator()(const_buffer, chops::net::basic_io_interface<ts_mock>, ip::udp::endpoint,
+                  chops::net::detail::rx_timestamp) {
+    return false;
+  }
+};
+
+SCENARIO ( "Testing message handler timestamp detection and invocation",
+           "[socket_timestamps]" ) {
+
+  using namespace chops::net::detail;
+
+  GIVEN ("A message handler with and one without a timestamp parameter") {
+    plain_hdlr ph;
+    ts_hdlr th;
+    THEN ("only the timestamp handler is detected") {
+      REQUIRE_FALSE (is_timestamp_msg_hdlr<plain_hdlr, ts_mock>);
+      REQUIRE (is_timestamp_msg_hdlr<ts_hdlr, ts_mock>);
+    }
+    AND_THEN ("each is invoked with the right number of parameters") {
+      chops::net::basic_io_interface<ts_mock> io;
+      ip::udp::endpoint endp;
+      REQUIRE (invoke_msg_hdlr<ts_mock>(ph, const_buffer(), io, endp, rx_timestamp()));
+      REQUIRE_FALSE (invoke_msg_hdlr<ts_mock>(th, const_buffer(), io, endp, rx_timestamp()));
+    }
+  } // end given
+}
+
+#ifdef __linux__
+
+SCENARIO ( "Testing kernel receive and transmit timestamps on loopback",
+           "[socket_timestamps]" ) {
+
+  using namespace chops::net::detail;
+  using namespace std::chrono_literals;
+
+  auto ba = chops::make_byte_array(0x01, 0x02, 0x03, 0x04);
+
+  io_context ioc;
+  ip::udp::socket recv_sock(ioc, ip::udp::endpoint(ip::address_v4::loopback(), 0));
+  ip::udp::socket send_sock(ioc, ip::udp::endpoint(ip::address_v4::loopback(), 0));
+  auto recv_endp = recv_sock.local_endpoint();
+
+  GIVEN ("Two UDP sockets bound to loopback") {
+    socket_timestamps recv_ts;
+    socket_timestamps send_ts;
+    std::error_code ec;
+    REQUIRE (recv_ts.enable_rx(recv_sock.native_handle(), ec));
+    REQUIRE (recv_ts.is_rx_enabled());
+    REQUIRE (send_ts.enable_tx(send_sock.native_handle(), ec));
+    REQUIRE (send_ts.is_tx_enabled());
+
+    WHEN ("datagrams are sent and received") {
+      auto before = std::chrono::system_clock::now();
+      constexpr int num = 5;
+      for (int i = 0; i < num; ++i) {
+        send_ts.record_write(1);
+        send_sock.send_to(const_buffer(ba.data(), ba.size()), recv_endp);
+      }
+      std::this_thread::sleep_for(100ms);
+
+      char data[16];
+      rx_timestamp ts { };
+      std::size_t addr_len = 0;
+      auto nb = recv_with_timestamp(recv_sock.native_handle(), data, sizeof(data),
+                                    nullptr, addr_len, ts, ec);
+      send_ts.drain_tx(send_sock.native_handle());
+
+      THEN ("the receive timestamp is filled in and transmit latency is recorded") {
+        REQUIRE_FALSE (ec);
+        REQUIRE (nb == ba.size());
+        REQUIRE (ts >= before - 1s);
+        REQUIRE (ts <= std::chrono::system_clock::now());
+        auto st = send_ts.get_output_latency_stats();
+        REQUIRE (st.num_tx_timestamps == num);
+        REQUIRE (st.max_tx_latency <= st.total_tx_latency);
+      }
+    }
+    AND_WHEN ("datagrams are sent from a socket with only receive timestamps enabled") {
+      socket_timestamps rx_only_ts;
+      REQUIRE (rx_only_ts.enable_rx(send_sock.native_handle(), ec));
+      for (int i = 0; i < 5; ++i) {
+        rx_only_ts.record_write(1);
+        send_sock.send_to(const_buffer(ba.data(), ba.size()), recv_endp);
+      }
+      THEN ("transmit timestamps are not enabled and no writes are kept pending") {
+        REQUIRE (rx_only_ts.is_rx_enabled());
+        REQUIRE_FALSE (rx_only_ts.is_tx_enabled());
+        REQUIRE (rx_only_ts.pending_size() == 0u);
+      }
+    }
+    AND_WHEN ("no data is available") {
+      char data[16];
+      rx_timestamp ts { };
+      std::size_t addr_len = 0;
+      auto nb = recv_with_timestamp(recv_sock.native_handle(), data, sizeof(data),
+                                    nullptr, addr_len, ts, ec);
+      THEN ("a would block error is returned") {
+        REQUIRE (nb == 0);
+        REQUIRE (ec == std::errc::operation_would_block);
+        REQUIRE (ts == rx_timestamp { });
+      }
+    }
+  } // end given
+}
+
+#endif
\ No newline at end of file
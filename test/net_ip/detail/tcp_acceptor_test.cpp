@@ -288,3 +288,74 @@ SCENARIO ( "Tcp acceptor test,  LF msgs, two-way, interval 0, 25 connectors, man
                   std::string_view("\n"), make_empty_lf_text_msg() );
 
 }
+
+SCENARIO ( "Tcp acceptor test, abortive stop resets connected clients",
+           "[tcp_acc] [abortive_stop]" ) {
+
+  chops::net::worker wk;
+  wk.start();
+  auto& ioc = wk.get_io_context();
+
+  GIVEN ("An acceptor with a number of connected clients") {
+    constexpr int num_conns = 5;
+    auto endp_seq = 
+        chops::net::endpoints_resolver<ip::tcp>(ioc).make_endpoints(true, test_host, test_port);
+    auto acc_ptr = 
+        std::make_shared<chops::net::detail::tcp_acceptor>(ioc, *(endp_seq.cbegin()), true);
+
+    std::promise<void> all_conn_prom;
+    auto all_conn_fut = all_conn_prom.get_future();
+    acc_ptr->start(
+      [&all_conn_prom] (chops::net::tcp_io_interface io, std::size_t num, bool starting) {
+        if (starting) {
+          io.start_io(1, [] (const_buffer, chops::net::tcp_io_interface, ip::tcp::endpoint) {
+              return true;
+            }
+          );
+          if (num == num_conns) {
+            all_conn_prom.set_value();
+          }
+        }
+      },
+      [] (chops::net::tcp_io_interface, std::error_code) { }
+    );
+
+    std::vector<ip::tcp::socket> clients;
+    chops::repeat(num_conns, [&] () {
+        clients.emplace_back(ioc);
+        connect(clients.back(), endp_seq);
+      }
+    );
+    REQUIRE (all_conn_fut.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+
+    WHEN ("the acceptor is stopped with an abortive close") {
+      REQUIRE (acc_ptr->stop(true));
+      THEN ("the acceptor is stopped and each client sees a connection reset") {
+        REQUIRE_FALSE (acc_ptr->is_started());
+        REQUIRE_FALSE (acc_ptr->stop(true));
+        for (auto& c : clients) {
+          char ch;
+          std::error_code ec;
+          c.read_some(mutable_buffer(&ch, 1), ec);
+          REQUIRE (ec == std::errc::connection_reset);
+        }
+      }
+    }
+    AND_WHEN ("the acceptor is stopped asynchronously with an abortive close") {
+      std::promise<void> done_prom;
+      auto done_fut = done_prom.get_future();
+      REQUIRE (acc_ptr->stop_async(true, [&done_prom] () { done_prom.set_value(); } ));
+      THEN ("done is invoked once the connections are closed, and each client sees a reset") {
+        REQUIRE (done_fut.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+        REQUIRE_FALSE (acc_ptr->is_started());
+        for (auto& c : clients) {
+          char ch;
+          std::error_code ec;
+          c.read_some(mutable_buffer(&ch, 1), ec);
+          REQUIRE (ec == std::errc::connection_reset);
+        }
+      }
+    }
+  } // end given
+  wk.reset();
+}
@@ -28,6 +28,10 @@
 #include <chrono>
 #include <functional> // std::ref, std::cref
 #include <string_view>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <iostream> // std::cerr for perf counter reports
 
 #include "net_ip/detail/tcp_io.hpp"
 
@@ -35,9 +39,9 @@
 #include "net_ip/endpoints_resolver.hpp"
 
 #include "net_ip/shared_utility_test.hpp"
+#include "net_ip/perf_counters.hpp"
 #include "utility/shared_buffer.hpp"
-
-// #include <iostream>
+#include "utility/repeat.hpp"
 
 using namespace std::experimental::net;
 using namespace chops::test;
@@ -99,6 +103,7 @@ std::size_t connector_func (const vec_buf& in_msg_vec, io_context& ioc,
 void acc_conn_test (const vec_buf& in_msg_vec, bool reply, int interval, std::string_view delim,
                     chops::const_shared_buffer empty_msg) {
 
+  chops::test::perf_counters pc; // before the worker thread starts, to include it
   chops::net::worker wk;
   wk.start();
   auto& ioc = wk.get_io_context();
@@ -114,6 +119,8 @@ void acc_conn_test (const vec_buf& in_msg_vec, bool reply, int interval, std::st
 
         INFO ("Creating connector asynchronously, msg interval: " << interval);
 
+        pc.start();
+
         auto conn_fut = std::async(std::launch::async, connector_func, std::cref(in_msg_vec), 
                                    std::ref(ioc), interval, delim, empty_msg);
 
@@ -129,6 +136,8 @@ void acc_conn_test (const vec_buf& in_msg_vec, bool reply, int interval, std::st
 // std::cerr << "Inside acc_conn_test, acc_err: " << acc_err << ", " << acc_err.message() << std::endl;
 
         auto conn_cnt = conn_fut.get();
+        pc.stop();
+        pc.report(std::cerr, "tcp_io", in_msg_vec.size());
 
         REQUIRE (in_msg_vec.size() == cnt);
         if (reply) {
@@ -252,3 +261,287 @@ SCENARIO ( "Tcp IO handler test, LF msgs, two-way, interval 0, many msgs",
 
 }
 
+SCENARIO ( "Tcp IO handler test, fixed size records, per record and batch delivery",
+           "[tcp_io] [fixed_size]" ) {
+
+  chops::net::worker wk;
+  wk.start();
+  auto& ioc = wk.get_io_context();
+
+  constexpr std::size_t rec_size = 6;
+  constexpr int num_recs = 500;
+
+  std::string data;
+  for (int i = 0; i < num_recs; ++i) {
+    data += std::string(rec_size, static_cast<char>('a' + i % 26));
+  }
+
+  auto run = [&] (auto&& mh) {
+    ip::tcp::acceptor acc(ioc, ip::tcp::endpoint(ip::address_v4::loopback(), 0));
+    ip::tcp::socket client(ioc);
+    client.connect(acc.local_endpoint());
+    notify_prom_type prom;
+    auto fut = prom.get_future();
+    auto iohp = std::make_shared<chops::net::detail::tcp_io>(acc.accept(), notify_me(std::move(prom)));
+    chops::net::tcp_io_interface(iohp).start_io_fixed(rec_size, 64, mh);
+    // write in uneven chunks so that records are split across reads
+    for (std::size_t pos = 0; pos < data.size(); pos += 31) {
+      write(client, const_buffer(data.data() + pos, std::min<std::size_t>(31, data.size() - pos)));
+    }
+    client.close();
+    auto err = fut.get();
+    iohp->close();
+    return err;
+  };
+
+  GIVEN ("A stream of fixed size records written in uneven chunks") {
+    WHEN ("a per record message handler is used") {
+      std::string recvd;
+      int calls = 0;
+      auto err = run([&] (const_buffer buf, chops::net::tcp_io_interface, ip::tcp::endpoint) {
+          ++calls;
+          recvd.append(static_cast<const char*>(buf.data()), buf.size());
+          return buf.size() == rec_size;
+        }
+      );
+      THEN ("each record is delivered once, in order") {
+        REQUIRE (err);
+        REQUIRE (calls == num_recs);
+        REQUIRE (recvd == data);
+      }
+    }
+    AND_WHEN ("a batch message handler is used") {
+      std::string recvd;
+      std::size_t recs = 0;
+      auto err = run([&] (const_buffer buf, chops::net::tcp_io_interface, ip::tcp::endpoint,
+                          std::size_t n) {
+          recs += n;
+          recvd.append(static_cast<const char*>(buf.data()), buf.size());
+          return buf.size() == n * rec_size;
+        }
+      );
+      THEN ("all records are delivered in spans of whole records") {
+        REQUIRE (err);
+        REQUIRE (recs == num_recs);
+        REQUIRE (recvd == data);
+      }
+    }
+  } // end given
+
+  wk.reset();
+}
+
+SCENARIO ( "Tcp IO handler test, send completion notifications",
+           "[tcp_io] [send_completion]" ) {
+
+  chops::net::worker wk;
+  wk.start();
+  auto& ioc = wk.get_io_context();
+
+  GIVEN ("A tcp_io handler started for sending only, with a connected client") {
+    tcp_io_fixture fx(ioc);
+    auto& client = fx.client;
+    auto& io = fx.io;
+    REQUIRE (io.start_io());
+
+    WHEN ("large buffers are sent with completion function objects") {
+      constexpr int num_bufs = 10;
+      constexpr std::size_t buf_size = 100000;
+      std::mutex mut;
+      std::vector<std::size_t> completions;
+      std::promise<void> all_done;
+      chops::repeat(num_bufs, [&] () {
+          io.send(chops::const_shared_buffer(std::string(buf_size, 'x').data(), buf_size),
+                  [&] (std::error_code err, std::size_t nb) {
+              std::lock_guard<std::mutex> gd { mut };
+              completions.push_back(err ? 0 : nb);
+              if (completions.size() == num_bufs) {
+                all_done.set_value();
+              }
+            }
+          );
+        }
+      );
+      std::vector<char> recv(num_bufs * buf_size);
+      read(client, mutable_buffer(recv.data(), recv.size()));
+      THEN ("each function object is invoked once with the full buffer size") {
+        REQUIRE (all_done.get_future().wait_for(std::chrono::seconds(5)) == 
+                 std::future_status::ready);
+        std::lock_guard<std::mutex> gd { mut };
+        REQUIRE (completions == std::vector<std::size_t>(num_bufs, buf_size));
+      }
+    }
+    AND_WHEN ("a buffer is sent after the handler is closed") {
+      fx.iohp->close();
+      std::promise<std::error_code> prom;
+      auto fut = prom.get_future();
+      io.send(chops::const_shared_buffer("abc", 3),
+              [&prom] (std::error_code err, std::size_t) { prom.set_value(err); } );
+      THEN ("the function object is invoked with a discarded error") {
+        REQUIRE (fut.get() == std::make_error_code(chops::net::net_ip_errc::send_discarded));
+      }
+    }
+  } // end given
+
+  wk.reset();
+}
+
+chops::const_shared_buffer make_frame(char kind, std::size_t id, 
+                                      const char* data, std::size_t sz) {
+  chops::mutable_shared_buffer buf;
+  buf.append(static_cast<std::byte>(kind));
+  buf.append(static_cast<std::byte>(id));
+  buf.append(static_cast<std::byte>((sz >> 8) & 0xFF));
+  buf.append(static_cast<std::byte>(sz & 0xFF));
+  buf.append(data, sz);
+  return chops::const_shared_buffer(std::move(buf));
+}
+
+SCENARIO ( "Tcp IO handler test, fragmentation of large buffers",
+           "[tcp_io] [fragment]" ) {
+
+  chops::net::worker wk;
+  wk.start();
+  auto& ioc = wk.get_io_context();
+
+  GIVEN ("A tcp_io handler with fragmentation enabled, with a connected client") {
+    constexpr std::size_t frag_size = 1000;
+    tcp_io_fixture fx(ioc);
+    auto& client = fx.client;
+    auto& io = fx.io;
+    REQUIRE (io.enable_fragmentation(frag_size, 
+               [] (const_buffer frag, std::size_t id, std::size_t, std::size_t) {
+                 return make_frame('F', id, static_cast<const char*>(frag.data()), frag.size());
+               }
+            ));
+    REQUIRE (io.start_io());
+    REQUIRE_FALSE (io.enable_fragmentation(frag_size, chops::net::fragment_encoder()));
+
+    WHEN ("two large buffers are sent, followed by a small buffer") {
+      std::string big1(20 * frag_size + 10, 'a');
+      std::string big2(5 * frag_size, 'b');
+      std::promise<std::size_t> big_prom;
+      auto big_fut = big_prom.get_future();
+      io.send(chops::const_shared_buffer(big1.data(), big1.size()),
+              [&big_prom] (std::error_code, std::size_t nb) { big_prom.set_value(nb); } );
+      io.send(chops::const_shared_buffer(big2.data(), big2.size()));
+      io.send(make_frame('S', 0, "hello", 5));
+
+      std::string recv1, recv2;
+      int frame_num = 0;
+      int small_frame_num = -1;
+      while (recv1.size() < big1.size() || recv2.size() < big2.size() || small_frame_num < 0) {
+        char hdr[4];
+        read(client, mutable_buffer(hdr, 4));
+        std::size_t sz = (static_cast<unsigned char>(hdr[2]) << 8) | 
+                          static_cast<unsigned char>(hdr[3]);
+        std::string body(sz, ' ');
+        read(client, mutable_buffer(body.data(), sz));
+        if (hdr[0] == 'S') {
+          small_frame_num = frame_num;
+        }
+        else {
+          (hdr[1] == 0 ? recv1 : recv2) += body;
+        }
+        ++frame_num;
+      }
+      THEN ("fragments are interleaved and reassemble to the original buffers") {
+        REQUIRE (recv1 == big1);
+        REQUIRE (recv2 == big2);
+        REQUIRE (small_frame_num < 4);
+        REQUIRE (frame_num == 21 + 5 + 1);
+        REQUIRE (big_fut.get() == big1.size());
+      }
+    }
+  } // end given
+
+  wk.reset();
+}
+
+SCENARIO ( "Tcp IO handler test, inline sends of small buffers",
+           "[tcp_io] [inline_send]" ) {
+
+  chops::net::worker wk;
+  wk.start();
+  auto& ioc = wk.get_io_context();
+
+  GIVEN ("A tcp_io handler with inline sends enabled, with a connected client") {
+    tcp_io_fixture fx(ioc);
+    auto& client = fx.client;
+    auto& io = fx.io;
+    REQUIRE_FALSE (io.enable_inline_sends(chops::net::max_inline_send_size + 1));
+    REQUIRE (io.enable_inline_sends(32));
+    REQUIRE (io.start_io());
+    REQUIRE_FALSE (io.enable_inline_sends(32));
+
+    WHEN ("small buffers are sent, interleaved with larger buffers") {
+      std::string expected;
+      for (int i = 0; i < 2000; ++i) {
+        if (i % 100 == 99) {
+          std::string big(1000 + i, static_cast<char>('a' + (i / 100)));
+          io.send(chops::const_shared_buffer(big.data(), big.size()));
+          expected += big;
+        }
+        else {
+          std::string sm = "<" + std::to_string(i) + ">";
+          io.send(sm.data(), sm.size()); // inline
+          expected += sm;
+        }
+      }
+      std::string recvd(expected.size(), ' ');
+      read(client, mutable_buffer(recvd.data(), recvd.size()));
+      THEN ("all bytes are received in send order") {
+        REQUIRE (recvd == expected);
+      }
+    }
+  } // end given
+
+  wk.reset();
+}
+
+SCENARIO ( "Tcp IO handler test, composite header and shared body sends",
+           "[tcp_io] [composite_send]" ) {
+
+  chops::net::worker wk;
+  wk.start();
+  auto& ioc = wk.get_io_context();
+
+  GIVEN ("A tcp_io handler with a connected client, and a body shared by all messages") {
+    tcp_io_fixture fx(ioc);
+    auto& client = fx.client;
+    auto& io = fx.io;
+    REQUIRE (io.start_io());
+    std::string body_str(5000, 'b');
+    chops::const_shared_buffer body(body_str.data(), body_str.size());
+
+    WHEN ("header and body messages are sent, interleaved with single buffers") {
+      std::string expected;
+      for (int i = 0; i < 200; ++i) {
+        std::string hdr = "<" + std::to_string(i) + ">";
+        if (i % 3 == 0) {
+          io.send(chops::const_shared_buffer(hdr.data(), hdr.size()), body);
+          expected += hdr + body_str;
+        }
+        else if (i % 3 == 1) {
+          std::string trailer = "</" + std::to_string(i) + ">";
+          io.send(chops::net::shared_buffer_parts { 
+                    chops::const_shared_buffer(hdr.data(), hdr.size()),
+                    body,
+                    chops::const_shared_buffer(trailer.data(), trailer.size()) });
+          expected += hdr + body_str + trailer;
+        }
+        else {
+          io.send(chops::const_shared_buffer(hdr.data(), hdr.size()));
+          expected += hdr;
+        }
+      }
+      std::string recvd(expected.size(), ' ');
+      read(client, mutable_buffer(recvd.data(), recvd.size()));
+      THEN ("all bytes are received in send order") {
+        REQUIRE (recvd == expected);
+      }
+    }
+  } // end given
+
+  wk.reset();
+}
@@ -0,0 +1,96 @@
+/** @file
+ *
+ *  @ingroup test_module
+ *
+ *  @brief Test scenarios for @c tcp_kernel_stats detail functions.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2018 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch.hpp"
+
+#include <experimental/internet>
+#include <experimental/socket>
+#include <experimental/io_context>
+#include <experimental/buffer>
+
+#include <system_error> // std::error_code
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "net_ip/detail/tcp_kernel_stats.hpp"
+
+SCENARIO ( "Testing tcp_kernel_stats accumulation",
+           "[tcp_kernel_stats]" ) {
+
+  using namespace chops::net;
+
+  GIVEN ("Two kernel stats samples") {
+    tcp_kernel_stats s1 { };
+    s1.rtt = std::chrono::microseconds(50);
+    s1.send_queue_bytes = 10;
+    s1.total_retrans = 1;
+    tcp_kernel_stats s2 { };
+    s2.rtt = std::chrono::microseconds(70);
+    s2.send_queue_bytes = 20;
+    s2.recv_queue_bytes = 5;
+    WHEN ("the samples are accumulated") {
+      auto tot = detail::accumulate_tcp_kernel_stats(
+                   detail::accumulate_tcp_kernel_stats(tcp_kernel_stats { }, s1), s2);
+      THEN ("sizes are summed and the maximum round trip time is kept") {
+        REQUIRE (tot.rtt == std::chrono::microseconds(70));
+        REQUIRE (tot.send_queue_bytes == 30);
+        REQUIRE (tot.recv_queue_bytes == 5);
+        REQUIRE (tot.total_retrans == 1);
+      }
+    }
+  } // end given
+}
+
+#ifdef __linux__
+
+SCENARIO ( "Testing tcp_kernel_stats sampling on a loopback connection",
+           "[tcp_kernel_stats]" ) {
+
+  using namespace std::experimental::net;
+
+  io_context ioc;
+  ip::tcp::acceptor acc(ioc, ip::tcp::endpoint(ip::address_v4::loopback(), 0));
+  ip::tcp::socket cli(ioc);
+  cli.connect(acc.local_endpoint());
+  auto srv = acc.accept();
+
+  GIVEN ("A connected TCP socket pair") {
+    WHEN ("data is written but not read by the peer") {
+      std::vector<char> data(1000, 'x');
+      write(cli, const_buffer(data.data(), data.size()));
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      std::error_code ec;
+      auto srv_st = chops::net::detail::sample_tcp_kernel_stats(srv.native_handle(), ec);
+      REQUIRE_FALSE (ec);
+      auto cli_st = chops::net::detail::sample_tcp_kernel_stats(cli.native_handle(), ec);
+      REQUIRE_FALSE (ec);
+      THEN ("the receive queue holds the unread data") {
+        REQUIRE (srv_st.recv_queue_bytes == data.size());
+        REQUIRE (cli_st.snd_cwnd > 0);
+        REQUIRE (cli_st.rtt.count() > 0);
+      }
+    }
+    AND_WHEN ("the socket is not a TCP socket") {
+      std::error_code ec;
+      chops::net::detail::sample_tcp_kernel_stats(-1, ec);
+      THEN ("an error is returned") {
+        REQUIRE (ec);
+      }
+    }
+  } // end given
+}
+
+#endif
\ No newline at end of file
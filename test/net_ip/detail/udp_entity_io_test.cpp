@@ -31,6 +31,7 @@
 #include <thread>
 #include <future>
 #include <chrono>
+#include <atomic>
 #include <vector>
 #include <functional> // std::ref, std::cref
 
@@ -39,12 +40,14 @@
 #include "net_ip/net_entity.hpp"
 #include "net_ip/io_interface.hpp"
 #include "net_ip/endpoints_resolver.hpp"
+#include "net_ip/spsc_msg_ring.hpp"
 
 #include "net_ip/component/worker.hpp"
 #include "net_ip/component/send_to_all.hpp"
 
 #include "net_ip/shared_utility_test.hpp"
 #include "net_ip/shared_utility_func_test.hpp"
+#include "net_ip/perf_counters.hpp"
 
 #include "utility/shared_buffer.hpp"
 #include "utility/repeat.hpp"
@@ -65,6 +68,19 @@ constexpr int NumMsgs = 50;
 // Catch test framework is not thread-safe, therefore all REQUIRE clauses must be in a single 
 // thread;
 
+// starts the IO handler, returning the io_interface passed to the state change callback
+chops::net::udp_io_interface start_udp_entity_io(chops::net::detail::udp_entity_io_ptr iohp) {
+  auto start_prom = std::make_shared<std::promise<chops::net::udp_io_interface>>();
+  auto start_fut = start_prom->get_future();
+  iohp->start([start_prom] (chops::net::udp_io_interface io, std::size_t, bool starting) {
+                if (starting) {
+                  start_prom->set_value(io);
+                }
+              },
+              [] (chops::net::udp_io_interface, std::error_code) { } );
+  return start_fut.get();
+}
+
 void start_udp_senders(const vec_buf& in_msg_vec, bool reply, int interval, int num_senders,
                        test_counter& send_cnt, io_context& ioc, 
                        chops::net::err_wait_q& err_wq, const ip::udp::endpoint& recv_endp) {
@@ -111,6 +127,7 @@ std::cerr << "****** Senders total output queue size: " << qs.output_queue_size
 
 void udp_test (const vec_buf& in_msg_vec, bool reply, int interval, int num_senders) {
 
+  chops::test::perf_counters pc; // before the worker thread starts, to include it
   chops::net::worker wk;
   wk.start();
   auto& ioc = wk.get_io_context();
@@ -141,6 +158,7 @@ void udp_test (const vec_buf& in_msg_vec, bool reply, int interval, int num_send
 
         test_counter send_cnt = 0;
 
+        pc.start();
         INFO ("Starting first iteration of UDP senders, num: " << num_senders);
         start_udp_senders(in_msg_vec, reply, interval, num_senders,
                           send_cnt, ioc, err_wq, recv_endp);
@@ -149,6 +167,9 @@ void udp_test (const vec_buf& in_msg_vec, bool reply, int interval, int num_send
                           send_cnt, ioc, err_wq, recv_endp);
 
 
+        pc.stop();
+        pc.report(std::cerr, "udp_entity_io", 2 * num_senders * in_msg_vec.size());
+
         INFO ("Stopping receiver");
         recv_ptr->stop();
         recv_io_futs.stop_fut.get();
@@ -289,3 +310,212 @@ SCENARIO ( "Udp IO handler test, LF msgs, two-way, interval 50, senders 2, many
 }
 
 
+
+SCENARIO ( "Udp IO handler test, kernel drop counts and receive buffer autotuning",
+           "[udp_io] [rx_stats]" ) {
+
+  chops::net::worker wk;
+  wk.start();
+  auto& ioc = wk.get_io_context();
+
+  GIVEN ("A UDP receiver with a small receive buffer") {
+    auto recv_endp = make_udp_endpoint(test_addr, test_port_base + 50);
+    auto iohp = std::make_shared<chops::net::detail::udp_entity_io>(ioc, recv_endp);
+    auto io = start_udp_entity_io(iohp);
+    io.get_socket().set_option(socket_base::receive_buffer_size(4096));
+    auto init_size = io.get_udp_rx_stats().rcvbuf_size;
+
+    ip::udp::socket sender(ioc, ip::udp::endpoint(ip::udp::v4(), 0));
+    std::vector<char> dgram(512, 'D');
+
+    WHEN ("datagrams overflow the receive buffer before reads start") {
+      REQUIRE (io.enable_rcvbuf_autotune(1024u * 1024u));
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      chops::repeat(200, [&] () { sender.send_to(const_buffer(dgram.data(), dgram.size()), recv_endp); } );
+      auto st = io.get_udp_rx_stats();
+      THEN ("the drops are counted, and the buffer grows once the drop counter is sampled") {
+        REQUIRE (st.drops > 0u);
+        REQUIRE (st.rcvbuf_grows == 0u);
+        std::atomic<int> num_read { 0 };
+        io.start_io(1024u, [&num_read] (const_buffer, chops::net::udp_io_interface, 
+                                        ip::udp::endpoint) { ++num_read; return true; } );
+        // paced, so that no more datagrams are dropped
+        chops::repeat(300, [&] () {
+            sender.send_to(const_buffer(dgram.data(), dgram.size()), recv_endp);
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+          }
+        );
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        st = io.get_udp_rx_stats();
+        REQUIRE (num_read >= 256);
+        REQUIRE (st.rcvbuf_grows == 1u);
+        REQUIRE (st.rcvbuf_size > init_size);
+      }
+    }
+    AND_WHEN ("datagrams overflow the receive buffer before reads into an SPSC ring start") {
+      REQUIRE (io.enable_rcvbuf_autotune(1024u * 1024u));
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      chops::repeat(200, [&] () { sender.send_to(const_buffer(dgram.data(), dgram.size()), recv_endp); } );
+      THEN ("the buffer also grows when reading into the ring") {
+        REQUIRE (io.get_udp_rx_stats().drops > 0u);
+        // large enough that the ring is never full, so no consumer is needed
+        chops::net::spsc_msg_ring<ip::udp::endpoint> ring(512u, 1024u);
+        REQUIRE (io.start_io(ring));
+        chops::repeat(300, [&] () {
+            sender.send_to(const_buffer(dgram.data(), dgram.size()), recv_endp);
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+          }
+        );
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        auto st = io.get_udp_rx_stats();
+        REQUIRE (ring.size() >= 256u);
+        REQUIRE (st.rcvbuf_grows == 1u);
+        REQUIRE (st.rcvbuf_size > init_size);
+        iohp->stop(); // before the ring goes out of scope
+      }
+    }
+    iohp->stop();
+  } // end given
+
+  wk.reset();
+}
+
+SCENARIO ( "Udp IO handler test, one buffer sent to many destinations",
+           "[udp_io] [send_to_many]" ) {
+
+  chops::net::worker wk;
+  wk.start();
+  auto& ioc = wk.get_io_context();
+
+  GIVEN ("A UDP sender and three receiving sockets, each listed 40 times") {
+    std::vector<ip::udp::socket> receivers;
+    std::vector<ip::udp::endpoint> endps;
+    chops::repeat(3, [&] () { 
+        receivers.emplace_back(ioc, ip::udp::endpoint(ip::address_v4::loopback(), 0));
+      }
+    );
+    chops::repeat(40, [&] () {
+        for (const auto& r : receivers) {
+          endps.push_back(r.local_endpoint());
+        }
+      }
+    );
+    auto iohp = std::make_shared<chops::net::detail::udp_entity_io>(ioc, ip::udp::endpoint());
+    auto io = start_udp_entity_io(iohp);
+    REQUIRE (io.start_io());
+
+    WHEN ("a buffer is sent to all of the endpoints, twice") {
+      auto ba = chops::make_byte_array(0x0D, 0x0E, 0x0A, 0x0D);
+      chops::const_shared_buffer buf(ba.data(), ba.size());
+      io.send_to_many(buf, endps);
+      io.send_to_many(buf, endps.cbegin(), endps.cend());
+      THEN ("each receiver gets 80 datagrams") {
+        for (auto& r : receivers) {
+          int cnt = 0;
+          std::byte b[8];
+          while (cnt < 80) {
+            auto nb = r.receive(mutable_buffer(b, sizeof(b)));
+            REQUIRE (nb == ba.size());
+            ++cnt;
+          }
+          REQUIRE (r.available() == 0u);
+        }
+      }
+    }
+    iohp->stop();
+  } // end given
+
+  wk.reset();
+}
+
+SCENARIO ( "Udp IO handler test, send to many skips a bad destination",
+           "[udp_io] [send_to_many]" ) {
+
+  chops::net::worker wk;
+  wk.start();
+  auto& ioc = wk.get_io_context();
+
+  GIVEN ("An IPv4 UDP sender, two receiving sockets, and an IPv6 endpoint between them") {
+    ip::udp::socket recv1(ioc, ip::udp::endpoint(ip::address_v4::loopback(), 0));
+    ip::udp::socket recv2(ioc, ip::udp::endpoint(ip::address_v4::loopback(), 0));
+    std::vector<ip::udp::endpoint> endps { 
+        ip::udp::endpoint(ip::address_v6::loopback(), recv1.local_endpoint().port()),
+        recv1.local_endpoint(),
+        ip::udp::endpoint(ip::address_v6::loopback(), recv2.local_endpoint().port()),
+        recv2.local_endpoint()
+    };
+    auto iohp = std::make_shared<chops::net::detail::udp_entity_io>(ioc, ip::udp::endpoint());
+    std::atomic<int> err_cnt { 0 };
+    auto start_prom = std::make_shared<std::promise<chops::net::udp_io_interface>>();
+    auto start_fut = start_prom->get_future();
+    iohp->start([start_prom] (chops::net::udp_io_interface io, std::size_t, bool starting) {
+                  if (starting) {
+                    start_prom->set_value(io);
+                  }
+                },
+                [&err_cnt] (chops::net::udp_io_interface, std::error_code) { ++err_cnt; } );
+    auto io = start_fut.get();
+    REQUIRE (io.start_io());
+
+    WHEN ("a buffer is sent to all of the endpoints, then sent once more to the first receiver") {
+      auto ba = chops::make_byte_array(0x0B, 0x0A, 0x0D);
+      chops::const_shared_buffer buf(ba.data(), ba.size());
+      io.send_to_many(buf, endps);
+      io.send(buf, recv1.local_endpoint());
+      THEN ("the bad destinations are reported and the rest of the sends are not cancelled") {
+        std::byte b[8];
+        REQUIRE (recv1.receive(mutable_buffer(b, sizeof(b))) == ba.size());
+        REQUIRE (recv2.receive(mutable_buffer(b, sizeof(b))) == ba.size());
+        REQUIRE (recv1.receive(mutable_buffer(b, sizeof(b))) == ba.size());
+        REQUIRE (err_cnt == 2);
+        REQUIRE (iohp->is_io_started());
+      }
+    }
+    iohp->stop();
+  } // end given
+
+  wk.reset();
+}
+
+SCENARIO ( "Udp IO handler test, composite header and shared body sends",
+           "[udp_io] [composite_send]" ) {
+
+  chops::net::worker wk;
+  wk.start();
+  auto& ioc = wk.get_io_context();
+
+  GIVEN ("A UDP sender and two receiving sockets, and a body shared by all datagrams") {
+    ip::udp::socket recv1(ioc, ip::udp::endpoint(ip::address_v4::loopback(), 0));
+    ip::udp::socket recv2(ioc, ip::udp::endpoint(ip::address_v4::loopback(), 0));
+    auto iohp = std::make_shared<chops::net::detail::udp_entity_io>(ioc, ip::udp::endpoint());
+    auto io = start_udp_entity_io(iohp);
+    REQUIRE (io.start_io(recv2.local_endpoint()));
+
+    WHEN ("headers and the body are sent, each pair as one datagram") {
+      auto body_ba = chops::make_byte_array(0x0B, 0x0B, 0x0B, 0x0B, 0x0B, 0x0B);
+      chops::const_shared_buffer body(body_ba.data(), body_ba.size());
+      for (int i = 0; i < 50; ++i) {
+        auto hdr_ba = chops::make_byte_array(static_cast<unsigned char>(i), 0x0A);
+        chops::const_shared_buffer hdr(hdr_ba.data(), hdr_ba.size());
+        io.send(hdr, body, recv1.local_endpoint());
+        io.send(chops::net::shared_buffer_parts { hdr, body }); // default destination
+      }
+      THEN ("each receiver gets 50 datagrams, each with its header followed by the body") {
+        for (auto* r : { &recv1, &recv2 }) {
+          for (int i = 0; i < 50; ++i) {
+            std::byte b[16];
+            auto nb = r->receive(mutable_buffer(b, sizeof(b)));
+            REQUIRE (nb == 2u + body_ba.size());
+            REQUIRE (static_cast<int>(b[0]) == i);
+            REQUIRE (b[1] == std::byte(0x0A));
+            REQUIRE (b[2] == std::byte(0x0B));
+            REQUIRE (b[nb-1] == std::byte(0x0B));
+          }
+        }
+      }
+    }
+    iohp->stop();
+  } // end given
+
+  wk.reset();
+}
@@ -226,6 +226,62 @@ std::cerr << "UDP senders total output queue size: " << qs.output_queue_size <<
 }
 
 
+SCENARIO ( "Net IP test, parallel abortive stop of an acceptor with many connections",
+           "[net_ip] [stop_all_async]" ) {
+
+  chops::net::worker wk;
+  wk.start();
+  auto& ioc = wk.get_io_context();
+
+  GIVEN ("An acceptor with a number of connected clients") {
+    constexpr int num_clients = 20;
+    chops::net::net_ip nip(ioc);
+    auto acc = nip.make_tcp_acceptor(ip::tcp::endpoint(ip::address_v4::loopback(), 30467));
+
+    std::promise<void> all_conn_prom;
+    auto all_conn_fut = all_conn_prom.get_future();
+    acc.start([&all_conn_prom] (chops::net::tcp_io_interface io, std::size_t num, bool starting) {
+        if (starting) {
+          io.start_io(1, [] (const_buffer, chops::net::tcp_io_interface, ip::tcp::endpoint) {
+              return true;
+            }
+          );
+          if (num == num_clients) {
+            all_conn_prom.set_value();
+          }
+        }
+      },
+      [] (chops::net::tcp_io_interface, std::error_code) { }
+    );
+
+    std::vector<ip::tcp::socket> clients;
+    chops::repeat(num_clients, [&] () {
+        clients.emplace_back(ioc);
+        clients.back().connect(ip::tcp::endpoint(ip::address_v4::loopback(), 30467));
+      }
+    );
+    all_conn_fut.get();
+
+    WHEN ("stop_all_async is called with an abortive close") {
+      auto fut = nip.stop_all_async(true);
+      THEN ("the future becomes ready and each client sees a connection reset") {
+        REQUIRE (fut.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+        REQUIRE_FALSE (acc.is_started());
+        for (auto& c : clients) {
+          char ch;
+          std::error_code ec;
+          c.read_some(mutable_buffer(&ch, 1), ec);
+          REQUIRE (ec == std::errc::connection_reset);
+        }
+        REQUIRE (nip.stop_all_async().wait_for(std::chrono::seconds(5)) == 
+                 std::future_status::ready);
+      }
+    }
+    nip.remove_all();
+  } // end given
+  wk.reset();
+}
+
 SCENARIO ( "Net IP test, var len msgs, one-way, interval 50, 1 connector or pair", 
            "[netip_acc_conn] [var_len_msg] [one_way] [interval_50] [connectors_1]" ) {
 
@@ -0,0 +1,253 @@
+/** @file
+ *
+ *  @ingroup test_module
+ *
+ *  @brief Test scenarios for the packet ring receive engine.
+ *
+ *  The live scenario needs the @c CAP_NET_RAW capability, it is skipped (with a
+ *  warning) otherwise, before any worker thread is started.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2018 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch.hpp"
+
+#include <experimental/internet>
+#include <experimental/socket>
+#include <experimental/io_context>
+#include <experimental/buffer>
+
+#include <system_error> // std::error_code
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint8_t, std::uint32_t
+#include <memory> // std::make_shared
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "net_ip/packet_ring.hpp"
+#include "net_ip/socket_filter.hpp"
+#include "net_ip/detail/udp_entity_io.hpp"
+#include "net_ip/component/worker.hpp"
+#include "net_ip/io_interface.hpp"
+
+#include "net_ip/shared_utility_test.hpp"
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <unistd.h> // close
+#endif
+
+using namespace std::chrono_literals;
+
+// run a packet ring filter over an IPv4 packet, only the instructions the filter uses
+std::uint32_t run_filter(const chops::net::socket_filter& filt, const std::vector<std::uint8_t>& pkt) {
+  using namespace chops::net::detail;
+  auto ld = [&pkt] (std::size_t off, std::size_t sz) {
+    std::uint32_t v = 0u;
+    for (std::size_t i = 0u; i < sz; ++i) {
+      v = (v << 8u) | pkt.at(off + i);
+    }
+    return v;
+  };
+  std::uint32_t a = 0u;
+  std::uint32_t x = 0u;
+  for (std::size_t pc = 0u; pc < filt.size(); ++pc) {
+    const auto& in = filt[pc];
+    switch (in.code) {
+      case bpf_ld_b_abs: a = ld(in.k, 1u); break;
+      case bpf_ld_h_abs: a = ld(in.k, 2u); break;
+      case bpf_ld_w_abs: a = ld(in.k, 4u); break;
+      case 0xb1: x = (pkt.at(in.k) & 0x0fu) * 4u; break; // BPF_LDX | BPF_B | BPF_MSH
+      case 0x48: a = ld(x + in.k, 2u); break; // BPF_LD | BPF_H | BPF_IND
+      case bpf_jeq_k: pc += (a == in.k) ? in.jt : in.jf; break;
+      case 0x45: pc += (a & in.k) ? in.jt : in.jf; break; // BPF_JMP | BPF_JSET | BPF_K
+      case bpf_ret_k: return in.k;
+      default: FAIL ("unexpected filter instruction"); break;
+    }
+  }
+  FAIL ("filter ran past its end");
+  return 0u;
+}
+
+// a minimal IPv4 UDP packet, frag_field is the flags and fragment offset field
+std::vector<std::uint8_t> make_ip_udp_packet(std::uint32_t dest, std::uint16_t port,
+                                             std::uint16_t frag_field) {
+  std::vector<std::uint8_t> pkt(28u, 0u);
+  pkt[0] = 0x45u; // version 4, header length 20
+  pkt[6] = static_cast<std::uint8_t>(frag_field >> 8u);
+  pkt[7] = static_cast<std::uint8_t>(frag_field & 0xffu);
+  pkt[9] = 17u; // UDP
+  for (int i = 0; i < 4; ++i) {
+    pkt[16 + i] = static_cast<std::uint8_t>(dest >> (24 - 8 * i));
+  }
+  pkt[22] = static_cast<std::uint8_t>(port >> 8u);
+  pkt[23] = static_cast<std::uint8_t>(port & 0xffu);
+  return pkt;
+}
+
+bool can_open_packet_socket() {
+#ifdef __linux__
+  int fd = ::socket(AF_PACKET, SOCK_DGRAM, 0);
+  if (fd < 0) {
+    return false;
+  }
+  ::close(fd);
+  return true;
+#else
+  return false;
+#endif
+}
+
+SCENARIO ( "Building a packet ring filter", "[packet_ring]" ) {
+
+  using namespace chops::net::detail;
+
+  GIVEN ("A port and a set of destination addresses") {
+    std::vector<std::experimental::net::ip::address_v4> addrs {
+      std::experimental::net::ip::make_address_v4("239.1.1.1"),
+      std::experimental::net::ip::make_address_v4("239.1.1.2")
+    };
+    WHEN ("the filter is built") {
+      auto filt = make_packet_ring_filter(30993, addrs);
+      THEN ("the jumps land on the port check and the reject instruction") {
+        REQUIRE (filt.size() == 12u);
+        REQUIRE (filt[1].jf == 9u);        // not UDP
+        REQUIRE (filt[3].jt == 7u);        // fragment
+        REQUIRE (filt[4].k == 16u);        // destination address load
+        REQUIRE (filt[5].jt == 1u);        // first address matches
+        REQUIRE (filt[6].jf == 4u);        // no address matches
+        REQUIRE (filt[9].k == 30993u);
+        REQUIRE (filt[11].k == bpf_reject);
+      }
+      AND_THEN ("only unfragmented datagrams to the port and addresses are accepted") {
+        auto addr = addrs[1].to_uint();
+        REQUIRE (run_filter(filt, make_ip_udp_packet(addr, 30993, 0x4000u)) == bpf_accept);
+        REQUIRE (run_filter(filt, make_ip_udp_packet(addr, 30993, 0x2000u)) == bpf_reject);
+        REQUIRE (run_filter(filt, make_ip_udp_packet(addr, 30993, 0x00b9u)) == bpf_reject);
+        REQUIRE (run_filter(filt, make_ip_udp_packet(addr, 30994, 0u)) == bpf_reject);
+        REQUIRE (run_filter(filt, make_ip_udp_packet(addr + 1u, 30993, 0u)) == bpf_reject);
+      }
+    }
+    AND_WHEN ("the filter is built without addresses") {
+      auto filt = make_packet_ring_filter(30993, { });
+      THEN ("only the protocol, fragment and port are checked") {
+        REQUIRE (filt.size() == 9u);
+        REQUIRE (filt[1].jf == 6u);
+        REQUIRE (filt[6].k == 30993u);
+      }
+    }
+    AND_WHEN ("the filter is built with the maximum number of addresses and with one more") {
+      std::vector<std::experimental::net::ip::address_v4> many;
+      for (std::uint32_t i = 0u; i < chops::net::max_packet_ring_dest_addrs; ++i) {
+        many.push_back(std::experimental::net::ip::address_v4(0xef010000u + i));
+      }
+      auto filt = make_packet_ring_filter(30993, many);
+      many.push_back(std::experimental::net::ip::address_v4(0xef01ffffu));
+      auto too_many = make_packet_ring_filter(30993, many);
+      THEN ("the jumps still reach the reject instruction, and too many addresses fail") {
+        REQUIRE (filt.size() == 9u + chops::net::max_packet_ring_dest_addrs + 1u);
+        REQUIRE (2u + filt[1].jf == filt.size() - 1u);
+        REQUIRE (run_filter(filt, make_ip_udp_packet(0xef010000u + 247u, 30993, 0u)) == bpf_accept);
+        REQUIRE (run_filter(filt, make_ip_udp_packet(0xef01ffffu, 30993, 0u)) == bpf_reject);
+        REQUIRE (too_many.empty());
+      }
+    }
+  } // end given
+}
+
+SCENARIO ( "Receiving datagrams through a packet ring on the loopback interface",
+           "[packet_ring]" ) {
+
+  using namespace std::experimental::net;
+
+  if (!can_open_packet_socket()) {
+    WARN ("Packet ring scenario skipped, CAP_NET_RAW is needed");
+    return;
+  }
+
+  chops::net::worker wk;
+  wk.start();
+  auto& ioc = wk.get_io_context();
+
+  // bound to an ephemeral port, the ring filters on the port actually bound
+  auto ioh = std::make_shared<chops::net::detail::udp_entity_io>(ioc, 
+                 chops::test::make_udp_endpoint("127.0.0.1", 0));
+  std::mutex mut;
+  std::vector<std::error_code> errs;
+  REQUIRE (ioh->start([] (chops::net::udp_io_interface, std::size_t, bool) { },
+                      [&] (chops::net::udp_io_interface, std::error_code e) {
+                        std::lock_guard<std::mutex> gd { mut };
+                        errs.push_back(e);
+                      }));
+  auto recv_endp = ioh->get_socket().local_endpoint();
+  REQUIRE (recv_endp.port() != 0);
+
+  GIVEN ("A UDP IO handler reading from a packet ring bound to loopback") {
+    std::vector<std::string> msgs;
+    std::vector<unsigned short> ports;
+    std::vector<std::chrono::system_clock::time_point> stamps;
+    chops::net::packet_ring_params params;
+    params.interface_name = "lo";
+    params.block_size = 1u << 16u;
+    params.num_blocks = 4u;
+    params.block_timeout = 2ms;
+    bool opened = chops::net::udp_io_interface(ioh).start_io_packet_ring(params,
+          [&] (const_buffer b, chops::net::udp_io_interface, ip::udp::endpoint endp,
+               std::chrono::system_clock::time_point ts) {
+            std::lock_guard<std::mutex> gd { mut };
+            msgs.emplace_back(static_cast<const char*>(b.data()), b.size());
+            ports.push_back(endp.port());
+            stamps.push_back(ts);
+            return true;
+          }
+    );
+    if (!opened) { // stop the worker before failing, a joinable thread must not be destroyed
+      ioh->stop();
+      wk.reset();
+      FAIL ("Packet ring could not be opened");
+    }
+
+    WHEN ("datagrams are sent to the UDP port and to another port") {
+      ip::udp::socket sender(ioc, chops::test::make_udp_endpoint("127.0.0.1", 30994));
+      std::vector<std::string> expected;
+      for (int i = 0; i < 50; ++i) {
+        expected.push_back("datagram " + std::to_string(i));
+        sender.send_to(const_buffer(expected.back().data(), expected.back().size()), recv_endp);
+        sender.send_to(buffer("ignored"), chops::test::make_udp_endpoint("127.0.0.1", 30995));
+      }
+      THEN ("only the datagrams to the UDP port are delivered, in order") {
+        auto start = std::chrono::steady_clock::now();
+        while (std::chrono::steady_clock::now() - start < 2s) {
+          {
+            std::lock_guard<std::mutex> gd { mut };
+            if (msgs.size() >= expected.size()) {
+              break;
+            }
+          }
+          std::this_thread::sleep_for(5ms);
+        }
+        std::lock_guard<std::mutex> gd { mut };
+        REQUIRE (msgs == expected);
+        REQUIRE (ports == std::vector<unsigned short>(expected.size(), 30994));
+        for (auto ts : stamps) {
+          REQUIRE (ts.time_since_epoch().count() > 0);
+        }
+        // the reject all filter on the UDP socket is not replaced while reading the ring
+        REQUIRE_FALSE (chops::net::udp_io_interface(ioh).set_socket_filter(
+                         chops::net::make_value_match_filter(0, 1, { 0x64u })));
+      }
+    }
+  } // end given
+
+  ioh->stop();
+  wk.reset();
+}
@@ -0,0 +1,131 @@
+/** @file
+ *
+ *  @ingroup test_module
+ *
+ *  @brief Test scenarios for socket filter building and attaching.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2018 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch.hpp"
+
+#include <experimental/internet>
+#include <experimental/socket>
+#include <experimental/io_context>
+#include <experimental/buffer>
+
+#include <system_error> // std::error_code
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint32_t
+#include <memory> // std::make_shared
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <vector>
+
+#include "net_ip/socket_filter.hpp"
+#include "net_ip/detail/udp_entity_io.hpp"
+#include "net_ip/component/worker.hpp"
+#include "net_ip/io_interface.hpp"
+#include "net_ip/net_entity.hpp"
+
+#include "net_ip/shared_utility_test.hpp"
+
+using namespace std::chrono_literals;
+
+SCENARIO ( "Building socket filters", "[socket_filter]" ) {
+
+  GIVEN ("Byte match and value match filter parameters") {
+    WHEN ("a 7 byte match filter is built") {
+      const char bytes[] = "ABCDEFG";
+      auto filt = chops::net::make_byte_match_filter(2, bytes, 7);
+      THEN ("there is a load and compare for the 4, 2, and 1 byte slices, then accept and reject") {
+        REQUIRE (filt.size() == 8u);
+        REQUIRE (filt[0].code == chops::net::detail::bpf_ld_w_abs);
+        REQUIRE (filt[0].k == 10u); // UDP header plus offset
+        REQUIRE (filt[1].k == 0x41424344u);
+        REQUIRE (filt[1].jf == 5u);
+        REQUIRE (filt[2].code == chops::net::detail::bpf_ld_h_abs);
+        REQUIRE (filt[2].k == 14u);
+        REQUIRE (filt[3].k == 0x4546u);
+        REQUIRE (filt[4].code == chops::net::detail::bpf_ld_b_abs);
+        REQUIRE (filt[5].k == 0x47u);
+        REQUIRE (filt[5].jf == 1u);
+        REQUIRE (filt[6].k == chops::net::detail::bpf_accept);
+        REQUIRE (filt[7].k == chops::net::detail::bpf_reject);
+      }
+    }
+    AND_WHEN ("a value match filter is built") {
+      auto filt = chops::net::make_value_match_filter(0, 2, { 7u, 9u, 11u });
+      THEN ("each comparison jumps to the accept instruction") {
+        REQUIRE (filt.size() == 6u);
+        REQUIRE (filt[0].code == chops::net::detail::bpf_ld_h_abs);
+        REQUIRE (filt[1].jt == 3u);
+        REQUIRE (filt[3].jt == 1u);
+        REQUIRE (filt[5].k == chops::net::detail::bpf_accept);
+      }
+    }
+    AND_WHEN ("invalid parameters are provided") {
+      THEN ("the filters are empty") {
+        REQUIRE (chops::net::make_byte_match_filter(0, "", 0).empty());
+        REQUIRE (chops::net::make_value_match_filter(0, 3, { 1u }).empty());
+        REQUIRE (chops::net::make_value_match_filter(0, 4, std::vector<std::uint32_t>()).empty());
+      }
+    }
+  } // end given
+}
+
+SCENARIO ( "Attaching a socket filter to a UDP entity", "[socket_filter]" ) {
+
+  using namespace std::experimental::net;
+
+  chops::net::worker wk;
+  wk.start();
+  auto& ioc = wk.get_io_context();
+
+  auto recv_endp = chops::test::make_udp_endpoint("127.0.0.1", 30991);
+  auto ioh = std::make_shared<chops::net::detail::udp_entity_io>(ioc, recv_endp);
+  chops::net::udp_net_entity ent(ioh);
+
+  std::mutex mut;
+  std::vector<unsigned char> ids;
+
+  GIVEN ("A UDP entity with a filter accepting two channel ids, set before start") {
+    REQUIRE (ent.set_socket_filter(chops::net::make_value_match_filter(1, 1, { 2u, 5u })));
+    REQUIRE (ent.start([&] (chops::net::udp_io_interface io, std::size_t, bool starting) {
+          if (starting) {
+            io.start_io(64, [&] (const_buffer b, chops::net::udp_io_interface, ip::udp::endpoint) {
+                std::lock_guard<std::mutex> gd { mut };
+                ids.push_back(static_cast<const unsigned char*>(b.data())[1]);
+                return true;
+              }
+            );
+          }
+        },
+        [] (chops::net::udp_io_interface, std::error_code) { }));
+
+    WHEN ("datagrams with various channel ids are sent") {
+      ip::udp::socket sender(ioc, ip::udp::v4());
+      for (unsigned char id = 0; id < 8; ++id) {
+        unsigned char msg[] = { 0xAA, id, 0x55 };
+        sender.send_to(const_buffer(msg, sizeof(msg)), recv_endp);
+      }
+      unsigned char shrt[] = { 0xAA }; // too short to contain a channel id
+      sender.send_to(const_buffer(shrt, sizeof(shrt)), recv_endp);
+      THEN ("only the accepted channel ids reach the message handler") {
+        std::this_thread::sleep_for(200ms);
+        std::lock_guard<std::mutex> gd { mut };
+        REQUIRE (ids == std::vector<unsigned char> { 2u, 5u });
+      }
+    }
+  } // end given
+
+  ent.stop();
+  wk.reset();
+}
@@ -0,0 +1,103 @@
+/** @file
+ *
+ *  @ingroup test_module
+ *
+ *  @brief Test scenarios for socket handle handoff and net entities created from
+ *  inherited handles.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2018 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch.hpp"
+
+#include <experimental/internet>
+#include <experimental/socket>
+#include <experimental/io_context>
+
+#include <system_error> // std::error_code
+#include <cstddef> // std::size_t
+#include <memory> // std::make_shared
+#include <string>
+#include <future>
+#include <vector>
+
+#include "net_ip/socket_handoff.hpp"
+#include "net_ip/detail/tcp_acceptor.hpp"
+#include "net_ip/detail/udp_entity_io.hpp"
+#include "net_ip/component/worker.hpp"
+#include "net_ip/io_interface.hpp"
+
+using namespace std::experimental::net;
+
+const char* handoff_path = "/tmp/chops_socket_handoff_test.sock";
+
+SCENARIO ( "Socket handoff test, listening and UDP sockets passed to a successor",
+           "[socket_handoff]" ) {
+
+  chops::net::worker wk;
+  wk.start();
+  auto& ioc = wk.get_io_context();
+
+  GIVEN ("A listening TCP socket and a bound UDP socket") {
+    ip::tcp::acceptor old_acc(ioc, ip::tcp::endpoint(ip::address_v4::loopback(), 0));
+    ip::udp::socket old_udp(ioc, ip::udp::endpoint(ip::address_v4::loopback(), 0));
+    auto acc_endp = old_acc.local_endpoint();
+    auto udp_endp = old_udp.local_endpoint();
+
+    WHEN ("the handles are exported and imported") {
+      std::error_code exp_ec;
+      auto exp_fut = std::async(std::launch::async, [&] () {
+          return chops::net::export_socket_handles(handoff_path,
+                   std::vector<int> { old_acc.native_handle(), old_udp.native_handle() },
+                   exp_ec);
+        }
+      );
+      std::vector<int> handles;
+      std::error_code imp_ec;
+      do { // wait for the exporter to listen
+        imp_ec.clear();
+        handles = chops::net::import_socket_handles(handoff_path, imp_ec);
+      } while (imp_ec);
+      REQUIRE (exp_fut.get());
+      REQUIRE (handles.size() == 2u);
+
+      THEN ("net entities created from the handles use the same endpoints") {
+        auto acc_ptr = std::make_shared<chops::net::detail::tcp_acceptor>(ioc, handles[0]);
+        auto udp_ptr = std::make_shared<chops::net::detail::udp_entity_io>(ioc, handles[1]);
+
+        std::promise<std::size_t> conn_prom;
+        auto conn_fut = conn_prom.get_future();
+        REQUIRE (acc_ptr->start(
+            [&conn_prom] (chops::net::tcp_io_interface, std::size_t n, bool starting) {
+              if (starting) {
+                conn_prom.set_value(n);
+              }
+            },
+            [] (chops::net::tcp_io_interface, std::error_code) { } ));
+        REQUIRE (acc_ptr->get_socket().local_endpoint() == acc_endp);
+        REQUIRE (udp_ptr->start(
+            [] (chops::net::udp_io_interface, std::size_t, bool) { },
+            [] (chops::net::udp_io_interface, std::error_code) { } ));
+        REQUIRE (udp_ptr->get_socket().local_endpoint() == udp_endp);
+
+        // the old acceptor no longer accepts, so the connect goes to the new acceptor
+        old_acc.close();
+        ip::tcp::socket client(ioc);
+        client.connect(acc_endp);
+        REQUIRE (conn_fut.get() == 1u);
+
+        acc_ptr->stop();
+        udp_ptr->stop();
+      }
+    }
+  } // end given
+
+  wk.reset();
+}
+
@@ -0,0 +1,185 @@
+/** @file
+ *
+ *  @ingroup test_module
+ *
+ *  @brief Test scenarios for @c spsc_msg_ring class template, including TCP and UDP
+ *  IO handlers reading directly into a ring.
+ *
+ *  @author Cliff Green
+ *
+ *  Copyright (c) 2018 by Cliff Green
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ *
+ */
+
+#include "catch.hpp"
+
+#include <experimental/internet>
+#include <experimental/socket>
+#include <experimental/io_context>
+#include <experimental/buffer>
+
+#include <system_error> // std::error_code
+#include <cstddef> // std::size_t, std::byte
+#include <memory> // std::make_shared
+#include <chrono>
+#include <thread>
+#include <string>
+#include <vector>
+
+#include "net_ip/spsc_msg_ring.hpp"
+#include "net_ip/io_interface.hpp"
+#include "net_ip/component/worker.hpp"
+#include "net_ip/component/simple_variable_len_msg_frame.hpp"
+
+#include "net_ip/shared_utility_test.hpp"
+
+using namespace std::experimental::net;
+using namespace chops::test;
+
+std::string to_string(const_buffer buf) {
+  return std::string(static_cast<const char*>(buf.data()), buf.size());
+}
+
+SCENARIO ( "Testing spsc_msg_ring producer and consumer operations",
+           "[spsc_msg_ring]" ) {
+
+  chops::net::spsc_msg_ring<ip::udp::endpoint> ring(3, 8);
+  auto endp = make_udp_endpoint("127.0.0.1", 30001);
+  int resumes = 0;
+  ring.set_resume_cb([&resumes] { ++resumes; });
+
+  GIVEN ("A ring with the number of slots rounded up to a power of two") {
+    REQUIRE (ring.capacity() == 4);
+    REQUIRE (ring.slot_size() == 8);
+    REQUIRE (ring.empty());
+    WHEN ("messages are published until the ring is full") {
+      for (int i = 0; i < 4; ++i) {
+        auto slot = ring.producer_slot();
+        REQUIRE (slot.size() == 8);
+        *static_cast<char*>(slot.data()) = static_cast<char>('a' + i);
+        ring.publish(1, endp);
+      }
+      THEN ("no slot is available and the producer is paused") {
+        REQUIRE (ring.full());
+        REQUIRE (ring.producer_slot().size() == 0);
+        REQUIRE (ring.pause_producer());
+        AND_THEN ("consuming resumes the producer once and returns messages in order") {
+          std::string msgs;
+          while (ring.consume([&msgs, &endp] (const_buffer b, const ip::udp::endpoint& e) {
+                                msgs += to_string(b);
+                                REQUIRE (e == endp);
+                              } )) { }
+          REQUIRE (msgs == "abcd");
+          REQUIRE (resumes == 1);
+          REQUIRE (ring.empty());
+          REQUIRE_FALSE (ring.consume([] (const_buffer, const ip::udp::endpoint&) { }));
+        }
+      }
+    }
+    AND_WHEN ("the producer pauses after a slot has been freed") {
+      ring.publish(0, endp);
+      THEN ("the producer is not paused") {
+        REQUIRE_FALSE (ring.pause_producer());
+        REQUIRE (ring.consume([] (const_buffer, const ip::udp::endpoint&) { }));
+        REQUIRE (resumes == 0);
+      }
+    }
+  } // end given
+}
+
+std::size_t decode_hdr(const std::byte* p, std::size_t) {
+  return std::to_integer<std::size_t>(*p);
+}
+
+SCENARIO ( "Testing TCP and UDP IO handlers reading into an spsc_msg_ring",
+           "[spsc_msg_ring]" ) {
+
+  chops::net::worker wk;
+  wk.start();
+  auto& ioc = wk.get_io_context();
+
+  GIVEN ("A TCP connection with one side reading framed messages into a small ring") {
+    ip::tcp::acceptor acc(ioc, ip::tcp::endpoint(ip::address_v4::loopback(), 0));
+    ip::tcp::socket client(ioc);
+    client.connect(acc.local_endpoint());
+    std::error_code notif_err;
+    auto ioh = std::make_shared<chops::net::detail::tcp_io>(acc.accept(),
+                       [&notif_err] (std::error_code e, auto) { notif_err = e; } );
+
+    chops::net::spsc_msg_ring<ip::tcp::endpoint> ring(2, 16);
+    REQUIRE (chops::net::tcp_io_interface(ioh).start_io(ring, 1,
+               chops::net::make_simple_variable_len_msg_frame(decode_hdr)));
+
+    WHEN ("more messages are sent than the ring holds") {
+      constexpr int num = 20;
+      std::string expected;
+      for (int i = 0; i < num; ++i) {
+        std::string body(static_cast<std::size_t>(i % 10 + 1), static_cast<char>('A' + i));
+        std::string msg(1, static_cast<char>(body.size()));
+        msg += body;
+        write(client, const_buffer(msg.data(), msg.size()));
+        expected += msg;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      THEN ("the ring fills, and reads resume as the consumer frees slots") {
+        REQUIRE (ring.full());
+        std::string recvd;
+        auto start = std::chrono::steady_clock::now();
+        while (recvd.size() < expected.size() &&
+               std::chrono::steady_clock::now() - start < std::chrono::seconds(5)) {
+          ring.consume([&recvd] (const_buffer b, const ip::tcp::endpoint&) {
+              recvd += to_string(b);
+            }
+          );
+        }
+        REQUIRE (recvd == expected);
+        REQUIRE_FALSE (notif_err);
+      }
+    }
+    AND_WHEN ("a message larger than a slot is sent") {
+      std::string msg(1, static_cast<char>(20));
+      msg += std::string(20, 'x');
+      write(client, const_buffer(msg.data(), msg.size()));
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      THEN ("an error is reported") {
+        REQUIRE (notif_err ==
+                 std::make_error_code(chops::net::net_ip_errc::msg_too_large_for_ring_slot));
+        REQUIRE (ring.empty());
+      }
+    }
+    ioh->close();
+  } // end given
+
+  GIVEN ("A UDP entity receiving datagrams into a ring") {
+    auto recv_endp = make_udp_endpoint("127.0.0.1", 30771);
+    auto ioh = std::make_shared<chops::net::detail::udp_entity_io>(ioc, recv_endp);
+    ioh->start([] (auto, std::size_t, bool) { }, [] (auto, std::error_code) { });
+    chops::net::spsc_msg_ring<ip::udp::endpoint> ring(8, 64);
+    REQUIRE (chops::net::udp_io_interface(ioh).start_io(ring));
+
+    WHEN ("datagrams are sent") {
+      ip::udp::socket sender(ioc, ip::udp::endpoint(ip::address_v4::loopback(), 0));
+      sender.send_to(const_buffer("one", 3), recv_endp);
+      sender.send_to(const_buffer("two", 3), recv_endp);
+      std::vector<std::string> msgs;
+      auto start = std::chrono::steady_clock::now();
+      while (msgs.size() < 2 &&
+             std::chrono::steady_clock::now() - start < std::chrono::seconds(5)) {
+        ring.consume([&msgs, &sender] (const_buffer b, const ip::udp::endpoint& e) {
+            msgs.push_back(to_string(b));
+            REQUIRE (e == sender.local_endpoint());
+          }
+        );
+      }
+      THEN ("they are consumed from the ring") {
+        REQUIRE (msgs == std::vector<std::string> { "one", "two" });
+      }
+    }
+    ioh->stop();
+  } // end given
+
+  wk.reset();
+}
\ No newline at end of file